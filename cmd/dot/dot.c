@@ -14,6 +14,7 @@
 
 #include "config.h"
 
+#include <cgraph/agxbuf.h>
 #include <cgraph/cgraph.h>
 #include <gvc/gvc.h>
 #include <gvc/gvio.h>
@@ -21,19 +22,31 @@
 #ifdef WIN32_DLL
 __declspec(dllimport) extern boolean MemTest;
 __declspec(dllimport) extern int GvExitOnUsage;
+__declspec(dllimport) extern void gvjobs_delete(GVC_t *gvc);
 /*gvc.lib cgraph.lib*/
 #else   /* not WIN32_DLL */
-#include <common/globals.h>
+#include <common/render.h>
 #endif
 
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 static GVC_t *Gvc;
 static graph_t * G;
+static const char *argv0;
 
 #ifndef _WIN32
 static void intr(int s)
@@ -92,11 +105,202 @@ static graph_t *create_test_graph(void)
     return g;
 }
 
+/* Counters reported by a "stats" request in serve mode. */
+static struct {
+    unsigned long requests;
+    unsigned long failures;
+    double parse_sec;
+    double layout_sec;
+    double render_sec;
+} Stats;
+
+static agxbuf Errors;
+
+static int collect_error(char *msg)
+{
+    agxbput(&Errors, msg);
+    return 0;
+}
+
+static double elapsed(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* Largest DOT source accepted in one serve mode request. */
+#define SERVE_MAX_REQUEST (1UL << 30)
+
+/* serve_args:
+ * Remove --serve from argv, returning the new argc and setting *serve if
+ * it was present. Also return in *format the last -T value, as serve mode
+ * renders into memory with gvRenderData rather than through the job list.
+ * Return -1 if --serve is combined with -o, as replies always go to stdout.
+ */
+static int serve_args(int argc, char **argv, bool *serve, const char **format)
+{
+    int i, j;
+    bool output = false;
+
+    *serve = false;
+    *format = "dot";
+    for (i = j = 1; i < argc; i++) {
+	if (strcmp(argv[i], "--serve") == 0) {
+	    *serve = true;
+	    continue;
+	}
+	if (strncmp(argv[i], "-T", 2) == 0) {
+	    if (argv[i][2])
+		*format = argv[i] + 2;
+	    else if (i + 1 < argc)
+		*format = argv[i + 1];
+	}
+	if (strncmp(argv[i], "-o", 2) == 0)
+	    output = true;
+	argv[j++] = argv[i];
+    }
+    argv[j] = NULL;
+    if (*serve && output)
+	return -1;
+    return j;
+}
+
+static void reply(const char *status, const char *data, size_t len)
+{
+    printf("%s %zu\n", status, len);
+    fwrite(data, 1, len, stdout);
+    fflush(stdout);
+}
+
+/* serve_one:
+ * Lay out and render one graph given as DOT source, and reply with the
+ * rendered output or the accumulated error messages.
+ */
+static void serve_one(const char *src, const char *format)
+{
+    graph_t *g;
+    char *result = NULL;
+    unsigned int length;
+    clock_t start;
+    int r;
+    bool ok = false;
+
+    Stats.requests++;
+    agxbclear(&Errors);
+    start = clock();
+    g = agmemread(src);
+    Stats.parse_sec += elapsed(start);
+    if (g) {
+	start = clock();
+	r = gvLayoutJobs(Gvc, g);
+	Stats.layout_sec += elapsed(start);
+	if (r == 0) {
+	    start = clock();
+	    ok = gvRenderData(Gvc, g, format, &result, &length) == 0;
+	    Stats.render_sec += elapsed(start);
+	    gvFreeLayout(Gvc, g);
+	}
+	agclose(g);
+    }
+    agreseterrors();
+    if (ok) {
+	reply("ok", result, length);
+    } else {
+	Stats.failures++;
+	if (agxblen(&Errors) == 0)
+	    agxbput(&Errors, "syntax error or empty input\n");
+	reply("error", agxbstart(&Errors), (size_t)agxblen(&Errors));
+    }
+    gvFreeRenderData(result);
+}
+
+/* serve:
+ * Answer requests on stdin until end of file, reusing the one context.
+ * A request is either a line holding the byte length of the DOT source
+ * that follows, or the line "stats". Each reply is a line holding "ok" or
+ * "error" and a byte length, followed by that many bytes. A malformed or
+ * truncated request ends the loop and makes serve return 1.
+ */
+static int serve(const char *format)
+{
+    char line[64];
+    char *src;
+    char *end;
+    unsigned long len;
+    agxbuf xb;
+    int rc = 0;
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    /* gvParseArgs queued an output job for -T, which gvRenderData would
+     * also render, unframed, to stdout
+     */
+    gvjobs_delete(Gvc);
+    agxbinit(&Errors, 0, NULL);
+    agseterrf(collect_error);
+    agxbinit(&xb, 0, NULL);
+    while (fgets(line, sizeof(line), stdin)) {
+	size_t n = strlen(line);
+	/* accept CRLF line ends */
+	if (n >= 2 && line[n - 2] == '\r' && line[n - 1] == '\n') {
+	    line[n - 2] = '\n';
+	    line[n - 1] = '\0';
+	}
+	if (strcmp(line, "stats\n") == 0) {
+	    agxbprint(&xb, "requests %lu\nfailures %lu\n"
+		      "parse_sec %.6f\nlayout_sec %.6f\nrender_sec %.6f\n",
+		      Stats.requests, Stats.failures, Stats.parse_sec,
+		      Stats.layout_sec, Stats.render_sec);
+	    reply("ok", agxbstart(&xb), (size_t)agxblen(&xb));
+	    agxbclear(&xb);
+	    continue;
+	}
+	/* strtoul accepts leading space and a sign, so check for a digit */
+	errno = 0;
+	len = strtoul(line, &end, 10);
+	if (!isdigit((int)line[0]) || errno == ERANGE || *end != '\n') {
+	    fprintf(stderr, "%s: malformed request header\n", argv0);
+	    rc = 1;
+	    break;
+	}
+	if (len > SERVE_MAX_REQUEST || len > SIZE_MAX - 1) {
+	    fprintf(stderr, "%s: request of %lu bytes is too large\n", argv0,
+		    len);
+	    rc = 1;
+	    break;
+	}
+	src = malloc(len + 1);
+	if (!src || fread(src, 1, len, stdin) != len) {
+	    free(src);
+	    fprintf(stderr, "%s: truncated request\n", argv0);
+	    rc = 1;
+	    break;
+	}
+	src[len] = '\0';
+	serve_one(src, format);
+	free(src);
+    }
+    agxbfree(&xb);
+    agseterrf(NULL);
+    agxbfree(&Errors);
+    return rc;
+}
+
 int main(int argc, char **argv)
 {
     graph_t *prev = NULL;
     int r, rc = 0;
+    bool serving;
+    const char *format;
 
+    argv0 = argv[0];
+    argc = serve_args(argc, argv, &serving, &format);
+    if (argc < 0) {
+	fprintf(stderr, "%s: --serve writes replies to stdout and cannot be "
+		"combined with -o\n", argv0);
+	return 1;
+    }
     Gvc = gvContextPlugins(lt_preloaded_symbols, DEMAND_LOADING);
     GvExitOnUsage = 1;
     gvParseArgs(Gvc, argc, argv);
@@ -108,7 +312,10 @@ int main(int argc, char **argv)
 #endif
 #endif
 
-    if (MemTest) {
+    if (serving) {
+	rc = serve(format);
+    }
+    else if (MemTest) {
 	while (MemTest--) {
 	    /* Create a test graph */
 	    G = create_test_graph();
@@ -32,9 +32,10 @@ int dtclose(Dt_t* dt)
 		(*dt->memoryf)(dt,(void*)dt->data,0,disc);
 	}
 
-	if(dt->type == DT_MALLOC)
+	/* a search may have left DT_FOUND set alongside the allocation type */
+	if(!(dt->type & DT_MEMORYF))
 		free(dt);
-	else if(ev == 0 && dt->type == DT_MEMORYF)
+	else if(ev == 0)
 		(*dt->memoryf)(dt, (void*)dt, 0, disc);
 
 	if(disc->eventf)
@@ -0,0 +1,827 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* binary graph files
+ *
+ * A file holds a sequence of records, one per root graph. Each record is
+ * a 16 byte header (magic, version, body size) followed by the body. All
+ * integers are unsigned 32 bit little endian, except the 64 bit body size.
+ * String references are indices into the record's string table, with
+ * NONE for a missing string. The body is laid out as
+ *
+ *   flags                      directed, strict, no_loop
+ *   strings                    count, then per string its length (top bit
+ *                              set for HTML strings), the bytes, a NUL and
+ *                              padding to a multiple of 4
+ *   name                       of the root graph
+ *   declarations               for graphs, nodes and edges in turn: count,
+ *                              then name, default and flags per attribute
+ *   graph values               one per graph attribute
+ *   nodes                      count, names, then one column of values per
+ *                              node attribute, dense or as (index, value)
+ *                              pairs
+ *   edges                      count, tail, head and key per edge, then one
+ *                              column of values per edge attribute
+ *   subgraphs                  count, then per subgraph its name, local
+ *                              declarations, graph values, member nodes,
+ *                              member edges and its own subgraphs
+ *
+ * Nodes and edges are stored in AGSEQ order, so reading a record back
+ * recreates them in the order they were created in.
+ */
+
+#include <cgraph/cghdr.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GVB_MAGIC	"\x89GVB"
+#define GVB_VERSION	1
+#define GVB_HDRSIZE	16
+#define NONE		UINT32_MAX
+#define HTMLBIT		((uint32_t)1 << 31)
+
+#define GVB_DIRECTED	1
+#define GVB_STRICT	2
+#define GVB_NOLOOP	4
+
+#define SYM_PRINT	1
+#define SYM_FIXED	2
+
+static const int Kinds[] = { AGRAPH, AGNODE, AGEDGE };
+
+/* growable output buffer */
+typedef struct {
+    char *data;
+    size_t len, cap;
+    bool failed;
+} obuf_t;
+
+static void put_bytes(obuf_t * b, const void *p, size_t n)
+{
+    if (b->failed)
+	return;
+    if (b->len + n > b->cap) {
+	size_t cap = b->cap ? b->cap : BUFSIZ;
+	char *data;
+	while (b->len + n > cap)
+	    cap *= 2;
+	if (!(data = realloc(b->data, cap))) {
+	    b->failed = true;
+	    return;
+	}
+	b->data = data;
+	b->cap = cap;
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void put_u32(obuf_t * b, uint32_t v)
+{
+    unsigned char c[4];
+
+    c[0] = (unsigned char)v;
+    c[1] = (unsigned char)(v >> 8);
+    c[2] = (unsigned char)(v >> 16);
+    c[3] = (unsigned char)(v >> 24);
+    put_bytes(b, c, sizeof(c));
+}
+
+/* writer state: the string table being built and the object order */
+typedef struct {
+    Agraph_t *g;
+    obuf_t strs;		/* serialized string table */
+    obuf_t body;		/* everything after the string table */
+    uint32_t nstrs;
+    const char **keys;		/* open addressing map from refstr to index */
+    uint32_t *vals;
+    size_t cap;
+    Agnode_t **nodes;		/* in AGSEQ order */
+    Agedge_t **edges;		/* in AGSEQ order */
+    int nnodes, nedges;
+    Agsym_t **syms[3];		/* root declarations by kind, in id order */
+    int nsyms[3];
+} writer_t;
+
+static size_t ptrhash(const char *s)
+{
+    uintptr_t h = (uintptr_t)s;
+    h ^= h >> 17;
+    h *= 0x9E3779B97F4A7C15ull & UINTPTR_MAX;
+    return (size_t)(h ^ (h >> 29));
+}
+
+/* strindex:
+ * Return the index of s in the string table, adding it if needed.
+ * s must be a refstr of the graph being written, so that equal strings
+ * are equal pointers.
+ */
+static uint32_t strindex(writer_t * w, const char *s)
+{
+    size_t i, len;
+    uint32_t hdr;
+    static const char pad[4];
+
+    if (s == NULL)
+	return NONE;
+    if ((w->nstrs + 1) * 2 > w->cap) {
+	size_t cap = w->cap ? w->cap * 2 : 1024;
+	const char **keys = calloc(cap, sizeof(char *));
+	uint32_t *vals = malloc(cap * sizeof(uint32_t));
+	if (!keys || !vals) {
+	    free(keys);
+	    free(vals);
+	    w->body.failed = true;
+	    return NONE;
+	}
+	for (i = 0; i < w->cap; i++) {
+	    size_t j;
+	    if (!w->keys[i])
+		continue;
+	    for (j = ptrhash(w->keys[i]) & (cap - 1); keys[j]; j = (j + 1) & (cap - 1))
+		;
+	    keys[j] = w->keys[i];
+	    vals[j] = w->vals[i];
+	}
+	free(w->keys);
+	free(w->vals);
+	w->keys = keys;
+	w->vals = vals;
+	w->cap = cap;
+    }
+    for (i = ptrhash(s) & (w->cap - 1); w->keys[i]; i = (i + 1) & (w->cap - 1))
+	if (w->keys[i] == s)
+	    return w->vals[i];
+
+    w->keys[i] = s;
+    w->vals[i] = w->nstrs;
+    len = strlen(s);
+    hdr = (uint32_t)len;
+    if (aghtmlstr(s))
+	hdr |= HTMLBIT;
+    put_u32(&w->strs, hdr);
+    put_bytes(&w->strs, s, len + 1);
+    put_bytes(&w->strs, pad, (4 - (len + 1) % 4) % 4);
+    return w->nstrs++;
+}
+
+/* the name of obj as a refstr, or NULL if it is anonymous */
+static char *objname(Agraph_t * g, void *obj)
+{
+    char *name = agnameof(obj);
+
+    if (name == NULL || name[0] == LOCALNAMEPREFIX)
+	return NULL;
+    (void)g;
+    return name;
+}
+
+static int seqcmpf(const void *a, const void *b)
+{
+    uint64_t x = AGSEQ(*(Agobj_t * const *)a);
+    uint64_t y = AGSEQ(*(Agobj_t * const *)b);
+    return x < y ? -1 : x > y;
+}
+
+/* position of obj in the AGSEQ ordered array objs */
+static uint32_t seqindex(void *objs, int n, void *obj)
+{
+    Agobj_t **v = objs;
+    uint64_t seq = AGSEQ(obj);
+    int lo = 0, hi = n - 1;
+
+    while (lo <= hi) {
+	int mid = lo + (hi - lo) / 2;
+	if (AGSEQ(v[mid]) < seq)
+	    lo = mid + 1;
+	else if (AGSEQ(v[mid]) > seq)
+	    hi = mid - 1;
+	else
+	    return (uint32_t)mid;
+    }
+    assert(0 && "object not in root graph");
+    return NONE;
+}
+
+static void put_decl(writer_t * w, Agsym_t * sym)
+{
+    put_u32(&w->body, strindex(w, sym->name));
+    put_u32(&w->body, strindex(w, sym->defval));
+    put_u32(&w->body, (sym->print ? SYM_PRINT : 0) | (sym->fixed ? SYM_FIXED : 0));
+}
+
+static void put_graph_values(writer_t * w, Agraph_t * g)
+{
+    Agattr_t *data = agattrrec(g);
+    int i;
+
+    for (i = 0; i < w->nsyms[0]; i++)
+	put_u32(&w->body, strindex(w, data ? data->str[i] : NULL));
+}
+
+/* Subgraphs are kept in order of their IDs, which for named subgraphs
+ * are their interned names. Entering the names first, in that order, lets
+ * the reader allocate them in the same order, so that they usually come
+ * back in the order they were written.
+ */
+static void put_subgraph_names(writer_t * w, Agraph_t * g)
+{
+    Agraph_t *subg;
+
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	strindex(w, objname(subg, subg));
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	put_subgraph_names(w, subg);
+}
+
+/* write the subgraphs of g and, recursively, theirs */
+static void put_subgraphs(writer_t * w, Agraph_t * g)
+{
+    Agraph_t *subg;
+    Agnode_t *n;
+    Agedge_t *e;
+    uint32_t cnt = 0;
+
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	cnt++;
+    put_u32(&w->body, cnt);
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg)) {
+	Agdatadict_t *dd = agdatadict(subg, FALSE);
+	int k;
+
+	put_u32(&w->body, strindex(w, objname(subg, subg)));
+	for (k = 0; k < 3; k++) {
+	    Dict_t *dict, *view;
+	    Agsym_t *sym;
+
+	    if (!dd) {
+		put_u32(&w->body, 0);
+		continue;
+	    }
+	    dict = k == 0 ? dd->dict.g : k == 1 ? dd->dict.n : dd->dict.e;
+	    view = dtview(dict, NULL);	/* local declarations only */
+	    put_u32(&w->body, (uint32_t)dtsize(dict));
+	    for (sym = dtfirst(dict); sym; sym = dtnext(dict, sym))
+		put_decl(w, sym);
+	    dtview(dict, view);
+	}
+	put_graph_values(w, subg);
+
+	put_u32(&w->body, (uint32_t)agnnodes(subg));
+	for (n = agfstnode(subg); n; n = agnxtnode(subg, n))
+	    put_u32(&w->body, seqindex(w->nodes, w->nnodes, n));
+	put_u32(&w->body, (uint32_t)agnedges(subg));
+	for (n = agfstnode(subg); n; n = agnxtnode(subg, n))
+	    for (e = agfstout(subg, n); e; e = agnxtout(subg, e))
+		put_u32(&w->body, seqindex(w->edges, w->nedges, e));
+
+	put_subgraphs(w, subg);
+    }
+}
+
+/* Write the values of sym on objs. A column is stored densely, as NONE
+ * followed by every value, or, when fewer than half the objects differ
+ * from the default, as a count of (index, value) pairs.
+ */
+static void put_column(writer_t * w, void *objs, int n, Agsym_t * sym)
+{
+    Agobj_t **v = objs;
+    uint32_t cnt = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+	if (agattrrec(v[i])->str[sym->id] != sym->defval)
+	    cnt++;
+    if (cnt * 2 < (uint32_t)n) {
+	put_u32(&w->body, cnt);
+	for (i = 0; i < n; i++) {
+	    char *s = agattrrec(v[i])->str[sym->id];
+	    if (s != sym->defval) {
+		put_u32(&w->body, (uint32_t)i);
+		put_u32(&w->body, strindex(w, s));
+	    }
+	}
+    } else {
+	put_u32(&w->body, NONE);
+	for (i = 0; i < n; i++)
+	    put_u32(&w->body, strindex(w, agattrrec(v[i])->str[sym->id]));
+    }
+}
+
+static bool collect(writer_t * w)
+{
+    Agraph_t *g = w->g;
+    Agnode_t *n;
+    Agedge_t *e;
+    Agsym_t *sym;
+    int i, k;
+
+    w->nnodes = agnnodes(g);
+    w->nedges = agnedges(g);
+    w->nodes = malloc(((size_t)w->nnodes + 1) * sizeof(Agnode_t *));
+    w->edges = malloc(((size_t)w->nedges + 1) * sizeof(Agedge_t *));
+    if (!w->nodes || !w->edges)
+	return false;
+    i = k = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	w->nodes[i++] = n;
+	for (e = agfstout(g, n); e; e = agnxtout(g, e))
+	    w->edges[k++] = e;
+    }
+    qsort(w->edges, (size_t)w->nedges, sizeof(Agedge_t *), seqcmpf);
+
+    for (k = 0; k < 3; k++) {
+	for (sym = agnxtattr(g, Kinds[k], NULL); sym; sym = agnxtattr(g, Kinds[k], sym))
+	    w->nsyms[k]++;
+	w->syms[k] = calloc((size_t)w->nsyms[k] + 1, sizeof(Agsym_t *));
+	if (!w->syms[k])
+	    return false;
+	for (sym = agnxtattr(g, Kinds[k], NULL); sym; sym = agnxtattr(g, Kinds[k], sym)) {
+	    if (sym->id < 0 || sym->id >= w->nsyms[k] || w->syms[k][sym->id]) {
+		agerr(AGERR, "agwrite_binary: attribute ids are not dense\n");
+		return false;
+	    }
+	    w->syms[k][sym->id] = sym;
+	}
+    }
+    return true;
+}
+
+static size_t file_write(void *chan, const char *buf, size_t len)
+{
+    return fwrite(buf, 1, len, chan);
+}
+
+/* agwrite_binary:
+ * Write g as a binary graph record. If writef is NULL, chan is a stdio
+ * FILE; otherwise the record is handed to writef(chan, ...).
+ * Return 0 on success, EOF on failure.
+ */
+int agwrite_binary(Agraph_t * g,  void *chan,
+		   size_t (*writef)(void *chan, const char *buf, size_t len))
+{
+    writer_t w = {0};
+    obuf_t hdr = {0};
+    uint32_t flags;
+    int i, k, rv = EOF;
+
+    if (!writef)
+	writef = file_write;
+    w.g = g = agroot(g);
+    if (!collect(&w))
+	goto done;
+
+    flags = (agisdirected(g) ? GVB_DIRECTED : 0) | (agisstrict(g) ? GVB_STRICT : 0)
+	| (g->desc.no_loop ? GVB_NOLOOP : 0);
+    put_u32(&w.body, strindex(&w, objname(g, g)));
+    put_subgraph_names(&w, g);
+    for (k = 0; k < 3; k++) {
+	put_u32(&w.body, (uint32_t)w.nsyms[k]);
+	for (i = 0; i < w.nsyms[k]; i++)
+	    put_decl(&w, w.syms[k][i]);
+    }
+    put_graph_values(&w, g);
+
+    put_u32(&w.body, (uint32_t)w.nnodes);
+    for (i = 0; i < w.nnodes; i++)
+	put_u32(&w.body, strindex(&w, objname(g, w.nodes[i])));
+    for (i = 0; i < w.nsyms[1]; i++)
+	put_column(&w, w.nodes, w.nnodes, w.syms[1][i]);
+
+    put_u32(&w.body, (uint32_t)w.nedges);
+    for (i = 0; i < w.nedges; i++) {
+	Agedge_t *e = w.edges[i];
+	put_u32(&w.body, seqindex(w.nodes, w.nnodes, agtail(e)));
+	put_u32(&w.body, seqindex(w.nodes, w.nnodes, aghead(e)));
+	put_u32(&w.body, strindex(&w, agnameof(e)));
+    }
+    for (i = 0; i < w.nsyms[2]; i++)
+	put_column(&w, w.edges, w.nedges, w.syms[2][i]);
+
+    put_subgraphs(&w, g);
+
+    /* header, then flags and the string table, then the rest */
+    put_bytes(&hdr, GVB_MAGIC, 4);
+    put_u32(&hdr, GVB_VERSION);
+    {
+	uint64_t size = 8 + w.strs.len + w.body.len;
+	put_u32(&hdr, (uint32_t)size);
+	put_u32(&hdr, (uint32_t)(size >> 32));
+    }
+    put_u32(&hdr, flags);
+    put_u32(&hdr, w.nstrs);
+    if (hdr.failed || w.strs.failed || w.body.failed)
+	goto done;
+    if (writef(chan, hdr.data, hdr.len) != hdr.len
+	|| writef(chan, w.strs.data, w.strs.len) != w.strs.len
+	|| writef(chan, w.body.data, w.body.len) != w.body.len)
+	goto done;
+    rv = 0;
+
+  done:
+    free(hdr.data);
+    free(w.strs.data);
+    free(w.body.data);
+    free(w.keys);
+    free(w.vals);
+    free(w.nodes);
+    free(w.edges);
+    for (k = 0; k < 3; k++)
+	free(w.syms[k]);
+    return rv;
+}
+
+/* reader state */
+typedef struct {
+    const unsigned char *p, *end;
+    bool bad;
+    Agraph_t *g;
+    char **strs;		/* refstrs held while the graph is built */
+    uint32_t nstrs;
+    Agnode_t **nodes;
+    Agedge_t **edges;
+    uint32_t nnodes, nedges;
+    Agsym_t **syms[3];		/* root declarations by kind, in stored order */
+    uint32_t nsyms[3];
+} reader_t;
+
+static uint32_t get_u32(reader_t * r)
+{
+    uint32_t v;
+
+    if (r->end - r->p < 4) {
+	r->bad = true;
+	return 0;
+    }
+    v = (uint32_t)r->p[0] | (uint32_t)r->p[1] << 8
+	| (uint32_t)r->p[2] << 16 | (uint32_t)r->p[3] << 24;
+    r->p += 4;
+    return v;
+}
+
+/* a count of items of size bytes each that must fit in the rest of the record */
+static uint32_t get_count(reader_t * r, size_t size)
+{
+    uint32_t n = get_u32(r);
+
+    if ((size_t)(r->end - r->p) / size < n) {
+	r->bad = true;
+	return 0;
+    }
+    return n;
+}
+
+static char *get_str(reader_t * r)
+{
+    uint32_t i = get_u32(r);
+
+    if (i == NONE)
+	return NULL;
+    if (i >= r->nstrs) {
+	r->bad = true;
+	return NULL;
+    }
+    return r->strs[i];
+}
+
+static uint32_t get_index(reader_t * r, uint32_t n)
+{
+    uint32_t i = get_u32(r);
+
+    if (i >= n) {
+	r->bad = true;
+	return 0;
+    }
+    return i;
+}
+
+/* check the string table and point raw at its strings, which are stored
+ * NUL terminated, so that they can be used in place
+ */
+static bool get_strings(reader_t * r, uint32_t n, const char **raw,
+			bool *html)
+{
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+	uint32_t hdr = get_u32(r);
+	size_t len = hdr & ~HTMLBIT;
+	size_t padded = (len + 1 + 3) & ~(size_t)3;
+	const char *s = (const char *)r->p;
+
+	if (r->bad || (size_t)(r->end - r->p) < padded || s[len] != '\0'
+	    || strlen(s) != len)
+	    return false;
+	raw[i] = s;
+	html[i] = (hdr & HTMLBIT) != 0;
+	r->p += padded;
+    }
+    return true;
+}
+
+/* declare n attributes of the given kind in g */
+static void get_decls(reader_t * r, Agraph_t * g, int kind, uint32_t n,
+		      Agsym_t ** syms)
+{
+    uint32_t i;
+
+    for (i = 0; i < n && !r->bad; i++) {
+	char *name = get_str(r);
+	char *dflt = get_str(r);
+	uint32_t flags = get_u32(r);
+	Agsym_t *sym;
+
+	if (r->bad || !name || !dflt) {
+	    r->bad = true;
+	    return;
+	}
+	sym = agattr(g, kind, name, dflt);
+	sym->print = (flags & SYM_PRINT) != 0;
+	sym->fixed = (flags & SYM_FIXED) != 0;
+	if (syms)
+	    syms[i] = sym;
+    }
+}
+
+/* Graph values are stored directly. agxset would also declare each value
+ * as a local default of a subgraph, which the declarations already did
+ * where the written graph had one.
+ */
+static void get_graph_values(reader_t * r, Agraph_t * g)
+{
+    Agattr_t *data = agattrrec(g);
+    uint32_t i;
+
+    for (i = 0; i < r->nsyms[0] && !r->bad; i++) {
+	char *v = get_str(r);
+	int id = r->syms[0][i]->id;
+	if (v && data && v != data->str[id]) {
+	    agstrfree(g, data->str[id]);
+	    data->str[id] = agstrdup(g, v);
+	}
+    }
+}
+
+static void get_value(Agobj_t * obj, Agsym_t * sym, char *s)
+{
+    /* new objects start with the root default */
+    if (s && s != agattrrec(obj)->str[sym->id])
+	agxset(obj, sym, s);
+}
+
+static void get_column(reader_t * r, void *objs, uint32_t n, Agsym_t * sym)
+{
+    Agobj_t **v = objs;
+    uint32_t cnt = get_u32(r), i;
+
+    if (cnt == NONE) {
+	for (i = 0; i < n && !r->bad; i++)
+	    get_value(v[i], sym, get_str(r));
+	return;
+    }
+    if ((size_t)(r->end - r->p) / 8 < cnt) {
+	r->bad = true;
+	return;
+    }
+    for (; cnt > 0 && !r->bad; cnt--) {
+	uint32_t x = get_index(r, n);
+	char *s = get_str(r);
+	if (!r->bad)
+	    get_value(v[x], sym, s);
+    }
+}
+
+static void get_subgraphs(reader_t * r, Agraph_t * g)
+{
+    uint32_t cnt = get_count(r, 4), i, j;
+
+    for (i = 0; i < cnt && !r->bad; i++) {
+	Agraph_t *subg = agsubg(g, get_str(r), TRUE);
+	int k;
+
+	for (k = 0; k < 3; k++)
+	    get_decls(r, subg, Kinds[k], get_count(r, 12), NULL);
+	get_graph_values(r, subg);
+
+	for (j = get_count(r, 4); j > 0; j--) {
+	    uint32_t x = get_index(r, r->nnodes);
+	    if (r->bad)
+		return;
+	    agsubnode(subg, r->nodes[x], TRUE);
+	}
+	for (j = get_count(r, 4); j > 0; j--) {
+	    uint32_t x = get_index(r, r->nedges);
+	    if (r->bad)
+		return;
+	    agsubedge(subg, r->edges[x], TRUE);
+	}
+
+	get_subgraphs(r, subg);
+    }
+}
+
+/* build the graph held in a record body; flags are the first word */
+static Agraph_t *get_graph(const char *data, size_t len, Agdisc_t * disc)
+{
+    reader_t r = {0};
+    Agdesc_t desc = {0};
+    Agraph_t *g;
+    const char **raw;
+    bool *html;
+    uint32_t flags, nstrs, name, i;
+    int k;
+
+    r.p = (const unsigned char *)data;
+    r.end = r.p + len;
+    flags = get_u32(&r);
+    nstrs = get_count(&r, 4);
+    raw = malloc(((size_t)nstrs + 1) * sizeof(char *));
+    html = malloc(((size_t)nstrs + 1) * sizeof(bool));
+    if (r.bad || !raw || !html || !get_strings(&r, nstrs, raw, html)
+	|| ((name = get_u32(&r)) != NONE && name >= nstrs) || r.bad) {
+	agerr(AGERR, "invalid binary graph record\n");
+	free(raw);
+	free(html);
+	return NULL;
+    }
+
+    desc.directed = (flags & GVB_DIRECTED) != 0;
+    desc.strict = (flags & GVB_STRICT) != 0;
+    desc.no_loop = (flags & GVB_NOLOOP) != 0;
+    desc.maingraph = TRUE;
+    r.g = g = agopen(name == NONE ? NULL : (char *)raw[name], desc, disc);
+    if (g && (r.strs = calloc((size_t)nstrs + 1, sizeof(char *)))) {
+	for (i = 0; i < nstrs; i++)
+	    r.strs[i] = html[i] ? agstrdup_html(g, raw[i]) : agstrdup(g, raw[i]);
+	r.nstrs = nstrs;
+    }
+    free(raw);
+    free(html);
+    if (!g)
+	return NULL;
+    if (!r.strs)
+	goto bad;
+
+    for (k = 0; k < 3; k++) {
+	r.nsyms[k] = get_count(&r, 12);
+	if (!(r.syms[k] = calloc((size_t)r.nsyms[k] + 1, sizeof(Agsym_t *))))
+	    goto bad;
+	get_decls(&r, g, Kinds[k], r.nsyms[k], r.syms[k]);
+    }
+    get_graph_values(&r, g);
+
+    r.nnodes = get_count(&r, 4);
+    if (!(r.nodes = malloc(((size_t)r.nnodes + 1) * sizeof(Agnode_t *))))
+	goto bad;
+    for (i = 0; i < r.nnodes && !r.bad; i++)
+	r.nodes[i] = agnode(g, get_str(&r), TRUE);
+    for (i = 0; i < r.nsyms[1] && !r.bad; i++)
+	get_column(&r, r.nodes, r.nnodes, r.syms[1][i]);
+
+    r.nedges = get_count(&r, 12);
+    if (r.bad || !(r.edges = malloc(((size_t)r.nedges + 1) * sizeof(Agedge_t *))))
+	goto bad;
+    for (i = 0; i < r.nedges && !r.bad; i++) {
+	uint32_t t = get_index(&r, r.nnodes);
+	uint32_t h = get_index(&r, r.nnodes);
+	char *key = get_str(&r);
+	if (r.bad || !(r.edges[i] = agedge(g, r.nodes[t], r.nodes[h], key, TRUE)))
+	    r.bad = true;
+    }
+    for (i = 0; i < r.nsyms[2] && !r.bad; i++)
+	get_column(&r, r.edges, r.nedges, r.syms[2][i]);
+
+    get_subgraphs(&r, g);
+    if (r.bad || r.p != r.end)
+	goto bad;
+    aginternalmapclearlocalnames(g);
+    goto done;
+
+  bad:
+    agerr(AGERR, "invalid binary graph record\n");
+    agclose(g);
+    g = NULL;
+    r.nstrs = 0;		/* freed with the graph */
+
+  done:
+    for (i = 0; i < r.nstrs; i++)
+	agstrfree(g, r.strs[i]);
+    free(r.strs);
+    free(r.nodes);
+    free(r.edges);
+    for (k = 0; k < 3; k++)
+	free(r.syms[k]);
+    return g;
+}
+
+static uint64_t hdr_size(const unsigned char *h)
+{
+    uint64_t lo = (uint32_t)h[8] | (uint32_t)h[9] << 8
+	| (uint32_t)h[10] << 16 | (uint32_t)h[11] << 24;
+    uint64_t hi = (uint32_t)h[12] | (uint32_t)h[13] << 8
+	| (uint32_t)h[14] << 16 | (uint32_t)h[15] << 24;
+    return lo | hi << 32;
+}
+
+static bool hdr_ok(const unsigned char *h)
+{
+    if (memcmp(h, GVB_MAGIC, 4)) {
+	agerr(AGERR, "not a binary graph record\n");
+	return false;
+    }
+    if (h[4] != GVB_VERSION || h[5] || h[6] || h[7]) {
+	agerr(AGERR, "unsupported binary graph version %d\n", h[4]);
+	return false;
+    }
+    return true;
+}
+
+/* agread_binary:
+ * Read the next binary graph record from the stdio stream chan. If the
+ * stream was mapped with agmapfile, the record is decoded in place.
+ * Return NULL at end of file or on error.
+ */
+Agraph_t *agread_binary(void *chan, Agdisc_t * disc)
+{
+    const unsigned char *h;
+    unsigned char hbuf[GVB_HDRSIZE];
+    size_t avail;
+    uint64_t size;
+    Agraph_t *g;
+    char *body;
+
+    if ((h = (const unsigned char *)agmapdata(chan, &avail))) {
+	if (avail == 0)
+	    return NULL;
+	if (avail < GVB_HDRSIZE) {
+	    agerr(AGERR, "truncated binary graph record\n");
+	    agmapskip(chan, avail);
+	    return NULL;
+	}
+	if (!hdr_ok(h)) {
+	    agmapskip(chan, avail);
+	    return NULL;
+	}
+	size = hdr_size(h);
+	if (size > avail - GVB_HDRSIZE) {
+	    agerr(AGERR, "truncated binary graph record\n");
+	    agmapskip(chan, avail);
+	    return NULL;
+	}
+	g = get_graph((const char *)h + GVB_HDRSIZE, (size_t)size, disc);
+	agmapskip(chan, GVB_HDRSIZE + (size_t)size);
+	return g;
+    }
+
+    avail = fread(hbuf, 1, sizeof(hbuf), chan);
+    if (avail == 0)
+	return NULL;
+    if (avail < sizeof(hbuf)) {
+	agerr(AGERR, "truncated binary graph record\n");
+	return NULL;
+    }
+    if (!hdr_ok(hbuf))
+	return NULL;
+    size = hdr_size(hbuf);
+    if (size > SIZE_MAX || !(body = malloc((size_t)size))) {
+	agerr(AGERR, "binary graph record too large\n");
+	return NULL;
+    }
+    if (fread(body, 1, (size_t)size, chan) != size) {
+	agerr(AGERR, "truncated binary graph record\n");
+	free(body);
+	return NULL;
+    }
+    g = get_graph(body, (size_t)size, disc);
+    free(body);
+    return g;
+}
+
+/* agisbinary:
+ * Return TRUE if the next byte of the stdio stream chan starts a binary
+ * graph record.
+ */
+int agisbinary(void *chan)
+{
+    const char *data;
+    size_t avail;
+    int c;
+
+    if ((data = agmapdata(chan, &avail)))
+	return avail > 0 && data[0] == GVB_MAGIC[0];
+    c = getc(chan);
+    if (c == EOF)
+	return FALSE;
+    ungetc(c, chan);
+    return c == (unsigned char)GVB_MAGIC[0];
+}
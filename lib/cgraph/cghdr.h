@@ -99,6 +99,7 @@ Dict_t *agdtopen(Agraph_t * g, Dtdisc_t * disc, Dtmethod_t * method);
 void agdtdisc(Agraph_t * g, Dict_t * dict, Dtdisc_t * disc);
 int agdtdelete(Agraph_t * g, Dict_t * dict, void *obj);
 int agdtclose(Agraph_t * g, Dict_t * dict);
+int agdtdiscard(Agraph_t * g, Dict_t * dict);
 void *agdictobjmem(Dict_t * dict, void * p, size_t size,
 		   Dtdisc_t * disc);
 void agdictobjfree(Dict_t * dict, void * p, Dtdisc_t * disc);
@@ -121,6 +122,10 @@ int aaglex(void);
 void aglexeof(void);
 void aglexbad(void);
 
+	/* streams mapped by agmapfile */
+const char *agmapdata(void *chan, size_t *avail);
+void agmapskip(void *chan, size_t n);
+
 	/* ID management */
 int agmapnametoid(Agraph_t * g, int objtype, char *str,
           IDTYPE *result, int allocflag);
@@ -67,6 +67,7 @@ typedef struct Agrec_s Agrec_t;	/* generic runtime record */
 typedef struct Agdatadict_s Agdatadict_t;	/* set of dictionaries per graph */
 typedef struct Agedgepair_s Agedgepair_t;	/* the edge object */
 typedef struct Agsubnode_s Agsubnode_t;
+typedef struct Agstrtab_s Agstrtab_t;	/* reference counted string table */
 
 /* Header of a user record.  These records are attached by client programs
 dynamically at runtime.  A unique string ID must be given to each record
@@ -191,6 +192,7 @@ struct Agdisc_s {		/* user's discipline */
 	/* default resource disciplines */
 
 CGRAPH_API extern Agmemdisc_t AgMemDisc;
+CGRAPH_API extern Agmemdisc_t AgArenaMemDisc;	/* slab allocator, freed as a whole */
 CGRAPH_API extern Agiddisc_t AgIdDisc;
 CGRAPH_API extern Agiodisc_t AgIoDisc;
 
@@ -224,7 +226,7 @@ struct Agcbstack_s {		/* object event callbacks */
 struct Agclos_s {
     Agdisc_t disc;		/* resource discipline functions */
     Agdstate_t state;		/* resource closures */
-    Dict_t *strdict;		/* shared string dict */
+    Agstrtab_t *strdict;	/* shared string table */
     uint64_t seq[3];	/* local object sequence number counter */
     Agcbstack_t *cb;		/* user and system callback function stacks */
     unsigned char callbacks_enabled;	/* issue user callbacks or hold them? */
@@ -254,10 +256,16 @@ CGRAPH_API int agclose(Agraph_t * g);
 CGRAPH_API Agraph_t *agread(void *chan, Agdisc_t * disc);
 CGRAPH_API Agraph_t *agmemread(const char *cp);
 CGRAPH_API Agraph_t *agmemconcat(Agraph_t *g, const char *cp);
+CGRAPH_API int agmapfile(void *chan);
+CGRAPH_API void agunmapfile(void *chan);
 CGRAPH_API void agreadline(int);
 CGRAPH_API void agsetfile(const char *);
 CGRAPH_API Agraph_t *agconcat(Agraph_t * g, void *chan, Agdisc_t * disc);
 CGRAPH_API int agwrite(Agraph_t * g, void *chan);
+CGRAPH_API int agwrite_binary(Agraph_t * g, void *chan,
+			      size_t (*writef)(void *chan, const char *buf, size_t len));
+CGRAPH_API Agraph_t *agread_binary(void *chan, Agdisc_t * disc);
+CGRAPH_API int agisbinary(void *chan);
 CGRAPH_API int agisdirected(Agraph_t * g);
 CGRAPH_API int agisundirected(Agraph_t * g);
 CGRAPH_API int agisstrict(Agraph_t * g);
@@ -455,6 +463,34 @@ and edges are embedded in main graph objects but allocated separately in subgrap
 #define AGSNMAIN(sn)        ((sn)==(&((sn)->node->mainsub)))
 #define EDGEOF(sn,rep)		(AGSNMAIN(sn)?((Agedge_t*)((unsigned char*)(rep) - offsetof(Agedge_t,seq_link))) : ((Dthold_t*)(rep))->obj)
 
+/* compressed sparse row snapshots
+ *
+ * Nodes are numbered 0..nnodes-1 in agfstnode order and edges 0..nedges-1
+ * grouped by tail, so the out edges of node i are edges out[i]..out[i+1]-1
+ * in agfstout order. in_edge lists edge indices grouped by head, with the
+ * in edges of node i at in_edge[in[i]]..in_edge[in[i+1]-1] in agfstin
+ * order. A snapshot does not follow later changes to the graph.
+ */
+typedef struct {
+    int nnodes;
+    int nedges;
+    Agnode_t **nodes;		/* node of each index */
+    Agedge_t **edges;		/* out edge of each index */
+    int *out;			/* nnodes + 1 offsets into edges */
+    int *tail;			/* node index of each edge's tail */
+    int *head;			/* node index of each edge's head */
+    int *in;			/* nnodes + 1 offsets into in_edge */
+    int *in_edge;		/* edge indices grouped by head */
+    double *weight;		/* optional attribute value of each edge */
+    int *index;			/* node indices hashed by AGSEQ, -1 if empty */
+    size_t indexmask;		/* size of index less 1, a power of 2 less 1 */
+} Agcsr_t;
+
+CGRAPH_API Agcsr_t *agcsr(Agraph_t * g, Agsym_t * weight, double dflt);
+CGRAPH_API double *agcsrcolumn(const Agcsr_t * csr, Agsym_t * sym, double dflt);
+CGRAPH_API int agcsrindex(const Agcsr_t * csr, Agnode_t * n);
+CGRAPH_API void agcsrfree(Agcsr_t * csr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,162 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property 
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* compressed sparse row snapshots of a graph's adjacency structure */
+
+#include <cgraph/cghdr.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* the value of sym on e, or dflt if it does not start with a number */
+static double edgeval(Agedge_t * e, Agsym_t * sym, double dflt)
+{
+    double v;
+
+    if (sscanf(agxget(e, sym), "%lf", &v) != 1)
+	v = dflt;
+    return v;
+}
+
+/* seqslot:
+ * Return the slot of index that holds the number of the node with
+ * sequence number seq, or the empty slot where it would go. index has at
+ * least twice as many slots as there are nodes, so probes stay short, and
+ * it is sized by the graph rather than by the range of sequence numbers,
+ * which for a subgraph can span most of its root.
+ */
+static size_t seqslot(const Agcsr_t * csr, uint64_t seq)
+{
+    uint64_t h = seq * UINT64_C(0x9E3779B97F4A7C15);
+    size_t k = (size_t) (h ^ (h >> 32)) & csr->indexmask;
+    int i;
+
+    while ((i = csr->index[k]) >= 0 && AGSEQ(csr->nodes[i]) != seq)
+	k = (k + 1) & csr->indexmask;
+    return k;
+}
+
+/* agcsr:
+ * Build a snapshot of g. If weight is not NULL, csr->weight holds its
+ * value for each edge, with dflt for values that are not numbers.
+ * Returns NULL if memory is exhausted.
+ */
+Agcsr_t *agcsr(Agraph_t * g, Agsym_t * weight, double dflt)
+{
+    Agcsr_t *csr;
+    Agnode_t *n;
+    Agedge_t *e;
+    size_t slots, k;
+    int i, x;
+
+    csr = calloc(1, sizeof(Agcsr_t));
+    if (!csr)
+	return NULL;
+    csr->nnodes = agnnodes(g);
+    csr->nedges = agnedges(g);
+    for (slots = 2; slots < 2 * (size_t) csr->nnodes; slots *= 2);
+    csr->indexmask = slots - 1;
+
+    csr->nodes = malloc(((size_t) csr->nnodes + 1) * sizeof(Agnode_t *));
+    csr->edges = malloc(((size_t) csr->nedges + 1) * sizeof(Agedge_t *));
+    csr->out = malloc(((size_t) csr->nnodes + 1) * sizeof(int));
+    csr->tail = malloc(((size_t) csr->nedges + 1) * sizeof(int));
+    csr->head = malloc(((size_t) csr->nedges + 1) * sizeof(int));
+    csr->in = calloc((size_t) csr->nnodes + 2, sizeof(int));
+    csr->in_edge = malloc(((size_t) csr->nedges + 1) * sizeof(int));
+    csr->index = malloc(slots * sizeof(int));
+    if (weight)
+	csr->weight = malloc(((size_t) csr->nedges + 1) * sizeof(double));
+    if (!csr->nodes || !csr->edges || !csr->out || !csr->tail || !csr->head
+	|| !csr->in || !csr->in_edge || !csr->index
+	|| (weight && !csr->weight)) {
+	agerr(AGERR, "out of memory building adjacency snapshot\n");
+	agcsrfree(csr);
+	return NULL;
+    }
+
+    for (k = 0; k < slots; k++)
+	csr->index[k] = -1;
+    i = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	csr->nodes[i] = n;
+	csr->index[seqslot(csr, AGSEQ(n))] = i++;
+    }
+
+    /* out edges, counting in edges per head as we go */
+    x = 0;
+    for (i = 0; i < csr->nnodes; i++) {
+	csr->out[i] = x;
+	for (e = agfstout(g, csr->nodes[i]); e; e = agnxtout(g, e)) {
+	    int h = csr->index[seqslot(csr, AGSEQ(aghead(e)))];
+	    csr->edges[x] = e;
+	    csr->tail[x] = i;
+	    csr->head[x] = h;
+	    if (weight)
+		csr->weight[x] = edgeval(e, weight, dflt);
+	    csr->in[h + 2]++;
+	    x++;
+	}
+    }
+    csr->out[csr->nnodes] = x;
+
+    /* Visiting edges by tail in agfstnode order, then in agfstout order,
+     * groups in edges the same way agfstin orders them.
+     */
+    for (i = 0; i < csr->nnodes; i++)
+	csr->in[i + 2] += csr->in[i + 1];
+    for (x = 0; x < csr->nedges; x++)
+	csr->in_edge[csr->in[csr->head[x] + 1]++] = x;
+
+    return csr;
+}
+
+/* agcsrcolumn:
+ * Return a newly allocated array with the value of sym for each edge of
+ * csr, using dflt for values that are not numbers.
+ */
+double *agcsrcolumn(const Agcsr_t * csr, Agsym_t * sym, double dflt)
+{
+    double *col = malloc(((size_t) csr->nedges + 1) * sizeof(double));
+    int x;
+
+    if (!col) {
+	agerr(AGERR, "out of memory building adjacency snapshot\n");
+	return NULL;
+    }
+    for (x = 0; x < csr->nedges; x++)
+	col[x] = edgeval(csr->edges[x], sym, dflt);
+    return col;
+}
+
+/* agcsrindex:
+ * Return the index of n in csr, or -1 if n was not in the graph.
+ */
+int agcsrindex(const Agcsr_t * csr, Agnode_t * n)
+{
+    return csr->index[seqslot(csr, AGSEQ(n))];
+}
+
+void agcsrfree(Agcsr_t * csr)
+{
+    if (!csr)
+	return;
+    free(csr->nodes);
+    free(csr->edges);
+    free(csr->out);
+    free(csr->tail);
+    free(csr->head);
+    free(csr->in);
+    free(csr->in_edge);
+    free(csr->weight);
+    free(csr->index);
+    free(csr);
+}
@@ -23,6 +23,7 @@
 #include <cghdr.h>
 #include <cgraph/unreachable.h>
 #include <stddef.h>
+#include <string.h>
 extern void aagerror(const char*);
 
 static char Key[] = "key";
@@ -49,10 +50,13 @@ typedef struct list_s {		/* maintain head and tail ptrs for fast append */
 	item			*last;
 } list_t;
 
+#define SYMCACHE 16	/* attribute positions remembered per statement kind */
+
 typedef struct gstack_s {
 	Agraph_t *g;
 	Agraph_t *subg;
 	list_t	nodelist,edgelist,attrlist;
+	Agsym_t	*symcache[3][SYMCACHE];	/* last binding per kind and position */
 	struct gstack_s *down;
 } gstack_t;
 
@@ -270,17 +274,31 @@ static void appendattr(char *name, char *value)
 	listapp(&(S->attrlist),v);
 }
 
+/* bindattrs:
+ * Statements in generated files tend to repeat the same attribute names
+ * in the same order, so the symbol bound at each position is remembered and
+ * reused when the next statement of that kind names it again. Names and
+ * symbol names are both interned in G, so pointer equality suffices.
+ */
 static void bindattrs(int kind)
 {
 	item		*aptr;
 	char		*name;
+	Agsym_t		*sym;
+	int			i;
 
-	for (aptr = S->attrlist.first; aptr; aptr = aptr->next) {
+	for (aptr = S->attrlist.first, i = 0; aptr; aptr = aptr->next, i++) {
 		assert(aptr->tag == T_atom);	/* signifies unbound attr */
 		name = aptr->u.name;
 		if (kind == AGEDGE && streq(name,Key)) continue;
-		if ((aptr->u.asym = agattr(S->g,kind,name,NULL)) == NULL)
-			aptr->u.asym = agattr(S->g,kind,name,"");
+		if (i < SYMCACHE && (sym = S->symcache[kind][i]) && sym->name == name)
+			aptr->u.asym = sym;
+		else {
+			if ((aptr->u.asym = agattr(S->g,kind,name,NULL)) == NULL)
+				aptr->u.asym = agattr(S->g,kind,name,"");
+			if (i < SYMCACHE)
+				S->symcache[kind][i] = aptr->u.asym;
+		}
 		aptr->tag = T_attr;				/* signifies bound attr */
 		agstrfree(G,name);
 	}
@@ -344,6 +362,8 @@ static void attrstmt(int tkind, char *macroname)
 			sym->print = TRUE;
 	}
 	deletelist(&(S->attrlist));
+	/* a local definition in a subgraph shadows the symbols bound so far */
+	memset(S->symcache, 0, sizeof(S->symcache));
 }
 
 /* nodes */
@@ -410,12 +430,15 @@ static void endedge(void)
 			key = aptr->str;
 	}
 
-	/* can make edges with node lists or subgraphs */
+	/* can make edges with node lists or subgraphs. Every node seen here was
+	 * created in S->g or in one of its subgraphs, so it is already a member
+	 * of S->g and needs no agsubnode lookup.
+	 */
 	for (p = S->edgelist.first; p->next; p = p->next) {
 		if (p->tag == T_subgraph) {
 			subg = p->u.subg;
 			for (t = agfstnode(subg); t; t = agnxtnode(subg,t))
-				edgerhs(agsubnode(S->g,t,FALSE),NULL,p->next,key);
+				edgerhs(t,NULL,p->next,key);
 		}
 		else {
 			for (tptr = p->u.list; tptr; tptr = tptr->next)
@@ -479,11 +502,11 @@ static void edgerhs(Agnode_t *tail, char *tport, item *hlist, char *key)
 	if (hlist->tag == T_subgraph) {
 		subg = hlist->u.subg;
 		for (head = agfstnode(subg); head; head = agnxtnode(subg,head))
-			newedge(tail,tport,agsubnode(S->g,head,FALSE),NULL,key);
+			newedge(tail,tport,head,NULL,key);
 	}
 	else {
 		for (hptr = hlist->u.list; hptr; hptr = hptr->next)
-			newedge(tail,tport,agsubnode(S->g,hptr->u.n,FALSE),hptr->str,key);
+			newedge(tail,tport,hptr->u.n,hptr->str,key);
 	}
 }
 
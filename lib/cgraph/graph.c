@@ -83,6 +83,32 @@ Agraph_t *agopen1(Agraph_t * g)
     return g;
 }
 
+/*
+ * Release the dictionaries of g and its subgraphs, leaving their contents
+ * to be freed along with the heap.
+ */
+static int agdiscard(Agraph_t * g)
+{
+    Agraph_t *subg;
+    Agdatadict_t *dd;
+
+    for (subg = agfstsubg(g); subg; subg = agnxtsubg(subg))
+	if (agdiscard(subg)) return FAILURE;
+
+    /* subgraph attribute dictionaries view the parent's, so they go first */
+    if ((dd = agdatadict(g, FALSE))) {
+	if (agdtdiscard(g, dd->dict.n)) return FAILURE;
+	if (agdtdiscard(g, dd->dict.e)) return FAILURE;
+	if (agdtdiscard(g, dd->dict.g)) return FAILURE;
+    }
+    if (agdtdiscard(g, g->n_id)) return FAILURE;
+    if (agdtdiscard(g, g->n_seq)) return FAILURE;
+    if (agdtdiscard(g, g->e_id)) return FAILURE;
+    if (agdtdiscard(g, g->e_seq)) return FAILURE;
+    if (agdtdiscard(g, g->g_dict)) return FAILURE;
+    return SUCCESS;
+}
+
 /*
  * Close a graph or subgraph, freeing its storage.
  */
@@ -96,6 +122,8 @@ int agclose(Agraph_t * g)
 	/* free entire heap */
 	agmethod_delete(g, g);	/* invoke user callbacks */
 	agfreeid(g, AGRAPH, AGID(g));
+	if (agdiscard(g)) return FAILURE;
+	AGDISC(g, id)->close(AGCLOS(g, id));
 	AGDISC(g, mem)->close(AGCLOS(g, mem));	/* whoosh */
 	return SUCCESS;
     }
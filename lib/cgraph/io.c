@@ -14,9 +14,79 @@
 #if defined(_WIN32)
 #include <io.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/* Streams registered with agmapfile. Their contents are handed to the
+ * scanner straight from the mapping, a buffer at a time, rather than a
+ * line at a time through stdio. While a stream is mapped, agmapfile leaves
+ * it positioned at the end of the file. A stream closed without
+ * agunmapfile can have its FILE* handed out again by a later fopen, so an
+ * entry is only trusted while its stream still has the same descriptor,
+ * refers to the same file and is still at its end; otherwise the entry is
+ * dropped and the stream is read through stdio.
+ */
+#ifdef HAVE_SYS_MMAN_H
+#define MAXMAPPED 8
+
+typedef struct {
+    void *chan;
+    int fd;
+    dev_t dev;
+    ino_t ino;
+    const char *data;
+    size_t len;
+    size_t cur;
+} mapped_t;
+
+static mapped_t Mapped[MAXMAPPED];
+
+static void unmap(mapped_t * m)
+{
+    munmap((void *)m->data, m->len);
+    memset(m, 0, sizeof(*m));
+}
+
+/* mapped:
+ * Return the mapping of chan, or NULL if it has none or it is stale.
+ */
+static mapped_t *mapped(void *chan)
+{
+    struct stat sb;
+    int i;
+
+    if (!chan)
+	return NULL;
+    for (i = 0; i < MAXMAPPED; i++) {
+	mapped_t *m = &Mapped[i];
+	if (m->chan != chan)
+	    continue;
+	if (fileno(chan) == m->fd && fstat(m->fd, &sb) == 0
+	    && sb.st_dev == m->dev && sb.st_ino == m->ino
+	    && ftello(chan) == (off_t)m->len)
+	    return m;
+	unmap(m);
+	return NULL;
+    }
+    return NULL;
+}
+#endif
 
 static int iofread(void *chan, char *buf, int bufsize)
 {
+#ifdef HAVE_SYS_MMAN_H
+    mapped_t *m = mapped(chan);
+    if (m) {
+	size_t l = m->len - m->cur;
+	if (l > (size_t)bufsize)
+	    l = (size_t)bufsize;
+	memcpy(buf, m->data + m->cur, l);
+	m->cur += l;
+	return (int)l;
+    }
+#endif
     if (fgets(buf, bufsize, chan))
 	return (int)strlen(buf);
     else
@@ -36,6 +106,109 @@ static int ioflush(void *chan)
 
 Agiodisc_t AgIoDisc = { iofread, ioputstr, ioflush };
 
+/* agmapfile:
+ * If the stdio stream chan is a non-empty regular file, map it so that
+ * agread with the default I/O discipline reads the rest of it from memory.
+ * The stream should be read to its end and released with agunmapfile
+ * before it is closed. Returns 0 on success, -1 if the stream is left
+ * to stdio.
+ */
+int agmapfile(void *chan)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct stat sb;
+    off_t off;
+    void *p;
+    mapped_t *m = NULL;
+    int i, fd = fileno(chan);
+
+    agunmapfile(chan);
+    for (i = 0; i < MAXMAPPED && !m; i++)
+	if (!Mapped[i].chan)
+	    m = &Mapped[i];
+    if (!m)
+	return -1;
+    if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0)
+	return -1;
+    if ((off = ftello(chan)) < 0)
+	return -1;
+    p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+	return -1;
+    if (fseeko(chan, 0, SEEK_END) < 0 || ftello(chan) != sb.st_size) {
+	munmap(p, (size_t)sb.st_size);
+	fseeko(chan, off, SEEK_SET);
+	return -1;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(p, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+    m->chan = chan;
+    m->fd = fd;
+    m->dev = sb.st_dev;
+    m->ino = sb.st_ino;
+    m->data = p;
+    m->len = (size_t)sb.st_size;
+    /* a stream positioned past the end has nothing left to read */
+    m->cur = off < sb.st_size ? (size_t)off : m->len;
+    return 0;
+#else
+    (void)chan;
+    return -1;
+#endif
+}
+
+/* agmapdata:
+ * If chan is mapped, return its unread bytes and set *avail to their
+ * number. Otherwise return NULL.
+ */
+const char *agmapdata(void *chan, size_t *avail)
+{
+#ifdef HAVE_SYS_MMAN_H
+    mapped_t *m = mapped(chan);
+    if (m) {
+	*avail = m->len - m->cur;
+	return m->data + m->cur;
+    }
+#else
+    (void)chan;
+    (void)avail;
+#endif
+    return NULL;
+}
+
+/* agmapskip:
+ * Mark n bytes returned by agmapdata as consumed.
+ */
+void agmapskip(void *chan, size_t n)
+{
+#ifdef HAVE_SYS_MMAN_H
+    mapped_t *m = mapped(chan);
+    if (m)
+	m->cur += n < m->len - m->cur ? n : m->len - m->cur;
+#else
+    (void)chan;
+    (void)n;
+#endif
+}
+
+/* agunmapfile:
+ * Release a mapping made by agmapfile, leaving the stream positioned
+ * after the last byte handed to the scanner.
+ */
+void agunmapfile(void *chan)
+{
+#ifdef HAVE_SYS_MMAN_H
+    mapped_t *m = mapped(chan);
+    if (!m)
+	return;
+    fseeko(chan, (off_t)m->cur, SEEK_SET);
+    unmap(m);
+#else
+    (void)chan;
+#endif
+}
+
 typedef struct {
     const char *data;
     size_t len;
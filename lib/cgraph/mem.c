@@ -10,6 +10,7 @@
 
 #include <cgraph/cghdr.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* memory management discipline and entry points */
 static void *memopen(Agdisc_t* disc)
@@ -48,6 +49,149 @@ static void memfree(void *heap, void *ptr)
 Agmemdisc_t AgMemDisc =
     { memopen, memalloc, memresize, memfree, NULL };
 
+/* arena memory discipline
+ *
+ * Memory is handed out from a chain of large zeroed slabs and never
+ * returned individually, so closing the root graph releases everything
+ * by freeing the slabs. Freed memory is not reused, which suits graphs
+ * that are built, processed and then closed as a whole.
+ */
+
+/* alignment of every arena allocation, enough for any scalar type */
+#define ARENA_ALIGN 16
+
+#define ARENA_MIN_SLAB ((size_t)16 * 1024)
+#define ARENA_MAX_SLAB ((size_t)1024 * 1024)
+
+typedef struct arena_slab_s {
+    struct arena_slab_s *next;
+    size_t size;		/* usable bytes following the header */
+    size_t used;		/* bytes already handed out */
+} arena_slab_t;
+
+/* header size, rounded up so slab data stays aligned */
+#define ARENA_HDR \
+    ((sizeof(arena_slab_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+typedef struct {
+    arena_slab_t *slabs;	/* current slab first */
+    size_t next_size;		/* size of the next regular slab */
+} arena_t;
+
+static char *slab_data(arena_slab_t * slab)
+{
+    return (char *) slab + ARENA_HDR;
+}
+
+static arena_slab_t *arena_newslab(size_t size)
+{
+    arena_slab_t *slab = calloc(1, ARENA_HDR + size);
+
+    if (slab)
+	slab->size = size;
+    return slab;
+}
+
+static void *arenaopen(Agdisc_t * disc)
+{
+    arena_t *arena;
+
+    NOTUSED(disc);
+    arena = calloc(1, sizeof(arena_t));
+    if (arena)
+	arena->next_size = ARENA_MIN_SLAB;
+    return arena;
+}
+
+static void *arenaalloc(void *heap, size_t request)
+{
+    arena_t *arena = heap;
+    arena_slab_t *slab = arena->slabs;
+    void *rv;
+
+    request = (request + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    if (request == 0)
+	request = ARENA_ALIGN;
+
+    /* large requests get a slab of their own behind the current one, so
+     * the current slab keeps serving small requests
+     */
+    if (request > ARENA_MAX_SLAB / 4) {
+	arena_slab_t *big = arena_newslab(request);
+	if (big == NULL)
+	    return NULL;
+	big->used = request;
+	if (slab) {
+	    big->next = slab->next;
+	    slab->next = big;
+	} else
+	    arena->slabs = big;
+	return slab_data(big);
+    }
+
+    if (slab == NULL || slab->size - slab->used < request) {
+	slab = arena_newslab(arena->next_size);
+	if (slab == NULL)
+	    return NULL;
+	slab->next = arena->slabs;
+	arena->slabs = slab;
+	if (arena->next_size < ARENA_MAX_SLAB)
+	    arena->next_size *= 2;
+    }
+    rv = slab_data(slab) + slab->used;
+    slab->used += request;
+    return rv;
+}
+
+static void *arenaresize(void *heap, void *ptr, size_t oldsize,
+			 size_t request)
+{
+    arena_t *arena = heap;
+    arena_slab_t *slab = arena->slabs;
+    size_t old = (oldsize + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+    void *rv;
+
+    if (request <= oldsize)
+	return ptr;
+
+    /* the most recent allocation can grow in place */
+    if (slab && (char *) ptr + old == slab_data(slab) + slab->used
+	&& (char *) ptr >= slab_data(slab)) {
+	size_t need = (request + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1);
+	if (need - old <= slab->size - slab->used) {
+	    slab->used += need - old;
+	    memset((char *) ptr + oldsize, 0, request - oldsize);
+	    return ptr;
+	}
+    }
+
+    rv = arenaalloc(heap, request);
+    if (rv)
+	memcpy(rv, ptr, oldsize);
+    return rv;
+}
+
+static void arenafree(void *heap, void *ptr)
+{
+    NOTUSED(heap);
+    NOTUSED(ptr);
+}
+
+static void arenaclose(void *heap)
+{
+    arena_t *arena = heap;
+    arena_slab_t *slab, *next;
+
+    for (slab = arena->slabs; slab; slab = next) {
+	next = slab->next;
+	free(slab);
+    }
+    free(arena);
+}
+
+Agmemdisc_t AgArenaMemDisc =
+    { arenaopen, arenaalloc, arenaresize, arenafree, arenaclose };
+
 void *agalloc(Agraph_t * g, size_t size)
 {
     void *mem;
@@ -257,6 +257,8 @@ Agnode_t *agsubnode(Agraph_t * g, Agnode_t * n0, int cflag)
 
     if (agroot(g) != n0->root)
 	return NULL;
+    if (g == n0->root)		/* every node belongs to its root */
+	return n0;
     n = agfindnode_by_id(g, AGID(n0));
     if (n == NULL && cflag) {
 	if ((par = agparent(g))) {
@@ -10,162 +10,239 @@
 
 #include <cgraph/cghdr.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /*
  * reference counted strings.
+ *
+ * Strings are kept in an open addressing hash table with linear probing.
+ * Each string stores its hash, so probing only compares the strings
+ * themselves when the hashes match, and growing the table never rehashes
+ * the string contents.
  */
 
 typedef struct {
-    Dtlink_t link;
     uint64_t refcnt: sizeof(uint64_t) * 8 - 1;
     uint64_t is_html: 1;
-    char *s;
+    size_t hash;
     char store[1];		/* this is actually a dynamic array */
 } refstr_t;
 
-static Dtdisc_t Refstrdisc = {
-    offsetof(refstr_t, s),	/* key */
-    -1,				/* size */
-    0,				/* link offset */
-    NULL,
-    agdictobjfree,
-    NULL,
-    NULL,
-    agdictobjmem,
-    NULL
+struct Agstrtab_s {
+    refstr_t **slots;		/* capacity entries, NULL or TOMBSTONE if free */
+    size_t capacity;		/* always a power of 2 */
+    size_t size;		/* number of live strings */
+    size_t used;		/* number of live strings plus tombstones */
 };
 
-static Dict_t *Refdict_default;
+/* marks a slot whose string was freed, so probing continues past it */
+static refstr_t Tombstone;
+#define TOMBSTONE (&Tombstone)
+
+#define INITIAL_CAPACITY 1024
+
+static Agstrtab_t *Refdict_default;
+
+/* FNV-1a, also returning the length so agstrdup does not need strlen */
+static size_t strhash(const char *s, size_t *len)
+{
+    const unsigned char *p = (const unsigned char *) s;
+    uint64_t h = UINT64_C(14695981039346656037);
+
+    for (; *p; p++) {
+	h ^= *p;
+	h *= UINT64_C(1099511628211);
+    }
+    *len = (size_t) (p - (const unsigned char *) s);
+    return (size_t) h;
+}
+
+static void *tabmem(Agraph_t * g, size_t size)
+{
+    return g ? agalloc(g, size) : calloc(1, size);
+}
+
+static void tabfree(Agraph_t * g, void *p)
+{
+    if (g)
+	agfree(g, p);
+    else
+	free(p);
+}
 
 /* refdict:
- * Return the string dictionary associated with g.
+ * Return the string table associated with g.
  * If necessary, create it.
- * As a side-effect, set html masks. This assumes 8-bit bytes.
  */
-static Dict_t *refdict(Agraph_t * g)
+static Agstrtab_t *refdict(Agraph_t * g)
 {
-    Dict_t **dictref;
+    Agstrtab_t **dictref;
 
     if (g)
 	dictref = &(g->clos->strdict);
     else
 	dictref = &Refdict_default;
     if (*dictref == NULL) {
-	*dictref = agdtopen(g, &Refstrdisc, Dttree);
+	*dictref = tabmem(g, sizeof(Agstrtab_t));
+	(*dictref)->slots = tabmem(g, INITIAL_CAPACITY * sizeof(refstr_t *));
+	(*dictref)->capacity = INITIAL_CAPACITY;
     }
     return *dictref;
 }
 
 int agstrclose(Agraph_t * g)
 {
-    return agdtclose(g, refdict(g));
+    Agstrtab_t **dictref = g ? &(g->clos->strdict) : &Refdict_default;
+    Agstrtab_t *tab = *dictref;
+    size_t i;
+
+    if (tab == NULL)
+	return 0;
+    for (i = 0; i < tab->capacity; i++) {
+	if (tab->slots[i] && tab->slots[i] != TOMBSTONE)
+	    tabfree(g, tab->slots[i]);
+    }
+    tabfree(g, tab->slots);
+    tabfree(g, tab);
+    *dictref = NULL;
+    return 0;
 }
 
-static refstr_t *refsymbind(Dict_t * strdict, const char *s)
+/* refsymbind:
+ * Return the index of the slot holding s, or SIZE_MAX if it is not present.
+ */
+static size_t refsymbind(const Agstrtab_t * tab, const char *s, size_t hash)
 {
-    refstr_t key, *r;
-// Suppress Clang/GCC -Wcast-qual warning. Casting away const here is acceptable
-// as dtsearch does not modify its input key.
-#ifdef __GNUC__
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-#endif
-    key.s = (char*)s;
-#ifdef __GNUC__
-#pragma GCC diagnostic pop
-#endif
-    r = dtsearch(strdict, &key);
-    return r;
+    const size_t mask = tab->capacity - 1;
+    size_t i;
+
+    for (i = hash & mask; tab->slots[i]; i = (i + 1) & mask) {
+	const refstr_t *r = tab->slots[i];
+	if (r != TOMBSTONE && r->hash == hash && strcmp(r->store, s) == 0)
+	    return i;
+    }
+    return SIZE_MAX;
 }
 
-static char *refstrbind(Dict_t * strdict, const char *s)
+/* resize:
+ * Rebuild the table with room for at least twice the live strings,
+ * dropping tombstones along the way.
+ */
+static void resize(Agraph_t * g, Agstrtab_t * tab)
 {
+    size_t capacity = tab->capacity;
+    refstr_t **slots;
+    size_t i;
+
+    while (tab->size * 2 >= capacity / 2)
+	capacity *= 2;
+    slots = tabmem(g, capacity * sizeof(refstr_t *));
+    for (i = 0; i < tab->capacity; i++) {
+	refstr_t *r = tab->slots[i];
+	size_t j;
+	if (r == NULL || r == TOMBSTONE)
+	    continue;
+	for (j = r->hash & (capacity - 1); slots[j]; j = (j + 1) & (capacity - 1))
+	    ;
+	slots[j] = r;
+    }
+    tabfree(g, tab->slots);
+    tab->slots = slots;
+    tab->capacity = capacity;
+    tab->used = tab->size;
+}
+
+static refstr_t *refstrinsert(Agraph_t * g, Agstrtab_t * tab, const char *s,
+			      size_t len, size_t hash)
+{
+    size_t mask, i;
     refstr_t *r;
-    r = refsymbind(strdict, s);
-    if (r)
-	return r->s;
-    else
-	return NULL;
+
+    /* keep the load factor, tombstones included, below 3/4 */
+    if ((tab->used + 1) * 4 > tab->capacity * 3)
+	resize(g, tab);
+
+    r = tabmem(g, sizeof(refstr_t) + len);
+    r->refcnt = 1;
+    r->hash = hash;
+    memcpy(r->store, s, len + 1);
+
+    mask = tab->capacity - 1;
+    for (i = hash & mask; tab->slots[i] && tab->slots[i] != TOMBSTONE;
+	 i = (i + 1) & mask)
+	;
+    if (tab->slots[i] == NULL)
+	tab->used++;
+    tab->slots[i] = r;
+    tab->size++;
+    return r;
 }
 
 char *agstrbind(Agraph_t * g, const char *s)
 {
-    return refstrbind(refdict(g), s);
+    Agstrtab_t *tab = refdict(g);
+    size_t len;
+    size_t i = refsymbind(tab, s, strhash(s, &len));
+
+    return i == SIZE_MAX ? NULL : tab->slots[i]->store;
 }
 
-char *agstrdup(Agraph_t * g, const char *s)
+static char *refstrdup(Agraph_t * g, const char *s, int is_html)
 {
+    Agstrtab_t *tab;
     refstr_t *r;
-    Dict_t *strdict;
-    size_t sz;
+    size_t len, hash, i;
 
     if (s == NULL)
 	 return NULL;
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r)
+    tab = refdict(g);
+    hash = strhash(s, &len);
+    i = refsymbind(tab, s, hash);
+    if (i != SIZE_MAX) {
+	r = tab->slots[i];
 	r->refcnt++;
-    else {
-	sz = sizeof(refstr_t) + strlen(s);
-	if (g)
-	    r = agalloc(g, sz);
-	else
-	    r = malloc(sz);
-	r->refcnt = 1;
-	r->is_html = 0;
-	strcpy(r->store, s);
-	r->s = r->store;
-	dtinsert(strdict, r);
+    } else {
+	r = refstrinsert(g, tab, s, len, hash);
+	r->is_html = is_html;
     }
-    return r->s;
+    return r->store;
 }
 
-char *agstrdup_html(Agraph_t * g, const char *s)
+char *agstrdup(Agraph_t * g, const char *s)
 {
-    refstr_t *r;
-    Dict_t *strdict;
-    size_t sz;
+    return refstrdup(g, s, 0);
+}
 
-    if (s == NULL)
-	 return NULL;
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r)
-	r->refcnt++;
-    else {
-	sz = sizeof(refstr_t) + strlen(s);
-	if (g)
-	    r = agalloc(g, sz);
-	else
-	    r = malloc(sz);
-	r->refcnt = 1;
-	r->is_html = 1;
-	strcpy(r->store, s);
-	r->s = r->store;
-	dtinsert(strdict, r);
-    }
-    return r->s;
+char *agstrdup_html(Agraph_t * g, const char *s)
+{
+    return refstrdup(g, s, 1);
 }
 
 int agstrfree(Agraph_t * g, const char *s)
 {
+    Agstrtab_t *tab;
     refstr_t *r;
-    Dict_t *strdict;
+    size_t len, i;
 
     if (s == NULL)
 	 return FAILURE;
 
-    strdict = refdict(g);
-    r = refsymbind(strdict, s);
-    if (r && (r->s == s)) {
+    tab = refdict(g);
+    i = refsymbind(tab, s, strhash(s, &len));
+    if (i == SIZE_MAX)
+	return FAILURE;
+    r = tab->slots[i];
+    if (r->store == s) {
 	r->refcnt--;
 	if (r->refcnt == 0) {
-	    agdtdelete(g, strdict, r);
+	    tab->slots[i] = TOMBSTONE;
+	    tab->size--;
+	    tabfree(g, r);
 	}
     }
-    if (r == NULL)
-	return FAILURE;
     return SUCCESS;
 }
 
@@ -194,19 +271,14 @@ void agmarkhtmlstr(char *s)
 }
 
 #ifdef DEBUG
-static int refstrprint(Dict_t * dict, void *ptr, void *user)
-{
-    refstr_t *r;
-
-    NOTUSED(dict);
-    r = ptr;
-    NOTUSED(user);
-    fprintf(stderr, "%s\n", r->s);
-    return 0;
-}
-
 void agrefstrdump(Agraph_t * g)
 {
-    dtwalk(refdict(g), refstrprint, 0);
+    Agstrtab_t *tab = refdict(g);
+    size_t i;
+
+    for (i = 0; i < tab->capacity; i++) {
+	if (tab->slots[i] && tab->slots[i] != TOMBSTONE)
+	    fprintf(stderr, "%s\n", tab->slots[i]->store);
+    }
 }
 #endif
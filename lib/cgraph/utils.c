@@ -84,6 +84,35 @@ int agdtclose(Agraph_t * g, Dict_t * dict)
     return 0;
 }
 
+/* claim the dictionary contents on close, so cdt does not visit them */
+static int discardevent(Dict_t * dict, int type, void *obj, Dtdisc_t * disc)
+{
+    NOTUSED(dict);
+    NOTUSED(obj);
+    NOTUSED(disc);
+    return type == DT_CLOSE;
+}
+
+/* agdtdiscard:
+ * Release the handle of a dictionary without walking its contents.
+ * Only for use when the contents live in a heap that is about to be
+ * closed as a whole.
+ */
+int agdtdiscard(Agraph_t * g, Dict_t * dict)
+{
+    Dtdisc_t *disc;
+    Dtevent_f eventf;
+    int rv;
+
+    NOTUSED(g);
+    disc = dtdisc(dict, NULL, 0);
+    eventf = disc->eventf;
+    disc->eventf = discardevent;
+    rv = dtclose(dict);
+    disc->eventf = eventf;
+    return rv;
+}
+
 void agdtdisc(Agraph_t * g, Dict_t * dict, Dtdisc_t * disc)
 {
     (void)g; /* unused */
@@ -10,10 +10,12 @@
 
 
 #include	<circogen/blockpath.h>
-#include	<circogen/edgelist.h>
 #include	<circogen/nodeset.h>
 #include	<circogen/deglist.h>
 #include	<stddef.h>
+#include	<stdint.h>
+#include	<stdlib.h>
+#include	<string.h>
 
 /* The code below lays out a single block on a circle.
  */
@@ -398,51 +400,162 @@ static void block_graph(Agraph_t * g, block_t * sn)
     }
 }
 
-static int count_all_crossings(nodelist_t * list, Agraph_t * subg)
+/* crossings_t:
+ * Scratch space for counting the crossings of the edges of a block
+ * drawn as chords of a circle, with the nodes placed in list order.
+ * Nodes are referred to by their index in a snapshot of the block.
+ */
+typedef struct {
+    Agcsr_t *csr;		/* snapshot of the block */
+    int *start;			/* offsets of each node's neighbors in nbr */
+    int *nbr;			/* neighbors, in agfstedge order */
+    int *pos;			/* position of each node on the circle */
+    int *tree;			/* Fenwick tree over positions */
+    int *below;			/* prefix counts of one node's neighbors */
+} crossings_t;
+
+static void init_crossings(crossings_t * cx, Agraph_t * subg)
+{
+    Agcsr_t *csr = agcsr(subg, NULL, 0);
+    int N = csr->nnodes;
+    int i, x, k = 0;
+
+    cx->csr = csr;
+    cx->start = N_NEW(N + 1, int);
+    cx->nbr = N_NEW(2 * csr->nedges + 1, int);
+    for (i = 0; i < N; i++) {
+	cx->start[i] = k;
+	for (x = csr->out[i]; x < csr->out[i + 1]; x++)
+	    cx->nbr[k++] = csr->head[x];
+	for (x = csr->in[i]; x < csr->in[i + 1]; x++)
+	    cx->nbr[k++] = csr->tail[csr->in_edge[x]];
+    }
+    cx->start[N] = k;
+    cx->pos = N_NEW(N, int);
+    cx->tree = N_NEW(N + 1, int);
+    cx->below = N_NEW(N + 1, int);
+}
+
+static void free_crossings(crossings_t * cx)
+{
+    agcsrfree(cx->csr);
+    free(cx->start);
+    free(cx->nbr);
+    free(cx->pos);
+    free(cx->tree);
+    free(cx->below);
+}
+
+/* set_positions:
+ * Number the nodes from 0 in list order.
+ */
+static void set_positions(nodelist_t * list, crossings_t * cx)
 {
     nodelistitem_t *item;
-    edgelist *openEdgeList = init_edgelist();
-    Agnode_t *n;
-    Agedge_t *e;
-    int crossings = 0;
-    int order = 1;
+    int k = 0;
 
-    for (n = agfstnode(subg); n; n = agnxtnode(subg, n)) {
-	for (e = agfstout(subg, n); e; e = agnxtout(subg, e)) {
-	    EDGEORDER(e) = 0;
-	}
-    }
+    for (item = list->first; item; item = item->next)
+	cx->pos[agcsrindex(cx->csr, item->curr)] = k++;
+}
 
-    for (item = list->first; item; item = item->next) {
-	n = item->curr;
+static void tree_add(crossings_t * cx, int i, int v)
+{
+    for (i++; i <= cx->csr->nnodes; i += i & -i)
+	cx->tree[i] += v;
+}
 
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) > 0) {
-		edgelistitem *eitem;
-		Agedge_t *ep;
-
-		for (eitem = dtfirst(openEdgeList); eitem;
-		     eitem = dtnext(openEdgeList, eitem)) {
-		    ep = eitem->edge;
-		    if (EDGEORDER(ep) > EDGEORDER(e)) {
-			if ((aghead(ep) != n) && (agtail(ep) != n))
-			    crossings++;
-		    }
-		}
-		remove_edge(openEdgeList, e);
-	    }
+/* tree_sum:
+ * Return the sum of the entries at positions less than i.
+ */
+static int tree_sum(crossings_t * cx, int i)
+{
+    int sum = 0;
+
+    for (; i > 0; i -= i & -i)
+	sum += cx->tree[i];
+    return sum;
+}
+
+/* count_all_crossings:
+ * Count the pairs of edges that cross when the nodes are placed around
+ * a circle in list order. Edges (a,b) and (c,d), with a < b and c < d,
+ * cross exactly when a < c < b < d. Sweeping the nodes in order, the
+ * tree holds the left ends of the open edges, so when (a,b) closes at b
+ * it crosses the open edges starting in (a,b).
+ */
+static int64_t count_all_crossings(nodelist_t * list, crossings_t * cx)
+{
+    nodelistitem_t *item;
+    int64_t crossings = 0;
+    int i, a, b, k;
+
+    set_positions(list, cx);
+    memset(cx->tree, 0, (cx->csr->nnodes + 1) * sizeof(int));
+
+    for (item = list->first; item; item = item->next) {
+	i = agcsrindex(cx->csr, item->curr);
+	b = cx->pos[i];
+
+	/* close the edges ending here before counting, as they share b */
+	for (k = cx->start[i]; k < cx->start[i + 1]; k++) {
+	    a = cx->pos[cx->nbr[k]];
+	    if (a < b)
+		tree_add(cx, a, -1);
+	}
+	for (k = cx->start[i]; k < cx->start[i + 1]; k++) {
+	    a = cx->pos[cx->nbr[k]];
+	    if (a < b)
+		crossings += tree_sum(cx, b) - tree_sum(cx, a + 1);
 	}
+	for (k = cx->start[i]; k < cx->start[i + 1]; k++) {
+	    if (cx->pos[cx->nbr[k]] > b)
+		tree_add(cx, b, 1);
+	}
+    }
 
-	for (e = agfstedge(subg, n); e; e = agnxtedge(subg, e, n)) {
-	    if (EDGEORDER(e) == 0) {
-		EDGEORDER(e) = order;
-		add_edge(openEdgeList, e);
-	    }
+    return crossings;
+}
+
+/* node_crossings:
+ * Count the crossings involving the edges at node v. Measuring positions
+ * around the circle from v, an edge (c,d) not at v crosses one of the
+ * edges at v for each neighbor of v strictly between c and d. Edges
+ * sharing v do not cross, so moving v elsewhere on the circle changes
+ * the total crossing count by exactly the change in this value.
+ */
+static int64_t node_crossings(nodelist_t * list, crossings_t * cx, int v)
+{
+    Agcsr_t *csr = cx->csr;
+    int *below = cx->below;
+    int N = csr->nnodes;
+    int64_t crossings = 0;
+    int p, c, d, k, x;
+
+    set_positions(list, cx);
+    p = cx->pos[v];
+#define OFFSET(i) ((cx->pos[i] - p + N) % N)
+
+    /* below[k] is the number of neighbors of v at offsets less than k */
+    memset(below, 0, (N + 1) * sizeof(int));
+    for (k = cx->start[v]; k < cx->start[v + 1]; k++)
+	below[OFFSET(cx->nbr[k]) + 1]++;
+    for (k = 1; k <= N; k++)
+	below[k] += below[k - 1];
+
+    for (x = 0; x < csr->nedges; x++) {
+	if (csr->tail[x] == v || csr->head[x] == v)
+	    continue;
+	c = OFFSET(csr->tail[x]);
+	d = OFFSET(csr->head[x]);
+	if (c > d) {
+	    k = c;
+	    c = d;
+	    d = k;
 	}
-	order++;
+	crossings += below[d] - below[c + 1];
     }
+#undef OFFSET
 
-    free_edgelist(openEdgeList);
     return crossings;
 }
 
@@ -451,64 +564,73 @@ static int count_all_crossings(nodelist_t * list, Agraph_t * subg)
 /* reduce:
  * Attempt to reduce edge crossings by moving nodes.
  * Original crossing count is in cnt; final count is returned there.
- * list is the original list; return the best list found.
+ * Each move is scored by the change in the crossings at the moved
+ * node, and undone in place if it does not help.
  */
-static nodelist_t *reduce(nodelist_t * list, Agraph_t * subg, int *cnt)
+static void reduce(nodelist_t * list, crossings_t * cx, int64_t * cnt)
 {
+    Agcsr_t *csr = cx->csr;
     Agnode_t *curnode;
-    Agedge_t *e;
     Agnode_t *neighbor;
-    nodelist_t *listCopy;
-    int crossings, j, newCrossings;
+    Agnode_t *before, *after;
+    nodelistitem_t *item;
+    int64_t crossings, newCrossings, own, moved;
+    int i, j, k;
 
     crossings = *cnt;
-    for (curnode = agfstnode(subg); curnode;
-	 curnode = agnxtnode(subg, curnode)) {
+    for (i = 0; i < csr->nnodes; i++) {
+	curnode = csr->nodes[i];
+	own = node_crossings(list, cx, i);
 	/*  move curnode next to its neighbors */
-	for (e = agfstedge(subg, curnode); e;
-	     e = agnxtedge(subg, e, curnode)) {
-	    neighbor = agtail(e);
-	    if (neighbor == curnode)
-		neighbor = aghead(e);
+	for (k = cx->start[i]; k < cx->start[i + 1]; k++) {
+	    neighbor = csr->nodes[cx->nbr[k]];
 
 	    for (j = 0; j < 2; j++) {
-		listCopy = cloneNodelist(list);
+		for (item = list->first; item->curr != curnode;
+		     item = item->next);
+		before = item->prev ? item->prev->curr : NULL;
+		after = item->next ? item->next->curr : NULL;
+
 		insertNodelist(list, curnode, neighbor, j);
-		newCrossings = count_all_crossings(list, subg);
+		moved = node_crossings(list, cx, i);
+		newCrossings = crossings - own + moved;
 		if (newCrossings < crossings) {
 		    crossings = newCrossings;
-		    freeNodelist(listCopy);
+		    own = moved;
 		    if (crossings == 0) {
 			*cnt = 0;
-			return list;
+			return;
 		    }
+		} else if (before) {
+		    insertNodelist(list, curnode, before, 1);
 		} else {
-		    freeNodelist(list);
-		    list = listCopy;
+		    insertNodelist(list, curnode, after, 0);
 		}
 	    }
 	}
     }
     *cnt = crossings;
-    return list;
 }
 
 static nodelist_t *reduce_edge_crossings(nodelist_t * list,
 					 Agraph_t * subg)
 {
-    int i, crossings, origCrossings;
+    int i;
+    int64_t crossings, origCrossings;
+    crossings_t cx;
 
-    crossings = count_all_crossings(list, subg);
-    if (crossings == 0)
-	return list;
+    init_crossings(&cx, subg);
+    crossings = count_all_crossings(list, &cx);
 
-    for (i = 0; i < CROSS_ITER; i++) {
+    for (i = 0; i < CROSS_ITER && crossings > 0; i++) {
 	origCrossings = crossings;
-	list = reduce(list, subg, &crossings);
-	/* return if no crossings or no improvement */
-	if ((origCrossings == crossings) || (crossings == 0))
-	    return list;
+	reduce(list, &cx, &crossings);
+	/* stop if no improvement */
+	if (origCrossings == crossings)
+	    break;
     }
+
+    free_crossings(&cx);
     return list;
 }
 
@@ -199,12 +199,22 @@ static void copyPosns(graph_t * g)
     }
 }
 
+/* circoComponent:
+ * Lay out one connected component of the derived graph.
+ */
+static int circoComponent(Agraph_t * sg, int i, void *state)
+{
+    (void)i;
+    circularLayout(sg, state);
+    adjustNodes(sg);
+    return 0;
+}
+
 /* circoLayout:
  */
 void circoLayout(Agraph_t * g)
 {
     Agraph_t **ccs;
-    Agraph_t *sg;
     int ncc;
     int i;
 
@@ -220,16 +230,11 @@ void circoLayout(Agraph_t * g)
 	    pack_info pinfo;
 	    getPackInfo(g, l_node, CL_OFFSET, &pinfo);
 
-	    for (i = 0; i < ncc; i++) {
-		sg = ccs[i];
-		circularLayout(sg, g);
-		adjustNodes(sg);
-	    }
 	    /* FIX: splines have not been calculated for dg
 	     * To use, either do splines in dg and copy to g, or
 	     * construct components of g from ccs and use that in packing.
 	     */
-	    packSubgraphs(ncc, ccs, dg, &pinfo);
+	    packLayouts(ncc, ccs, dg, &pinfo, circoComponent, g);
 	    for (i = 0; i < ncc; i++)
 		copyPosns(ccs[i]);
 	}
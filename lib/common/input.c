@@ -16,6 +16,7 @@
 #include <xdot/xdot.h>
 #include <cgraph/agxbuf.h>
 #include <cgraph/strcasecmp.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
@@ -559,12 +560,31 @@ static char *myfgets(char * ubuf, int n, FILE * fp)
 }
 #endif
 
+/* inputDisc:
+ * Return the discipline for reading input graphs. If GV_ARENA is set to
+ * a true value, each graph gets its own arena, so that closing it does not
+ * have to free its nodes and edges one at a time.
+ */
+static Agdisc_t *inputDisc(void)
+{
+    static Agdisc_t arenaDisc;
+    char *p = getenv("GV_ARENA");
+
+    if (!p || !mapbool(p))
+	return NULL;
+    arenaDisc.mem = &AgArenaMemDisc;
+    arenaDisc.id = &AgIdDisc;
+    arenaDisc.io = &AgIoDisc;
+    return &arenaDisc;
+}
+
 graph_t *gvNextInputGraph(GVC_t *gvc)
 {
     graph_t *g = NULL;
     static char *fn;
     static FILE *fp;
     static FILE *oldfp;
+    static bool binary;
     static int fidx, gidx;
 
     while (!g) {
@@ -584,17 +604,23 @@ graph_t *gvNextInputGraph(GVC_t *gvc)
 	    break;
 	if (oldfp != fp) {
 	    agsetfile(fn ? fn : "<stdin>");
+	    agmapfile(fp);
+	    binary = agisbinary(fp);
 	    oldfp = fp;
 	}
+	if (binary)
+	    g = agread_binary(fp, inputDisc());
+	else
 #ifdef EXPERIMENTAL_MYFGETS
 	g = agread_usergets(fp, myfgets);
 #else
-	g = agread(fp,NULL);
+	g = agread(fp, inputDisc());
 #endif
 	if (g) {
 	    gvg_init(gvc, g, fn, gidx++);
 	    break;
 	}
+	agunmapfile(fp);
 	if (fp != stdin)
 	    fclose (fp);
 	oldfp = fp = NULL;
@@ -136,6 +136,79 @@ void init_rank(void)
     free_queue(Q);
 }
 
+/* repair_rank:
+ * Make the current ranking feasible while keeping it as close as possible
+ * to its initial value, typically a ranking from a previous run on a
+ * slightly different graph. Only the nodes downstream of a violated
+ * constraint are visited; they are processed in topological order and
+ * pushed just far enough to satisfy their in-edges. The cost is therefore
+ * proportional to the part of the graph affected by the violations rather
+ * than to the whole graph, as with init_rank.
+ * Returns 0 on success, or 1 if the affected region contains a cycle, in
+ * which case the ranking is left partially repaired.
+ */
+static int repair_rank(void)
+{
+    int i, n_region = 0, ctr = 0;
+    node_t **region;
+    nodequeue *Q;
+    node_t *v, *w;
+    edge_t *e;
+
+    region = N_NEW(N_nodes, node_t *);
+    for (v = GD_nlist(G); v; v = ND_next(v)) {
+	for (i = 0; (e = ND_in(v).list[i]); i++) {
+	    if (SLACK(e) < 0) {
+		ND_mark(v) = TRUE;
+		region[n_region++] = v;
+		break;
+	    }
+	}
+    }
+    if (n_region == 0) {
+	free(region);
+	return 0;
+    }
+
+    /* close the region under out-edges; ND_low counts in-edges from it */
+    for (i = 0; i < n_region; i++)
+	ND_low(region[i]) = 0;
+    for (ctr = 0; ctr < n_region; ctr++) {
+	v = region[ctr];
+	for (i = 0; (e = ND_out(v).list[i]); i++) {
+	    w = aghead(e);
+	    if (!ND_mark(w)) {
+		ND_mark(w) = TRUE;
+		ND_low(w) = 0;
+		region[n_region++] = w;
+	    }
+	    ND_low(w)++;
+	}
+    }
+
+    Q = new_queue(n_region);
+    for (i = 0; i < n_region; i++) {
+	if (ND_low(region[i]) == 0)
+	    enqueue(Q, region[i]);
+    }
+    ctr = 0;
+    while ((v = dequeue(Q))) {
+	ctr++;
+	for (i = 0; (e = ND_in(v).list[i]); i++)
+	    ND_rank(v) = MAX(ND_rank(v), ND_rank(agtail(e)) + ED_minlen(e));
+	for (i = 0; (e = ND_out(v).list[i]); i++) {
+	    if (--ND_low(aghead(e)) == 0)
+		enqueue(Q, aghead(e));
+	}
+    }
+    free_queue(Q);
+
+    for (i = 0; i < n_region; i++)
+	ND_mark(region[i]) = FALSE;
+    free(region);
+    return ctr != n_region;
+}
+
 static edge_t *leave_edge(void)
 {
     edge_t *f, *rv = NULL;
@@ -291,18 +364,16 @@ static int tight_subtree_search(Agnode_t *v, subtree_t *st)
     return rv;
 }
 
-static subtree_t *find_tight_subtree(Agnode_t *v)
+/* initialize st as the tight subtree containing v; return -1 on error */
+static int find_tight_subtree(Agnode_t *v, subtree_t *st)
 {
-    subtree_t       *rv;
-    rv = NEW(subtree_t);
-    rv->rep = v;
-    rv->size = tight_subtree_search(v,rv);
-    if (rv->size < 0) {
-        free(rv);
-        return NULL;
+    st->rep = v;
+    st->size = tight_subtree_search(v,st);
+    if (st->size < 0) {
+        return -1;
     }
-    rv->par = rv;
-    return rv;
+    st->par = st;
+    return 0;
 }
 
 typedef struct STheap_s {
@@ -409,17 +480,14 @@ void STheapify(STheap_t *heap, int i)
 }
 
 static
-STheap_t *STbuildheap(subtree_t **elt, int size)
+void STbuildheap(STheap_t *heap, subtree_t **elt, int size)
 {
     int     i;
-    STheap_t *heap;
-    heap = NEW(STheap_t);
     heap->elt = elt;
     heap->size = size;
     for (i = 0; i < heap->size; i++) heap->elt[i]->heap_index = i;
     for (i = heap->size/2; i >= 0; i--)
         STheapify(heap,i);
-    return heap;
 }
 
 static
@@ -430,7 +498,6 @@ subtree_t *STextractmin(STheap_t *heap)
     rv->heap_index = -1;
     heap->elt[0] = heap->elt[heap->size - 1];
     heap->elt[0]->heap_index = 0;
-    heap->elt[heap->size -1] = rv;    /* needed to free storage later */
     heap->size--;
     STheapify(heap,0);
     return rv;
@@ -487,6 +554,9 @@ subtree_t *merge_trees(Agedge_t *e)   /* entering tree edge */
 /* Construct initial tight tree. Graph must be connected, feasible.
  * Adjust ND_rank(v) as needed.  add_tree_edge() on tight tree edges.
  * trees are basically lists of nodes stored in nodequeues.
+ * The subtree records live in a single array indexed in discovery order,
+ * rather than in one allocation per subtree, so the union-find and heap
+ * operations below stay within one contiguous block.
  * Return 1 if input graph is not connected; 0 on success.
  */
 static
@@ -494,9 +564,9 @@ int feasible_tree(void)
 {
   Agnode_t *n;
   Agedge_t *ee;
-  subtree_t **tree, *tree0, *tree1;
-  int i, subtree_count = 0;
-  STheap_t *heap = NULL;
+  subtree_t *tree, **elt, *tree0, *tree1;
+  int subtree_count = 0;
+  STheap_t heap;
   int error = 0;
 
   /* initialization */
@@ -504,23 +574,24 @@ int feasible_tree(void)
       ND_subtree_set(n,0);
   }
 
-  tree = N_NEW(N_nodes,subtree_t*);
+  tree = N_NEW(N_nodes,subtree_t);
+  elt = N_NEW(N_nodes,subtree_t*);
   /* given init_rank, find all tight subtrees */
   for (n = GD_nlist(G); n; n = ND_next(n)) {
         if (ND_subtree(n) == 0) {
-                tree[subtree_count] = find_tight_subtree(n);
-                if (tree[subtree_count] == NULL) {
+                if (find_tight_subtree(n, &tree[subtree_count]) != 0) {
                     error = 2;
                     goto end;
                 }
+                elt[subtree_count] = &tree[subtree_count];
                 subtree_count++;
         }
   }
 
   /* incrementally merge subtrees */
-  heap = STbuildheap(tree,subtree_count);
-  while (STheapsize(heap) > 1) {
-    tree0 = STextractmin(heap);
+  STbuildheap(&heap,elt,subtree_count);
+  while (STheapsize(&heap) > 1) {
+    tree0 = STextractmin(&heap);
     if (!(ee = inter_tree_edge(tree0))) {
       error = 1;
       break;
@@ -530,12 +601,11 @@ int feasible_tree(void)
       error = 2;
       break;
     }
-    STheapify(heap,tree1->heap_index);
+    STheapify(&heap,tree1->heap_index);
   }
 
 end:
-  free(heap);
-  for (i = 0; i < subtree_count; i++) free(tree[i]);
+  free(elt);
   free(tree);
   if (error) return error;
   assert(Tree_edge.size == N_nodes - 1);
@@ -825,7 +895,7 @@ graphSize (graph_t * g, int* nn, int* ne)
     *ne = nedges;
 }
 
-/* rank:
+/* ns_rank:
  * Apply network simplex to rank the nodes in a graph.
  * Uses ED_minlen as the internode constraint: if a->b with minlen=ml,
  * rank b - rank a >= ml.
@@ -834,10 +904,14 @@ graphSize (graph_t * g, int* nn, int* ne)
  *   Out and in edges lists stored in ND_out and ND_in, even if the node
  *  doesn't have any out or in edges.
  * The node rank values are stored in ND_rank.
+ * If warm is true and the incoming ND_rank values violate some constraints,
+ * they are repaired locally by repair_rank rather than being replaced by
+ * a fresh ranking from init_rank.
  * Returns 0 if successful; returns 1 if the graph was not connected;
  * returns 2 if something seriously wrong;
  */
-int rank2(graph_t * g, int balance, int maxiter, int search_size)
+static int ns_rank(graph_t * g, int balance, int maxiter, int search_size,
+                   bool warm)
 {
     int iter = 0, feasible;
     char *ns = "network simplex: ";
@@ -854,7 +928,7 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
 	start_timer();
     }
     feasible = init_graph(g);
-    if (!feasible)
+    if (!feasible && (!warm || repair_rank() != 0))
 	init_rank();
     if (maxiter <= 0) {
 	freeTreeList (g);
@@ -913,17 +987,35 @@ int rank2(graph_t * g, int balance, int maxiter, int search_size)
     return 0;
 }
 
-int rank(graph_t * g, int balance, int maxiter)
+int rank2(graph_t * g, int balance, int maxiter, int search_size)
+{
+    return ns_rank(g, balance, maxiter, search_size, false);
+}
+
+static int searchsize(graph_t * g)
 {
     char *s;
-    int search_size;
 
     if ((s = agget(g, "searchsize")))
-	search_size = atoi(s);
-    else
-	search_size = SEARCHSIZE;
+	return atoi(s);
+    return SEARCHSIZE;
+}
 
-    return rank2 (g, balance, maxiter, search_size);
+int rank(graph_t * g, int balance, int maxiter)
+{
+    return rank2 (g, balance, maxiter, searchsize(g));
+}
+
+/* rank_warm:
+ * As rank, but the current ND_rank values are used as the starting
+ * solution even if they are not feasible. This is intended for callers
+ * that re-rank a graph which differs little from one they ranked before:
+ * seeding ND_rank with the previous result limits the work to the part of
+ * the graph affected by the change.
+ */
+int rank_warm(graph_t * g, int balance, int maxiter)
+{
+    return ns_rank(g, balance, maxiter, searchsize(g), true);
 }
 
 /* set cut value of f, assuming values of edges on one side were already set */
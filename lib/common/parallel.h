@@ -0,0 +1,95 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+/* Fork/join helper for the layouts that take a "threads" attribute.
+ *
+ * Include config.h first; without HAVE_PTHREAD everything runs on the
+ * calling thread.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdlib.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* one part of a job split nthreads ways. A part may only depend on t and
+ * nthreads, never on which thread runs it, so that the result does not change
+ * when a thread cannot be started and its part is run by the caller instead.
+ */
+typedef void (*parallel_fn)(void *arg, int t, int nthreads);
+
+typedef struct {
+  parallel_fn fn;
+  void *arg;
+  int t;
+  int nthreads;
+#ifdef HAVE_PTHREAD
+  pthread_t tid;
+#endif
+  bool started;
+} parallel_part_;
+
+static inline void *parallel_start_(void *p) {
+  parallel_part_ *part = (parallel_part_ *)p;
+  part->fn(part->arg, part->t, part->nthreads);
+  return NULL;
+}
+
+/* run fn(arg, t, nthreads) for t = 0, ..., nthreads - 1 and wait for all of
+ * them. Part 0 runs on the calling thread, the others on threads started for
+ * this call.
+ */
+static inline void parallel_run(int nthreads, parallel_fn fn, void *arg) {
+  int t;
+#ifdef HAVE_PTHREAD
+  parallel_part_ *parts;
+
+  if (nthreads > 1 &&
+      (parts = (parallel_part_ *)calloc(nthreads, sizeof(parallel_part_)))) {
+    for (t = 1; t < nthreads; t++) {
+      parts[t].fn = fn;
+      parts[t].arg = arg;
+      parts[t].t = t;
+      parts[t].nthreads = nthreads;
+      parts[t].started =
+          pthread_create(&parts[t].tid, NULL, parallel_start_, &parts[t]) == 0;
+    }
+    fn(arg, 0, nthreads);
+    for (t = 1; t < nthreads; t++) {
+      if (parts[t].started)
+        pthread_join(parts[t].tid, NULL);
+      else
+        fn(arg, t, nthreads);
+    }
+    free(parts);
+    return;
+  }
+#endif
+  for (t = 0; t < nthreads; t++)
+    fn(arg, t, nthreads);
+}
+
+/* the part [*lo, *hi) of 0, ..., n - 1 that part t of nthreads works on */
+static inline void parallel_range(int n, int t, int nthreads, int *lo,
+                                  int *hi) {
+  *lo = (int)((long long)n * t / nthreads);
+  *hi = (int)((long long)n * (t + 1) / nthreads);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,124 +11,175 @@
 
 #include <common/render.h>
 #include <common/pointset.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* A point set is an open addressing hash table with linear probing.
+ * Points are never removed, so a slot is either free or holds a point.
+ * The polyomino packing in lib/pack probes these sets once per cell for
+ * every candidate position, so membership tests need to be cheap.
+ */
+struct PointSet_s {
+    point *slots;		/* capacity entries */
+    unsigned char *used;	/* whether each slot holds a point */
+    size_t capacity;		/* a power of 2 */
+    size_t size;
+};
 
-typedef struct {
-    Dtlink_t link;
-    point id;
-} pair;
+#define PS_INIT 16
 
-static pair *mkPair(point p)
+static size_t hashpt(point p)
 {
-    pair *pp;
-
-    pp = NEW(pair);
-    pp->id = p;
-    return pp;
+    uint64_t h = (uint32_t) p.x * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= (uint32_t) p.y + UINT64_C(0x7F4A7C15) + (h << 6) + (h >> 2);
+    h *= UINT64_C(0xBF58476D1CE4E5B9);
+    return (size_t) (h ^ (h >> 31));
 }
 
-static void freePair(Dt_t * d, pair* pp, Dtdisc_t * disc)
+/* findPS:
+ * Return the slot holding p, or the free slot where it would go.
+ */
+static size_t findPS(const PointSet * ps, point p)
 {
-    (void)d;
-    (void)disc;
+    size_t mask = ps->capacity - 1;
+    size_t i;
 
-    free (pp);
+    for (i = hashpt(p) & mask; ps->used[i]; i = (i + 1) & mask) {
+	if (ps->slots[i].x == p.x && ps->slots[i].y == p.y)
+	    break;
+    }
+    return i;
 }
 
-static int cmppair(Dt_t * d, point * key1, point * key2, Dtdisc_t * disc)
+static void growPS(PointSet * ps)
 {
-    (void)d;
-    (void)disc;
-
-    if (key1->x > key2->x)
-	return 1;
-    else if (key1->x < key2->x)
-	return -1;
-    else if (key1->y > key2->y)
-	return 1;
-    else if (key1->y < key2->y)
-	return -1;
-    else
-	return 0;
+    point *slots = ps->slots;
+    unsigned char *used = ps->used;
+    size_t capacity = ps->capacity;
+    size_t i;
+
+    ps->capacity *= 2;
+    ps->slots = N_NEW(ps->capacity, point);
+    ps->used = N_NEW(ps->capacity, unsigned char);
+    for (i = 0; i < capacity; i++) {
+	if (used[i]) {
+	    size_t j = findPS(ps, slots[i]);
+	    ps->slots[j] = slots[i];
+	    ps->used[j] = 1;
+	}
+    }
+    free(slots);
+    free(used);
 }
 
-static Dtdisc_t intPairDisc = {
-    offsetof(pair, id),
-    sizeof(point),
-    offsetof(pair, link),
-    0,
-    (Dtfree_f) freePair,
-    (Dtcompar_f) cmppair,
-    0,
-    0,
-    0
-};
-
 PointSet *newPS(void)
 {
-    return (dtopen(&intPairDisc, Dtoset));
+    PointSet *ps = NEW(PointSet);
+
+    ps->capacity = PS_INIT;
+    ps->slots = N_NEW(ps->capacity, point);
+    ps->used = N_NEW(ps->capacity, unsigned char);
+    return ps;
 }
 
 void freePS(PointSet * ps)
 {
-    dtclose(ps);
+    free(ps->slots);
+    free(ps->used);
+    free(ps);
 }
 
 void insertPS(PointSet * ps, point pt)
 {
-    pair *pp;
-
-    pp = mkPair(pt);
-    if (dtinsert(ps, pp) != pp)
-        free(pp);
+    size_t i;
+
+    /* keep the load factor at most 1/2 */
+    if (2 * (ps->size + 1) > ps->capacity)
+	growPS(ps);
+    i = findPS(ps, pt);
+    if (!ps->used[i]) {
+	ps->slots[i] = pt;
+	ps->used[i] = 1;
+	ps->size++;
+    }
 }
 
 void addPS(PointSet * ps, int x, int y)
 {
     point pt;
-    pair *pp;
 
     pt.x = x;
     pt.y = y;
-    pp = mkPair(pt);
-    if (dtinsert(ps, pp) != pp)
-        free(pp);
+    insertPS(ps, pt);
 }
 
 int inPS(PointSet * ps, point pt)
 {
-    pair p;
-    p.id = pt;
-    return dtsearch(ps, &p) ? 1 : 0;
+    return ps->used[findPS(ps, pt)];
 }
 
 int isInPS(PointSet * ps, int x, int y)
 {
-    pair p;
-    p.id.x = x;
-    p.id.y = y;
-    return dtsearch(ps, &p) ? 1 : 0;
+    point pt;
+
+    pt.x = x;
+    pt.y = y;
+    return inPS(ps, pt);
 }
 
 int sizeOf(PointSet * ps)
 {
-    return dtsize(ps);
+    return (int) ps->size;
+}
+
+static int cmppt(const void *a, const void *b)
+{
+    const point *p = a;
+    const point *q = b;
+
+    if (p->x != q->x)
+	return p->x > q->x ? 1 : -1;
+    if (p->y != q->y)
+	return p->y > q->y ? 1 : -1;
+    return 0;
 }
 
+/* pointsOf:
+ * Return the points of ps in a new array, sorted by x and then y.
+ */
 point *pointsOf(PointSet * ps)
 {
-    int n = dtsize(ps);
-    point *pts = N_NEW(n, point);
-    pair *p;
+    point *pts = N_NEW(ps->size, point);
     point *pp = pts;
+    size_t i;
 
-    for (p = (pair *) dtflatten(ps); p;
-	 p = (pair *) dtlink(ps, (Dtlink_t *) p)) {
-	*pp++ = p->id;
+    for (i = 0; i < ps->capacity; i++) {
+	if (ps->used[i])
+	    *pp++ = ps->slots[i];
     }
+    qsort(pts, ps->size, sizeof(point), cmppt);
 
     return pts;
 }
 
+static int cmppair(Dt_t * d, point * key1, point * key2, Dtdisc_t * disc)
+{
+    (void)d;
+    (void)disc;
+
+    if (key1->x > key2->x)
+	return 1;
+    else if (key1->x < key2->x)
+	return -1;
+    else if (key1->y > key2->y)
+	return 1;
+    else if (key1->y < key2->y)
+	return -1;
+    else
+	return 0;
+}
+
 typedef struct {
     Dtlink_t link;
     point id;
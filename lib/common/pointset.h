@@ -17,7 +17,7 @@
 extern "C" {
 #endif
 
-    typedef Dict_t PointSet;
+    typedef struct PointSet_s PointSet;
     typedef Dict_t PointMap;
 #ifdef GVDLL
 #define POINTSET_API __declspec(dllexport)
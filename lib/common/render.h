@@ -53,6 +53,8 @@ extern "C" {
 	point offset;
     } epsf_t;
 
+    typedef struct routespl_s routespl_t;
+
 /*visual studio*/
 #ifdef _WIN32
 #ifndef GVC_EXPORTS
@@ -127,6 +129,7 @@ extern "C" {
     RENDER_API void pop_obj_state(GVJ_t *job);
     RENDER_API obj_state_t* push_obj_state(GVJ_t *job);
     RENDER_API int rank(graph_t * g, int balance, int maxiter);
+    RENDER_API int rank_warm(graph_t * g, int balance, int maxiter);
     RENDER_API port resolvePort(node_t*  n, node_t* other, port* oldport);
     RENDER_API void resolvePorts (edge_t* e);
     RENDER_API void round_corners(GVJ_t * job, pointf * AF, int sides, int style, int filled);
@@ -135,6 +138,12 @@ extern "C" {
     RENDER_API void routesplinesterm(void);
     RENDER_API pointf* simpleSplineRoute (pointf, pointf, Ppoly_t, int*, int);
     RENDER_API pointf *routepolylines(path* pp, int* npoints);
+    RENDER_API routespl_t *routesplinesinit_r(void);
+    RENDER_API pointf *routesplines_r(routespl_t *, path *, int *);
+    RENDER_API pointf *routepolylines_r(routespl_t *, path *, int *);
+    RENDER_API void routesplinesterm_r(routespl_t *);
+    RENDER_API pointf *simpleSplineRoute_r(routespl_t *, pointf, pointf,
+                                           Ppoly_t, int *, int);
     RENDER_API int selfRightSpace (edge_t* e);
     RENDER_API shape_kind shapeOf(node_t *);
     RENDER_API void shape_clip(node_t * n, pointf curve[4]);
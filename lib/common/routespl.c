@@ -19,19 +19,27 @@
 
 #define PINC 300
 
-static int nedges, nboxes; /* total no. of edges and boxes used in routing */
-
+/* data used across multiple edges */
+struct routespl_s {
+    int nedges, nboxes; /* total no. of edges and boxes used in routing */
+    pointf *ps;             /* final spline points */
+    int maxpn;             /* size of ps[] */
+    Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
+    int polypointn;        /* size of polypoints[] */
+    Pedge_t *edges;        /* polygon edges passed to Proutespline */
+    int edgen;             /* size of edges[] */
+    Ppolyline_t pl;        /* shortest path through the polygon */
+    int pln;               /* size of pl.ps[] */
+    Ppolyline_t spl;       /* spline or polyline fitted to pl */
+    int spln;              /* size of spl.ps[] */
+};
+
+/* router behind the non-reentrant entry points */
 static int routeinit;
-/* static data used across multiple edges */
-static pointf *ps;             /* final spline points */
-static int maxpn;             /* size of ps[] */
-static Ppoint_t *polypoints;  /* vertices of polygon defined by boxes */
-static int polypointn;        /* size of polypoints[] */
-static Pedge_t *edges;        /* polygon edges passed to Proutespline */
-static int edgen;             /* size of edges[] */
+static routespl_t Router;
 
 static int checkpath(int, boxf*, path*);
-static int mkspacep(int size);
+static int mkspacep(routespl_t *rtr, int size);
 static void printpath(path * pp);
 #ifdef DEBUG
 static void printboxes(int boxn, boxf* boxes)
@@ -213,64 +221,82 @@ static bool debugleveln(edge_t* realedge, int i)
 
 
 
-/* simpleSplineRoute:
+/* fitspline:
+ * Fit a spline, or a polyline if polyline is true, to the shortest path
+ * rtr->pl within poly, with end slopes evs, into rtr->spl, and copy its
+ * points to rtr->ps. The path planner writes into buffers owned by rtr, so
+ * nothing here is freed and routers used by different callers share no
+ * state. Return 0 on success, -1 if Proutespline fails and -2 if out of
+ * memory.
+ */
+static int fitspline(routespl_t *rtr, Ppoly_t poly, Pvector_t evs[2],
+                         int polyline)
+{
+    int i;
+
+    if (polyline)
+	make_polyline_r(rtr->pl, &rtr->spl, &rtr->spln);
+    else {
+	if (poly.pn > rtr->edgen) {
+	    rtr->edges = ALLOC(poly.pn, rtr->edges, Pedge_t);
+	    rtr->edgen = poly.pn;
+	}
+	for (i = 0; i < poly.pn; i++) {
+	    rtr->edges[i].a = poly.ps[i];
+	    rtr->edges[i].b = poly.ps[(i + 1) % poly.pn];
+	}
+	if (Proutespline_r(rtr->edges, poly.pn, rtr->pl, evs, &rtr->spl,
+	                   &rtr->spln) < 0)
+	    return -1;
+    }
+
+    if (mkspacep(rtr, rtr->spl.pn))
+	return -2;
+    for (i = 0; i < rtr->spl.pn; i++) {
+        rtr->ps[i] = rtr->spl.ps[i];
+    }
+    return 0;
+}
+
+/* simpleSplineRoute_r:
  * Given a simple (ccw) polygon, route an edge from tp to hp.
  */
 pointf*
-simpleSplineRoute (pointf tp, pointf hp, Ppoly_t poly, int* n_spl_pts,
-    int polyline)
+simpleSplineRoute_r (routespl_t *rtr, pointf tp, pointf hp, Ppoly_t poly,
+    int* n_spl_pts, int polyline)
 {
-    Ppolyline_t pl, spl;
     Ppoint_t eps[2];
     Pvector_t evs[2];
-    int i;
 
     eps[0].x = tp.x;
     eps[0].y = tp.y;
     eps[1].x = hp.x;
     eps[1].y = hp.y;
-    if (Pshortestpath(&poly, eps, &pl) < 0)
+    if (Pshortestpath_r(&poly, eps, &rtr->pl, &rtr->pln) < 0)
         return NULL;
 
-    if (polyline)
-	make_polyline (pl, &spl);
-    else {
-	if (poly.pn > edgen) {
-	    edges = ALLOC(poly.pn, edges, Pedge_t);
-	    edgen = poly.pn;
-	}
-	for (i = 0; i < poly.pn; i++) {
-	    edges[i].a = poly.ps[i];
-	    edges[i].b = poly.ps[(i + 1) % poly.pn];
-	}
-	    evs[0].x = evs[0].y = 0;
-	    evs[1].x = evs[1].y = 0;
-	if (Proutespline(edges, poly.pn, pl, evs, &spl) < 0)
-            return NULL;
-    }
-
-    if (mkspacep(spl.pn))
+    evs[0].x = evs[0].y = 0;
+    evs[1].x = evs[1].y = 0;
+    if (fitspline(rtr, poly, evs, polyline))
 	return NULL;
-    for (i = 0; i < spl.pn; i++) {
-        ps[i] = spl.ps[i];
-    }
-    *n_spl_pts = spl.pn;
-    return ps;
+    *n_spl_pts = rtr->spl.pn;
+    return rtr->ps;
 }
 
-/* routesplinesinit:
- * Data initialized once until matching call to routeplineterm
- * Allows recursive calls to dot
- */
-int
-routesplinesinit()
+pointf*
+simpleSplineRoute (pointf tp, pointf hp, Ppoly_t poly, int* n_spl_pts,
+    int polyline)
 {
-    if (++routeinit > 1) return 0;
-    if (!(ps = calloc(PINC, sizeof(pointf)))) {
+    return simpleSplineRoute_r(&Router, tp, hp, poly, n_spl_pts, polyline);
+}
+
+static int initrouter(routespl_t *rtr)
+{
+    if (!(rtr->ps = calloc(PINC, sizeof(pointf)))) {
 	agerr(AGERR, "routesplinesinit: cannot allocate ps\n");
 	return 1;
     }
-    maxpn = PINC;
+    rtr->maxpn = PINC;
 #ifdef DEBUG
     if (Show_boxes) {
         for (int i = 0; Show_boxes[i]; i++)
@@ -280,21 +306,66 @@ routesplinesinit()
 	Show_cnt = 0;
     }
 #endif
-    nedges = 0;
-    nboxes = 0;
+    rtr->nedges = 0;
+    rtr->nboxes = 0;
     if (Verbose)
 	start_timer();
     return 0;
 }
 
-void routesplinesterm()
+static void termrouter(routespl_t *rtr)
 {
-    if (--routeinit > 0) return;
-    free(ps);
+    free(rtr->ps);
+    rtr->ps = NULL;
+    rtr->maxpn = 0;
     if (Verbose)
 	fprintf(stderr,
 		"routesplines: %d edges, %d boxes %.2f sec\n",
-		nedges, nboxes, elapsed_sec());
+		rtr->nedges, rtr->nboxes, elapsed_sec());
+}
+
+/* routesplinesinit_r:
+ * Create a router for use with routesplines_r and friends, to be freed by
+ * routesplinesterm_r. Return NULL on failure.
+ */
+routespl_t *routesplinesinit_r(void)
+{
+    routespl_t *rtr = NEW(routespl_t);
+
+    if (initrouter(rtr)) {
+	free(rtr);
+	return NULL;
+    }
+    return rtr;
+}
+
+void routesplinesterm_r(routespl_t *rtr)
+{
+    if (!rtr)
+	return;
+    termrouter(rtr);
+    free(rtr->polypoints);
+    free(rtr->edges);
+    free(rtr->pl.ps);
+    free(rtr->spl.ps);
+    free(rtr);
+}
+
+/* routesplinesinit:
+ * Data initialized once until matching call to routeplineterm
+ * Allows recursive calls to dot
+ */
+int
+routesplinesinit()
+{
+    if (++routeinit > 1) return 0;
+    return initrouter(&Router);
+}
+
+void routesplinesterm()
+{
+    if (--routeinit > 0) return;
+    termrouter(&Router);
 }
 
 static void
@@ -340,7 +411,7 @@ limitBoxes (boxf* boxes, int boxn, const pointf *pps, int pn, int delta)
 #define INIT_DELTA 10 
 #define LOOP_TRIES 15  /* number of times to try to limiting boxes to regain space, using smaller divisions */
 
-/* routesplines:
+/* routesplines_r:
  * Route a path using the path info in pp. This includes start and end points
  * plus a collection of contiguous boxes contain the terminal points. The boxes
  * are converted into a containing polygon. A shortest path is constructed within
@@ -350,8 +421,9 @@ limitBoxes (boxf* boxes, int boxn, const pointf *pps, int pn, int delta)
  * cases, the function returns an array of the computed control points. The number
  * of these points is given in npoints.
  *
- * Note that the returned points are stored in a single array, so the points must be
- * used before another call to this function.
+ * Note that the returned points are stored in a single array of rtr, so the points
+ * must be used before another call to this function with the same router.
+ * routesplines and routepolylines use a router shared by all their callers.
  *
  * During cleanup, the function determines the x-extent of the spline in the box, so
  * the box can be shrunk to the minimum width. The extra space can then be used by other
@@ -359,25 +431,25 @@ limitBoxes (boxf* boxes, int boxn, const pointf *pps, int pn, int delta)
  *
  * If a catastrophic error, return NULL and npoints is 0.
  */
-static pointf *_routesplines(path * pp, int *npoints, int polyline)
+static pointf *_routesplines(routespl_t *rtr, path * pp, int *npoints,
+                             int polyline)
 {
     Ppoly_t poly;
-    Ppolyline_t pl, spl;
-    int splinepi;
     Ppoint_t eps[2];
     Pvector_t evs[2];
-    int edgei, prev, next;
+    int prev, next;
     int pi, bi;
     boxf *boxes;
     int boxn;
+    Ppoint_t *polypoints;
     edge_t* realedge;
     bool flip;
     int loopcnt, delta = INIT_DELTA;
     bool unbounded;
 
     *npoints = 0;
-    nedges++;
-    nboxes += pp->nbox;
+    rtr->nedges++;
+    rtr->nboxes += pp->nbox;
 
     for (realedge = pp->data;
 	 realedge && ED_edge_type(realedge) != NORMAL;
@@ -402,10 +474,11 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     }
 #endif
 
-    if (boxn * 8 > polypointn) {
-	polypoints = ALLOC(boxn * 8, polypoints, Ppoint_t);
-	polypointn = boxn * 8;
+    if (boxn * 8 > rtr->polypointn) {
+	rtr->polypoints = ALLOC(boxn * 8, rtr->polypoints, Ppoint_t);
+	rtr->polypointn = boxn * 8;
     }
+    polypoints = rtr->polypoints;
 
     if (boxn > 1 && boxes[0].LL.y > boxes[1].LL.y) {
         flip = true;
@@ -514,29 +587,18 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
     poly.ps = polypoints, poly.pn = pi;
     eps[0].x = pp->start.p.x, eps[0].y = pp->start.p.y;
     eps[1].x = pp->end.p.x, eps[1].y = pp->end.p.y;
-    if (Pshortestpath(&poly, eps, &pl) < 0) {
+    if (Pshortestpath_r(&poly, eps, &rtr->pl, &rtr->pln) < 0) {
 	agerr(AGERR, "in routesplines, Pshortestpath failed\n");
 	return NULL;
     }
 #ifdef DEBUG
     if (debugleveln(realedge, 3)) {
 	psprintpoly(poly);
-	psprintline(pl);
+	psprintline(rtr->pl);
     }
 #endif
 
-    if (polyline) {
-	make_polyline (pl, &spl);
-    }
-    else {
-	if (poly.pn > edgen) {
-	    edges = ALLOC(poly.pn, edges, Pedge_t);
-	    edgen = poly.pn;
-	}
-	for (edgei = 0; edgei < poly.pn; edgei++) {
-	    edges[edgei].a = polypoints[edgei];
-	    edges[edgei].b = polypoints[(edgei + 1) % poly.pn];
-	}
+    if (!polyline) {
 	if (pp->start.constrained) {
 	    evs[0].x = cos(pp->start.theta);
 	    evs[0].y = sin(pp->start.theta);
@@ -547,32 +609,29 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	    evs[1].y = -sin(pp->end.theta);
 	} else
 	    evs[1].x = evs[1].y = 0;
-
-	if (Proutespline(edges, poly.pn, pl, evs, &spl) < 0) {
-	    agerr(AGERR, "in routesplines, Proutespline failed\n");
-	    return NULL;
-	}
-#ifdef DEBUG
-	if (debugleveln(realedge, 3)) {
-	    psprintspline(spl);
-	    psprintinit(0);
-	}
-#endif
     }
-    if (mkspacep(spl.pn))
+    switch (fitspline(rtr, poly, evs, polyline)) {
+    case -1:
+	agerr(AGERR, "in routesplines, Proutespline failed\n");
+	return NULL;
+    case -2:
 	return NULL;  /* Bailout if no memory left */
+    }
+#ifdef DEBUG
+    if (!polyline && debugleveln(realedge, 3)) {
+	psprintspline(rtr->spl);
+	psprintinit(0);
+    }
+#endif
 
     for (bi = 0; bi < boxn; bi++) {
 	boxes[bi].LL.x = INT_MAX;
 	boxes[bi].UR.x = INT_MIN;
     }
     unbounded = true;
-    for (splinepi = 0; splinepi < spl.pn; splinepi++) {
-	ps[splinepi] = spl.ps[splinepi];
-    }
 
     for (loopcnt = 0; unbounded && loopcnt < LOOP_TRIES; loopcnt++) {
-	limitBoxes (boxes, boxn, ps, spl.pn, delta);
+	limitBoxes (boxes, boxn, rtr->ps, rtr->spl.pn, delta);
 
     /* The following check is necessary because if a box is not very 
      * high, it is possible that the sampling above might miss it.
@@ -598,13 +657,15 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	 * to bound the boxes. This will probably mean a bad edge, but we avoid an infinite
 	 * loop and we can see the bad edge, and even use the showboxes scaffolding.
 	 */
-	Ppolyline_t polyspl;
+	Ppolyline_t polyspl = {0};
+	int polysplen = 0;
 	agerr(AGWARN, "Unable to reclaim box space in spline routing for edge \"%s\" -> \"%s\". Something is probably seriously wrong.\n", agnameof(agtail(realedge)), agnameof(aghead(realedge)));
-	make_polyline (pl, &polyspl);
+	make_polyline_r (rtr->pl, &polyspl, &polysplen);
 	limitBoxes (boxes, boxn, polyspl.ps, polyspl.pn, INIT_DELTA);
+	free(polyspl.ps);
     }
 
-    *npoints = spl.pn;
+    *npoints = rtr->spl.pn;
 
 #ifdef DEBUG
     if (GD_showboxes(agraphof(aghead(realedge))) == 2 ||
@@ -615,17 +676,27 @@ static pointf *_routesplines(path * pp, int *npoints, int polyline)
 	printboxes(boxn, boxes);
 #endif
 
-    return ps;
+    return rtr->ps;
+}
+
+pointf *routesplines_r(routespl_t *rtr, path * pp, int *npoints)
+{
+    return _routesplines (rtr, pp, npoints, 0);
+}
+
+pointf *routepolylines_r(routespl_t *rtr, path * pp, int *npoints)
+{
+    return _routesplines (rtr, pp, npoints, 1);
 }
 
 pointf *routesplines(path * pp, int *npoints)
 {
-    return _routesplines (pp, npoints, 0);
+    return _routesplines (&Router, pp, npoints, 0);
 }
 
 pointf *routepolylines(path * pp, int *npoints)
 {
-    return _routesplines (pp, npoints, 1);
+    return _routesplines (&Router, pp, npoints, 1);
 }
 
 static int overlap(int i0, int i1, int j0, int j1)
@@ -784,16 +855,16 @@ static int checkpath(int boxn, boxf* boxes, path* thepath)
     return 0;
 }
 
-static int mkspacep(int size)
+static int mkspacep(routespl_t *rtr, int size)
 {
-    if (size > maxpn) {
-	int newmax = maxpn + (size / PINC + 1) * PINC;
-	ps = realloc(ps, newmax * sizeof(pointf));
-	if (!ps) {
+    if (size > rtr->maxpn) {
+	int newmax = rtr->maxpn + (size / PINC + 1) * PINC;
+	rtr->ps = realloc(rtr->ps, newmax * sizeof(pointf));
+	if (!rtr->ps) {
 	    agerr(AGERR, "cannot re-allocate ps\n");
 	    return 1;
 	}
-	maxpn = newmax;
+	rtr->maxpn = newmax;
     }
     return 0;
 }
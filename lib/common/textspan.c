@@ -8,6 +8,7 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -69,10 +70,146 @@ static PostscriptAlias* translate_postscript_fontname(char* fontname)
     return result;
 }
 
+/* Text metrics cache.
+ * Measuring a span through a textlayout plugin is expensive, and graphs
+ * often repeat the same label text in the same font. Metrics are kept in a
+ * process-wide hash table keyed by the plugin, font name, size and flags,
+ * and the string, with the least recently used entry evicted once the table
+ * is full. A span measured from the cache gets no layout; renderers that
+ * draw from the layout must make their own when it is missing.
+ */
+#define METRICS_MAX 16384	/* entries; power of 2 */
+
+typedef struct textmetrics_s textmetrics_t;
+struct textmetrics_s {
+    textmetrics_t *next;	/* hash chain */
+    textmetrics_t *newer, *older;	/* recency list */
+    size_t hash;
+    const void *engine;
+    double fontsize;
+    unsigned int flags;
+    pointf size;
+    double yoffset_layout, yoffset_centerline;
+    char *str;
+    char fontname[];		/* followed by str */
+};
+
+static struct {
+    textmetrics_t *bucket[METRICS_MAX];
+    textmetrics_t *newest, *oldest;
+    size_t count;
+} Metrics;
+
+static size_t metrics_hash(const void *engine, textfont_t * font,
+			   const char *str)
+{
+    uint64_t h = 14695981039346656037ULL;	/* FNV-1a */
+    const unsigned char *p;
+    uint64_t bits;
+
+    for (p = (const unsigned char *) font->name; *p; p++)
+	h = (h ^ *p) * 1099511628211ULL;
+    for (p = (const unsigned char *) str; *p; p++)
+	h = (h ^ *p) * 1099511628211ULL;
+    memcpy(&bits, &font->size, sizeof(bits));
+    h = (h ^ bits) * 1099511628211ULL;
+    h = (h ^ font->flags) * 1099511628211ULL;
+    h = (h ^ (uint64_t) (uintptr_t) engine) * 1099511628211ULL;
+    return (size_t) (h ^ (h >> 32));
+}
+
+static void metrics_unlink(textmetrics_t * m)
+{
+    if (m->newer)
+	m->newer->older = m->older;
+    else
+	Metrics.newest = m->older;
+    if (m->older)
+	m->older->newer = m->newer;
+    else
+	Metrics.oldest = m->newer;
+}
+
+static void metrics_push(textmetrics_t * m)
+{
+    m->newer = NULL;
+    m->older = Metrics.newest;
+    if (Metrics.newest)
+	Metrics.newest->newer = m;
+    else
+	Metrics.oldest = m;
+    Metrics.newest = m;
+}
+
+static textmetrics_t *metrics_find(const void *engine, textspan_t * span,
+				   size_t hash)
+{
+    textfont_t *font = span->font;
+    textmetrics_t *m;
+
+    for (m = Metrics.bucket[hash & (METRICS_MAX - 1)]; m; m = m->next) {
+	if (m->hash == hash && m->engine == engine
+	    && m->fontsize == font->size && m->flags == font->flags
+	    && strcmp(m->str, span->str) == 0
+	    && strcmp(m->fontname, font->name) == 0) {
+	    metrics_unlink(m);
+	    metrics_push(m);
+	    return m;
+	}
+    }
+    return NULL;
+}
+
+static void metrics_evict(void)
+{
+    textmetrics_t *m = Metrics.oldest;
+    textmetrics_t **p = &Metrics.bucket[m->hash & (METRICS_MAX - 1)];
+
+    while (*p != m)
+	p = &(*p)->next;
+    *p = m->next;
+    metrics_unlink(m);
+    Metrics.count--;
+    free(m);
+}
+
+static void metrics_add(const void *engine, textspan_t * span, size_t hash)
+{
+    textfont_t *font = span->font;
+    size_t namelen = strlen(font->name) + 1;
+    size_t strlength = strlen(span->str) + 1;
+    textmetrics_t *m;
+    textmetrics_t **b;
+
+    if (Metrics.count == METRICS_MAX)
+	metrics_evict();
+    m = malloc(sizeof(textmetrics_t) + namelen + strlength);
+    if (!m)
+	return;
+    m->hash = hash;
+    m->engine = engine;
+    m->fontsize = font->size;
+    m->flags = font->flags;
+    m->size = span->size;
+    m->yoffset_layout = span->yoffset_layout;
+    m->yoffset_centerline = span->yoffset_centerline;
+    memcpy(m->fontname, font->name, namelen);
+    m->str = m->fontname + namelen;
+    memcpy(m->str, span->str, strlength);
+    b = &Metrics.bucket[hash & (METRICS_MAX - 1)];
+    m->next = *b;
+    *b = m;
+    metrics_push(m);
+    Metrics.count++;
+}
+
 pointf textspan_size(GVC_t *gvc, textspan_t * span)
 {
     char **fpp = NULL, *fontpath = NULL;
     textfont_t *font;
+    const void *engine = gvc->textlayout.engine;
+    textmetrics_t *m;
+    size_t hash = 0;
 
     assert(span->font);
     font = span->font;
@@ -86,9 +223,26 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
     if (Verbose && emit_once(font->name))
 	fpp = &fontpath;
 
+    /* estimates are as cheap to recompute as to look up */
+    if (engine && span->str) {
+	hash = metrics_hash(engine, font, span->str);
+	if (!fpp && (m = metrics_find(engine, span, hash))) {
+	    span->size = m->size;
+	    span->yoffset_layout = m->yoffset_layout;
+	    span->yoffset_centerline = m->yoffset_centerline;
+	    span->layout = NULL;
+	    span->free_layout = NULL;
+	    return span->size;
+	}
+    }
+
     if (! gvtextlayout(gvc, span, fpp))
 	estimate_textspan_size(span, fpp);
 
+    /* a verbose lookup skipped the cache, so the span may be in it already */
+    if (engine && span->str && (!fpp || !metrics_find(engine, span, hash)))
+	metrics_add(engine, span, hash);
+
     if (fpp) {
 	if (fontpath)
 	    fprintf(stderr, "fontname: \"%s\" resolved to: %s\n",
@@ -100,6 +254,27 @@ pointf textspan_size(GVC_t *gvc, textspan_t * span)
     return span->size;
 }
 
+/* textspan_layout:
+ * Give a span measured from the text metrics cache a layout from the
+ * textlayout plugin, for renderers that draw through it. Returns true if
+ * the layout was made here, in which case the caller frees it with
+ * span->free_layout once it has been drawn.
+ */
+bool textspan_layout(GVJ_t * job, textspan_t * span)
+{
+    pointf size = span->size;
+    double yoffset_layout = span->yoffset_layout;
+    double yoffset_centerline = span->yoffset_centerline;
+
+    if (span->layout)
+	return false;
+    gvtextlayout(job->gvc, span, NULL);
+    span->size = size;
+    span->yoffset_layout = yoffset_layout;
+    span->yoffset_centerline = yoffset_centerline;
+    return span->layout != NULL;
+}
+
 static void* textfont_makef(Dt_t* dt, void* obj, Dtdisc_t* disc)
 {
     (void)dt;
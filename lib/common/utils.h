@@ -134,6 +134,9 @@ extern "C" {
     UTILS_API void start_timer(void);
     UTILS_API double elapsed_sec(void);
 
+    /* from textspan.c */
+    UTILS_API bool textspan_layout(GVJ_t * job, textspan_t * span);
+
     /* from psusershape.c */
     UTILS_API void cat_libfile(GVJ_t * job, const char **arglib, const char **stdlib);
 
@@ -0,0 +1,497 @@
+/*************************************************************************
+ * Copyright (c) 2011 AT&T Intellectual Property
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors: Details at https://graphviz.org
+ *************************************************************************/
+
+
+/*
+ * bk_xcoord(g): an alternative to solving the auxiliary graph with network
+ * simplex for the x coordinates, selected by xcoord=bk.
+ *
+ * Nodes are placed by the method of U. Brandes and B. Köpf, "Fast and
+ * Simple Horizontal Coordinate Assignment", Graph Drawing 2001: four
+ * vertical alignments are built, horizontally compacted and balanced.
+ * Compaction uses longest paths in the graph of blocks rather than the
+ * class shifting of the paper. The result is then pushed right wherever it
+ * violates the auxiliary constraint graph built by position.c, so node
+ * separation, flat edge labels and cluster containment and separation are
+ * honored as they are with network simplex.
+ */
+
+#include <dotgen/dot.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct {
+    int n;		/* number of nodes in the rank arrays */
+    int nranks;
+    int *off;		/* id of the first node of each rank; off[nranks] == n */
+    int *rk;		/* rank index of each id */
+    node_t **node;	/* id -> node */
+    double *gap;	/* minimum distance from id to id + 1 on its rank */
+    /* neighbors on the rank above (0) and below (1), sorted by order */
+    int *nboff[2];
+    int *nb[2];
+    bool *mark[2];	/* segment is in a type 1 conflict */
+} bk_t;
+
+static int intcmp(const void *x, const void *y)
+{
+    const int *a = x;
+    const int *b = y;
+    return (*a > *b) - (*a < *b);
+}
+
+static bool is_virtual(bk_t *bk, int id)
+{
+    return ND_node_type(bk->node[id]) == VIRTUAL;
+}
+
+/* build_neighbors:
+ * Collect the neighbors of every node on the rank above (d == 0) or
+ * below (d == 1) from the saved fast graph.
+ */
+static void build_neighbors(bk_t *bk, int d)
+{
+    int *cnt = N_NEW(bk->n + 1, int);
+    int id, i, ri;
+    edge_t *e;
+
+    for (id = 0; id < bk->n; id++) {
+	node_t *v = bk->node[id];
+	elist l = d == 0 ? ND_save_in(v) : ND_save_out(v);
+	cnt[id + 1] = cnt[id] + l.size;
+    }
+    bk->nboff[d] = cnt;
+    bk->nb[d] = N_NEW(cnt[bk->n] + 1, int);
+    bk->mark[d] = N_NEW(cnt[bk->n] + 1, bool);
+
+    for (id = 0; id < bk->n; id++) {
+	node_t *v = bk->node[id];
+	elist l = d == 0 ? ND_save_in(v) : ND_save_out(v);
+	int k = cnt[id];
+
+	ri = bk->rk[id] + (d == 0 ? -1 : 1);
+	if (ri < 0 || ri >= bk->nranks)
+	    continue;
+	for (i = 0; i < l.size; i++) {
+	    node_t *w;
+	    int wid;
+
+	    e = l.list[i];
+	    w = d == 0 ? agtail(e) : aghead(e);
+	    wid = bk->off[ri] + ND_order(w);
+	    if (wid < bk->off[ri + 1] && bk->node[wid] == w)
+		bk->nb[d][k++] = wid;
+	}
+	/* any unusable entries are dropped from the end of the list */
+	qsort(bk->nb[d] + cnt[id], (size_t)(k - cnt[id]), sizeof(int), intcmp);
+	for (i = k; i < cnt[id + 1]; i++)
+	    bk->nb[d][i] = -1;
+    }
+}
+
+static int degree(bk_t *bk, int d, int id)
+{
+    int i, k = bk->nboff[d][id];
+
+    for (i = k; i < bk->nboff[d][id + 1] && bk->nb[d][i] >= 0; i++);
+    return i - k;
+}
+
+/* mark_segment:
+ * Record that the segment between u on the upper rank and w on the lower
+ * one should not be used for alignment.
+ */
+static void mark_segment(bk_t *bk, int u, int w)
+{
+    int i;
+
+    for (i = bk->nboff[0][w]; i < bk->nboff[0][w + 1]; i++)
+	if (bk->nb[0][i] == u)
+	    bk->mark[0][i] = true;
+    for (i = bk->nboff[1][u]; i < bk->nboff[1][u + 1]; i++)
+	if (bk->nb[1][i] == w)
+	    bk->mark[1][i] = true;
+}
+
+/* inner_upper:
+ * If id is the lower end of a segment between two virtual nodes, return
+ * the upper end, else -1.
+ */
+static int inner_upper(bk_t *bk, int id)
+{
+    int i;
+
+    if (!is_virtual(bk, id))
+	return -1;
+    for (i = bk->nboff[0][id]; i < bk->nboff[0][id + 1]; i++) {
+	int u = bk->nb[0][i];
+	if (u >= 0 && is_virtual(bk, u))
+	    return u;
+    }
+    return -1;
+}
+
+/* mark_conflicts:
+ * Mark the type 1 conflicts, segments crossing an inner segment, so that
+ * the long edges are kept straight in preference to the short ones.
+ */
+static void mark_conflicts(bk_t *bk)
+{
+    int r;
+
+    for (r = 1; r < bk->nranks; r++) {
+	int first = bk->off[r], last = bk->off[r + 1] - 1;
+	int k0 = bk->off[r - 1], k1;
+	int l = first, l1, i;
+
+	for (l1 = first; l1 <= last; l1++) {
+	    int u = inner_upper(bk, l1);
+
+	    if (l1 != last && u < 0)
+		continue;
+	    k1 = u >= 0 ? u : bk->off[r] - 1;
+	    for (; l <= l1; l++) {
+		for (i = bk->nboff[0][l]; i < bk->nboff[0][l + 1]; i++) {
+		    int k = bk->nb[0][i];
+		    if (k < 0)
+			break;
+		    if ((k < k0 || k > k1) &&
+			!(is_virtual(bk, k) && is_virtual(bk, l)))
+			mark_segment(bk, k, l);
+		}
+	    }
+	    k0 = k1;
+	}
+    }
+}
+
+/* align:
+ * Vertical alignment of the paper. Direction v == 0 aligns nodes with
+ * their median upper neighbors working down from the top rank, v == 1
+ * with their lower neighbors working up. Direction h == 1 scans ranks
+ * right to left.
+ */
+static void align(bk_t *bk, int v, int h, int *root, int *alignto)
+{
+    int d = v;	/* neighbors on the rank already processed */
+    int id, r, j;
+
+    for (id = 0; id < bk->n; id++)
+	root[id] = alignto[id] = id;
+
+    for (j = 1; j < bk->nranks; j++) {
+	int first, last, step;
+
+	r = v == 0 ? j : bk->nranks - 1 - j;
+	if (h == 0) {
+	    first = bk->off[r];
+	    last = bk->off[r + 1];
+	    step = 1;
+	} else {
+	    first = bk->off[r + 1] - 1;
+	    last = bk->off[r] - 1;
+	    step = -1;
+	}
+	int rpos = INT_MIN;
+	for (id = first; id != last; id += step) {
+	    int deg = degree(bk, d, id);
+	    int m[2], nm, i;
+
+	    if (deg == 0)
+		continue;
+	    /* the medians, in scanning order */
+	    if (h == 0) {
+		m[0] = (deg - 1) / 2;
+		m[1] = deg / 2;
+	    } else {
+		m[0] = deg / 2;
+		m[1] = (deg - 1) / 2;
+	    }
+	    nm = m[0] == m[1] ? 1 : 2;
+	    for (i = 0; i < nm; i++) {
+		int k = bk->nboff[d][id] + m[i];
+		int u = bk->nb[d][k];
+		int upos = h == 0 ? u : -u;
+
+		if (alignto[id] != id)
+		    break;
+		if (!bk->mark[d][k] && rpos < upos) {
+		    alignto[u] = id;
+		    root[id] = root[u];
+		    alignto[id] = root[id];
+		    rpos = upos;
+		}
+	    }
+	}
+    }
+}
+
+/* compact:
+ * Horizontal compaction of the blocks made by align. Each block is placed
+ * by a longest path from the left in the graph of blocks, then moved as
+ * far right as its right neighbors allow. Coordinates for h == 1 are
+ * computed mirrored and negated on return. Returns nonzero if the blocks
+ * are not acyclic.
+ */
+static int compact(bk_t *bk, int h, int *root, double *x)
+{
+    int n = bk->n;
+    int *eoff = N_NEW(n + 1, int);
+    int *edst = N_NEW(n + 1, int);
+    double *ewt = N_NEW(n + 1, double);
+    int *indeg = N_NEW(n, int);
+    int *order = N_NEW(n, int);
+    double *xs = N_NEW(n, double);
+    int id, r, i, nblocks = 0, head = 0, tail = 0;
+    int rv = 0;
+
+    /* edges from the block of each node to that of its right neighbor */
+    for (r = 0; r < bk->nranks; r++)
+	for (id = bk->off[r]; id + 1 < bk->off[r + 1]; id++)
+	    eoff[root[h == 0 ? id : id + 1] + 1]++;
+    for (id = 0; id < n; id++)
+	eoff[id + 1] += eoff[id];
+    for (r = 0; r < bk->nranks; r++)
+	for (id = bk->off[r]; id + 1 < bk->off[r + 1]; id++) {
+	    int a = root[h == 0 ? id : id + 1];
+	    int b = root[h == 0 ? id + 1 : id];
+	    int k = eoff[a] + indeg[a]++;	/* indeg used as a fill count */
+	    edst[k] = b;
+	    ewt[k] = bk->gap[id];
+	}
+
+    for (id = 0; id < n; id++)
+	indeg[id] = 0;
+    for (id = 0; id < n; id++) {
+	if (root[id] != id)
+	    continue;
+	nblocks++;
+	for (i = eoff[id]; i < eoff[id + 1]; i++)
+	    indeg[edst[i]]++;
+    }
+    for (id = 0; id < n; id++)
+	if (root[id] == id && indeg[id] == 0)
+	    order[tail++] = id;
+    while (head < tail) {
+	int b = order[head++];
+	for (i = eoff[b]; i < eoff[b + 1]; i++) {
+	    int c = edst[i];
+	    xs[c] = MAX(xs[c], xs[b] + ewt[i]);
+	    if (--indeg[c] == 0)
+		order[tail++] = c;
+	}
+    }
+    if (tail < nblocks) {
+	rv = 1;
+	goto done;
+    }
+    for (head = tail - 1; head >= 0; head--) {
+	int b = order[head];
+	if (eoff[b] < eoff[b + 1]) {
+	    double m = xs[edst[eoff[b]]] - ewt[eoff[b]];
+	    for (i = eoff[b] + 1; i < eoff[b + 1]; i++)
+		m = MIN(m, xs[edst[i]] - ewt[i]);
+	    xs[b] = MAX(xs[b], m);
+	}
+    }
+    for (id = 0; id < n; id++)
+	x[id] = h == 0 ? xs[root[id]] : -xs[root[id]];
+
+done:
+    free(eoff);
+    free(edst);
+    free(ewt);
+    free(indeg);
+    free(order);
+    free(xs);
+    return rv;
+}
+
+static int dblcmp(const void *x, const void *y)
+{
+    const double *a = x;
+    const double *b = y;
+    return (*a > *b) - (*a < *b);
+}
+
+/* balance:
+ * Align the four layouts to the narrowest one and give each node the
+ * average of its two median candidate coordinates.
+ */
+static void balance(bk_t *bk, double *xs[4])
+{
+    double lo[4], hi[4];
+    int a, s = 0, id;
+
+    for (a = 0; a < 4; a++) {
+	lo[a] = hi[a] = 0;
+	for (id = 0; id < bk->n; id++) {
+	    node_t *v = bk->node[id];
+	    double l = xs[a][id] - ND_lw(v), r = xs[a][id] + ND_rw(v);
+	    if (id == 0 || l < lo[a])
+		lo[a] = l;
+	    if (id == 0 || r > hi[a])
+		hi[a] = r;
+	}
+	if (hi[a] - lo[a] < hi[s] - lo[s])
+	    s = a;
+    }
+    for (id = 0; id < bk->n; id++) {
+	double c[4];
+	for (a = 0; a < 4; a++) {
+	    /* layouts 0 and 2 were compacted to the left */
+	    double shift = a % 2 == 0 ? lo[s] - lo[a] : hi[s] - hi[a];
+	    c[a] = xs[a][id] + shift;
+	}
+	qsort(c, 4, sizeof(double), dblcmp);
+	ND_rank(bk->node[id]) = ROUND((c[1] + c[2]) / 2);
+    }
+}
+
+static void mark_left_bounds(graph_t *g)
+{
+    int c;
+
+    if (GD_ln(g))
+	ND_priority(GD_ln(g)) = 1;
+    for (c = 1; c <= GD_n_cluster(g); c++)
+	mark_left_bounds(GD_clust(g)[c]);
+}
+
+/* constrain:
+ * Move nodes right until every auxiliary edge u -> v has
+ * ND_rank(v) - ND_rank(u) >= ED_minlen. Slack nodes start unplaced and
+ * get the smallest feasible value, except that left cluster bounds, and
+ * slack nodes with nothing to their left, are then moved right against
+ * what they bound so clusters are no wider than needed. Returns nonzero if
+ * the constraints are cyclic.
+ */
+static int constrain(graph_t *g)
+{
+    node_t *n, **order;
+    edge_t *e;
+    int i, count = 0, head = 0, tail = 0, lo = INT_MAX;
+
+    for (n = GD_nlist(g); n; n = ND_next(n))
+	count++;
+    order = N_NEW(count, node_t *);
+    for (n = GD_nlist(g); n; n = ND_next(n)) {
+	ND_priority(n) = ND_in(n).size;
+	if (ND_node_type(n) == SLACKNODE)
+	    ND_rank(n) = INT_MIN;
+	if (ND_priority(n) == 0)
+	    order[tail++] = n;
+    }
+    while (head < tail) {
+	n = order[head++];
+	for (i = 0; (e = ND_out(n).list[i]); i++) {
+	    node_t *v = aghead(e);
+	    if (ND_rank(n) != INT_MIN)
+		ND_rank(v) = MAX(ND_rank(v), ND_rank(n) + ED_minlen(e));
+	    if (--ND_priority(v) == 0)
+		order[tail++] = v;
+	}
+    }
+    if (tail < count) {
+	free(order);
+	return 1;
+    }
+
+    mark_left_bounds(g);
+    for (head = count - 1; head >= 0; head--) {
+	n = order[head];
+	if (ND_priority(n) == 0 && ND_rank(n) != INT_MIN)
+	    continue;
+	if ((e = ND_out(n).list[0])) {
+	    int x = ND_rank(aghead(e)) - ED_minlen(e);
+	    for (i = 1; (e = ND_out(n).list[i]); i++)
+		x = MIN(x, ND_rank(aghead(e)) - ED_minlen(e));
+	    ND_rank(n) = MAX(ND_rank(n), x);
+	}
+    }
+
+    for (i = 0; i < count; i++) {
+	if (ND_rank(order[i]) != INT_MIN)
+	    lo = MIN(lo, ND_rank(order[i]));
+	ND_priority(order[i]) = 0;
+    }
+    for (i = 0; i < count; i++) {
+	if (ND_rank(order[i]) == INT_MIN)
+	    ND_rank(order[i]) = lo;
+	ND_rank(order[i]) -= lo;
+    }
+    free(order);
+    return 0;
+}
+
+int bk_xcoord(graph_t *g)
+{
+    bk_t bk = {0};
+    double *xs[4];
+    int *root, *alignto;
+    int r, id, j, a, rv = 0;
+    rank_t *rank = GD_rank(g);
+
+    bk.nranks = GD_maxrank(g) - GD_minrank(g) + 1;
+    bk.off = N_NEW(bk.nranks + 1, int);
+    for (r = 0; r < bk.nranks; r++)
+	bk.off[r + 1] = bk.off[r] + rank[GD_minrank(g) + r].n;
+    bk.n = bk.off[bk.nranks];
+    bk.rk = N_NEW(bk.n + 1, int);
+    bk.node = N_NEW(bk.n + 1, node_t *);
+    bk.gap = N_NEW(bk.n + 1, double);
+    for (r = 0; r < bk.nranks; r++) {
+	rank_t *rp = rank + GD_minrank(g) + r;
+	for (j = 0; j < rp->n; j++) {
+	    node_t *u = rp->v[j];
+	    id = bk.off[r] + j;
+	    bk.rk[id] = r;
+	    bk.node[id] = u;
+	    /* the separation make_LR_constraints asked for */
+	    if (j + 1 < rp->n) {
+		edge_t *e = find_fast_edge(u, rp->v[j + 1]);
+		bk.gap[id] = e ? ED_minlen(e) : ND_rw(u) + ND_lw(rp->v[j + 1]);
+	    }
+	}
+    }
+    build_neighbors(&bk, 0);
+    build_neighbors(&bk, 1);
+    mark_conflicts(&bk);
+
+    root = N_NEW(bk.n + 1, int);
+    alignto = N_NEW(bk.n + 1, int);
+    for (a = 0; a < 4; a++)
+	xs[a] = N_NEW(bk.n + 1, double);
+    /* layout a aligns vertically in direction a / 2 and scans in a % 2 */
+    for (a = 0; a < 4 && rv == 0; a++) {
+	align(&bk, a / 2, a % 2, root, alignto);
+	rv = compact(&bk, a % 2, root, xs[a]);
+    }
+    if (rv == 0) {
+	balance(&bk, xs);
+	rv = constrain(g);
+    }
+
+    for (a = 0; a < 4; a++)
+	free(xs[a]);
+    free(root);
+    free(alignto);
+    for (j = 0; j < 2; j++) {
+	free(bk.nboff[j]);
+	free(bk.nb[j]);
+	free(bk.mark[j]);
+    }
+    free(bk.off);
+    free(bk.rk);
+    free(bk.node);
+    free(bk.gap);
+    return rv;
+}
@@ -18,6 +18,7 @@ extern "C" {
 
     extern void acyclic(Agraph_t *);
     extern void allocate_ranks(Agraph_t *);
+    extern int bk_xcoord(Agraph_t *);
     extern void build_ranks(Agraph_t *, int);
     extern void build_skeleton(Agraph_t *, Agraph_t *);
     extern void checkLabelOrder (graph_t* g);
@@ -30,6 +31,9 @@ extern "C" {
     extern void dot_cleanup(graph_t * g);
     extern void dot_layout(Agraph_t * g);
     extern void dot_init_node_edge(graph_t * g);
+    extern int dot_prev_chain(graph_t *, Agedge_t *, Agnode_t **, double *,
+			      int);
+    extern bool dot_prev_coord(graph_t *, Agsym_t *, Agnode_t *, pointf *);
     extern void dot_scan_ranks(graph_t * g);
     extern void enqueue_neighbors(nodequeue * q, node_t * n0, int pass);
     extern void expand_cluster(Agraph_t *);
@@ -110,6 +110,7 @@ static void boxes_free(boxes_t *boxes) {
 typedef struct {
     int LeftBound, RightBound, Splinesep, Multisep;
     boxf* Rank_box;
+    routespl_t* rtr;
 } spline_info_t;
 
 static void adjustregularpath(path *, int, int);
@@ -309,9 +310,10 @@ setEdgeLabelPos (graph_t * g)
  * The normalize parameter allows this function to be called by the
  * recursive call in make_flat_edge without normalization occurring,
  * so that the edge will only be normalized once in the top level call
- * of dot_splines.
+ * of dot_splines. The recursive call also passes in the router of the top
+ * level call, which is otherwise created here.
  */
-static void _dot_splines(graph_t * g, int normalize)
+static void _dot_splines(graph_t * g, int normalize, routespl_t* rtr)
 {
     int i, j, k, n_nodes, n_edges, ind, cnt;
     node_t *n;
@@ -347,7 +349,10 @@ static void _dot_splines(graph_t * g, int normalize)
 #endif
 
     mark_lowclusters(g);
-    if (routesplinesinit()) return;
+    if (rtr)
+	sd.rtr = rtr;
+    else if (!(sd.rtr = routesplinesinit_r()))
+	return;
     P = NEW(path);
     /* FlatHeight = 2 * GD_nodesep(g); */
     sd.Splinesep = GD_nodesep(g) / 4;
@@ -568,7 +573,8 @@ finish :
 	free(P->boxes);
 	free(P);
 	free(sd.Rank_box);
-	routesplinesterm();
+	if (!rtr)
+	    routesplinesterm_r(sd.rtr);
     } 
     State = GVSPLINES;
     EdgeLabelsDone = 1;
@@ -579,7 +585,7 @@ finish :
  */
 void dot_splines(graph_t * g)
 {
-    _dot_splines (g, 1);
+    _dot_splines (g, 1, NULL);
 }
 
 /* place_vnlabel:
@@ -1031,7 +1037,7 @@ static int edgelblcmpfn(edge_t** ptr0, edge_t** ptr1)
  * records because of their weird nature.
  */
 static void
-makeSimpleFlatLabels (node_t* tn, node_t* hn, edge_t** edges, int ind, int cnt, int et, int n_lbls)
+makeSimpleFlatLabels (spline_info_t* sp, node_t* tn, node_t* hn, edge_t** edges, int ind, int cnt, int et, int n_lbls)
 {
     pointf *ps;
     Ppoly_t poly;
@@ -1120,7 +1126,7 @@ makeSimpleFlatLabels (node_t* tn, node_t* hn, edge_t** edges, int ind, int cnt,
 	}
 	poly.pn = 8;
 	poly.ps = (Ppoint_t*)points;
-	ps = simpleSplineRoute (tp, hp, poly, &pn, et == EDGETYPE_PLINE);
+	ps = simpleSplineRoute_r (sp->rtr, tp, hp, poly, &pn, et == EDGETYPE_PLINE);
 	if (pn == 0) return;
 	ED_label(e)->pos.x = ctrx;
 	ED_label(e)->pos.y = ctry;
@@ -1172,7 +1178,7 @@ makeSimpleFlatLabels (node_t* tn, node_t* hn, edge_t** edges, int ind, int cnt,
 	}
 	poly.pn = 8;
 	poly.ps = (Ppoint_t*)points;
-	ps = simpleSplineRoute (tp, hp, poly, &pn, et == EDGETYPE_PLINE);
+	ps = simpleSplineRoute_r (sp->rtr, tp, hp, poly, &pn, et == EDGETYPE_PLINE);
 	if (pn == 0) return;
 	clip_and_install(e, aghead(e), ps, pn, &sinfo);
     }
@@ -1232,7 +1238,7 @@ makeSimpleFlat (node_t* tn, node_t* hn, edge_t** edges, int ind, int cnt, int et
  * more straightforward and laborious fashion. 
  */
 static void
-make_flat_adj_edges(graph_t* g, path* P, edge_t** edges, int ind, int cnt, edge_t* e0,
+make_flat_adj_edges(graph_t* g, spline_info_t* sp, path* P, edge_t** edges, int ind, int cnt, edge_t* e0,
                     int et)
 {
     node_t* n;
@@ -1273,7 +1279,7 @@ make_flat_adj_edges(graph_t* g, path* P, edge_t** edges, int ind, int cnt, edge_
 	}
 	/* flat edges without ports but with labels take more work */
 	else {
-	    makeSimpleFlatLabels (tn, hn, edges, ind, cnt, et, labels);
+	    makeSimpleFlatLabels (sp, tn, hn, edges, ind, cnt, et, labels);
 	}
 	return;
     }
@@ -1334,7 +1340,7 @@ make_flat_adj_edges(graph_t* g, path* P, edge_t** edges, int ind, int cnt, edge_
 	else ND_coord(n).y = midx;
     }
     dot_sameports(auxg);
-    _dot_splines(auxg, 0);
+    _dot_splines(auxg, 0, sp->rtr);
     dotneato_postprocess(auxg);
 
        /* copy splines */
@@ -1483,8 +1489,8 @@ make_flat_labeled_edge(graph_t* g, spline_info_t* sp, path* P, edge_t* e, int et
 	for (size_t j = 0; j < boxn; j++) add_box(P, boxes[j]);
 	for (i = hend.boxn - 1; i >= 0; i--) add_box(P, hend.boxes[i]);
 
-	if (et == EDGETYPE_SPLINE) ps = routesplines(P, &pn);
-	else ps = routepolylines(P, &pn);
+	if (et == EDGETYPE_SPLINE) ps = routesplines_r(sp->rtr, P, &pn);
+	else ps = routepolylines_r(sp->rtr, P, &pn);
 	if (pn == 0) return;
     }
     clip_and_install(e, aghead(e), ps, pn, &sinfo);
@@ -1551,8 +1557,8 @@ make_flat_bottom_edges(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges,
 	for (size_t k = 0; k < boxn; k++) add_box(P, boxes[k]);
 	for (j = hend.boxn - 1; j >= 0; j--) add_box(P, hend.boxes[j]);
 
-	if (splines) ps = routesplines(P, &pn);
-	else ps = routepolylines(P, &pn);
+	if (splines) ps = routesplines_r(sp->rtr, P, &pn);
+	else ps = routepolylines_r(sp->rtr, P, &pn);
 	if (pn == 0)
 	    return;
 	clip_and_install(e, aghead(e), ps, pn, &sinfo);
@@ -1601,7 +1607,7 @@ make_flat_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int ind
      * so check them all.
      */
     if (isAdjacent) {
-	make_flat_adj_edges (g, P, edges, ind, cnt, e, et);
+	make_flat_adj_edges (g, sp, P, edges, ind, cnt, e, et);
 	return;
     }
     if (ED_label(e)) {  /* edges with labels aren't multi-edges */
@@ -1672,8 +1678,8 @@ make_flat_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int ind
 	for (size_t k = 0; k < boxn; k++) add_box(P, boxes[k]);
 	for (j = hend.boxn - 1; j >= 0; j--) add_box(P, hend.boxes[j]);
 
-	if (et == EDGETYPE_SPLINE) ps = routesplines(P, &pn);
-	else ps = routepolylines(P, &pn);
+	if (et == EDGETYPE_SPLINE) ps = routesplines_r(sp->rtr, P, &pn);
+	else ps = routepolylines_r(sp->rtr, P, &pn);
 	if (pn == 0)
 	    return;
 	clip_and_install(e, aghead(e), ps, pn, &sinfo);
@@ -1888,9 +1894,9 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	    assert(boxes.size <= (size_t)INT_MAX && "integer overflow");
 	    completeregularpath(P, segfirst, e, &tend, &hend, boxes.data,
 	                        (int)boxes.size, 1);
-	    if (is_spline) ps = routesplines(P, &pn);
+	    if (is_spline) ps = routesplines_r(sp->rtr, P, &pn);
 	    else {
-		ps = routepolylines (P, &pn);
+		ps = routepolylines_r(sp->rtr, P, &pn);
 		if ((et == EDGETYPE_LINE) && (pn > 4)) {
 		    ps[1] = ps[0];
 		    ps[3] = ps[2] = ps[pn-1];
@@ -1940,8 +1946,8 @@ make_regular_edge(graph_t* g, spline_info_t* sp, path * P, edge_t ** edges, int
 	completeregularpath(P, segfirst, e, &tend, &hend, boxes.data, (int)boxes.size,
 	                    longedge);
 	boxes_free(&boxes);
-	if (is_spline) ps = routesplines(P, &pn);
-	else ps = routepolylines (P, &pn);
+	if (is_spline) ps = routesplines_r(sp->rtr, P, &pn);
+	else ps = routepolylines_r(sp->rtr, P, &pn);
 	if (et == EDGETYPE_LINE && pn > 4) {
 	    /* Here we have used the polyline case to handle
 	     * an edge between two nodes on adjacent ranks. If the
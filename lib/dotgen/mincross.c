@@ -20,6 +20,7 @@
 #include <cgraph/cgraph.h>
 #include <dotgen/dot.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -404,16 +405,30 @@ static void free_matrix(adjmatrix_t * p)
 
 #define ELT(M,i,j)		(M->data[((i)*M->ncols)+(j)])
 
+/* init_mccomp:
+ * Prepare component c for crossing minimization. The rank arrays of the
+ * components are laid out one after the other, so each rank is advanced
+ * past the nodes installed by the previous component. The rank range of g
+ * is then narrowed to the ranks actually spanned by the component, so
+ * that the passes over the component do not walk the empty ranks of a
+ * graph made of many small components. merge2 restores the global range.
+ */
 static void init_mccomp(graph_t * g, int c)
 {
     int r;
+    node_t *v;
 
     GD_nlist(g) = GD_comp(g).list[c];
-    if (c > 0) {
-	for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+    for (r = GlobalMinRank; r <= GlobalMaxRank; r++) {
+	if (c > 0)
 	    GD_rank(g)[r].v = GD_rank(g)[r].v + GD_rank(g)[r].n;
-	    GD_rank(g)[r].n = 0;
-	}
+	GD_rank(g)[r].n = 0;
+    }
+    GD_minrank(g) = GlobalMaxRank;
+    GD_maxrank(g) = GlobalMinRank;
+    for (v = GD_nlist(g); v; v = ND_next(v)) {
+	GD_minrank(g) = MIN(GD_minrank(g), ND_rank(v));
+	GD_maxrank(g) = MAX(GD_maxrank(g), ND_rank(v));
     }
 }
 
@@ -577,42 +592,54 @@ static int left2right(graph_t * g, node_t * v, node_t * w)
     return rv;
 }
 
-static int in_cross(node_t * v, node_t * w)
+/* in_cross:
+ * Add to *vw the crossings between the in-edges of v and w when v is left
+ * of w, and to *wv those when w is left of v. Both orders are counted in
+ * one pass over the pairs of edges.
+ */
+static void in_cross(node_t * v, node_t * w, int *vw, int *wv)
 {
     edge_t **e1, **e2;
-    int inv, cross = 0, t;
+    int inv, t;
 
     for (e2 = ND_in(w).list; *e2; e2++) {
-	int cnt = ED_xpenalty(*e2);		
-		
+	int cnt = ED_xpenalty(*e2);
+	double port = ED_tail_port(*e2).p.x;
+
 	inv = ND_order(agtail(*e2));
 
 	for (e1 = ND_in(v).list; *e1; e1++) {
 	    t = ND_order(agtail(*e1)) - inv;
-	    if (t > 0 || (t == 0 && ED_tail_port(*e1).p.x > ED_tail_port(*e2).p.x))
-		cross += ED_xpenalty(*e1) * cnt;
+	    if (t > 0 || (t == 0 && ED_tail_port(*e1).p.x > port))
+		*vw += ED_xpenalty(*e1) * cnt;
+	    if (t < 0 || (t == 0 && port > ED_tail_port(*e1).p.x))
+		*wv += ED_xpenalty(*e1) * cnt;
 	}
     }
-    return cross;
 }
 
-static int out_cross(node_t * v, node_t * w)
+/* out_cross:
+ * As in_cross, for the out-edges of v and w.
+ */
+static void out_cross(node_t * v, node_t * w, int *vw, int *wv)
 {
     edge_t **e1, **e2;
-    int inv, cross = 0, t;
+    int inv, t;
 
     for (e2 = ND_out(w).list; *e2; e2++) {
 	int cnt = ED_xpenalty(*e2);
+	double port = ED_head_port(*e2).p.x;
+
 	inv = ND_order(aghead(*e2));
 
 	for (e1 = ND_out(v).list; *e1; e1++) {
 	    t = ND_order(aghead(*e1)) - inv;
-	    if (t > 0 || (t == 0 && (ED_head_port(*e1)).p.x > (ED_head_port(*e2)).p.x))
-		cross += ED_xpenalty(*e1) * cnt;
+	    if (t > 0 || (t == 0 && ED_head_port(*e1).p.x > port))
+		*vw += ED_xpenalty(*e1) * cnt;
+	    if (t < 0 || (t == 0 && port > ED_head_port(*e1).p.x))
+		*wv += ED_xpenalty(*e1) * cnt;
 	}
     }
-    return cross;
-
 }
 
 static void exchange(node_t * v, node_t * w)
@@ -735,15 +762,11 @@ static int balance(graph_t * g)
 	    if (left2right(g, v, w))
 		continue;
 	    c0 = c1 = 0;
-	    if (r > 0) {
-		c0 += in_cross(v, w);
-		c1 += in_cross(w, v);
-	    }
+	    if (r > 0)
+		in_cross(v, w, &c0, &c1);
 
-	    if (GD_rank(g)[r + 1].n > 0) {
-		c0 += out_cross(v, w);
-		c1 += out_cross(w, v);
-	    }
+	    if (GD_rank(g)[r + 1].n > 0)
+		out_cross(v, w, &c0, &c1);
 
 	    if (c1 <= c0) {
 		balanceNodes(g, r, v, w);
@@ -767,14 +790,10 @@ static int transpose_step(graph_t * g, int r, bool reverse)
 	if (left2right(g, v, w))
 	    continue;
 	c0 = c1 = 0;
-	if (r > 0) {
-	    c0 += in_cross(v, w);
-	    c1 += in_cross(w, v);
-	}
-	if (GD_rank(g)[r + 1].n > 0) {
-	    c0 += out_cross(v, w);
-	    c1 += out_cross(w, v);
-	}
+	if (r > 0)
+	    in_cross(v, w, &c0, &c1);
+	if (GD_rank(g)[r + 1].n > 0)
+	    out_cross(v, w, &c0, &c1);
 	if (c1 < c0 || (c0 > 0 && reverse && c1 == c0)) {
 	    exchange(v, w);
 	    rv += c0 - c1;
@@ -925,8 +944,6 @@ static void merge_components(graph_t * g)
     }
     GD_comp(g).size = 1;
     GD_nlist(g) = GD_comp(g).list[0];
-    GD_minrank(g) = GlobalMinRank;
-    GD_maxrank(g) = GlobalMaxRank;
 }
 
 /* merge connected components, create globally consistent rank lists */
@@ -937,11 +954,15 @@ static void merge2(graph_t * g)
 
     /* merge the components and rank limits */
     merge_components(g);
+    GD_minrank(g) = GlobalMinRank;
+    GD_maxrank(g) = GlobalMaxRank;
 
-    /* install complete ranks */
+    /* install complete ranks; any cached crossing counts were computed
+     * for a single component and are stale now */
     for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
 	GD_rank(g)[r].n = GD_rank(g)[r].an;
 	GD_rank(g)[r].v = GD_rank(g)[r].av;
+	GD_rank(g)[r].valid = FALSE;
 	for (i = 0; i < GD_rank(g)[r].n; i++) {
 	    v = GD_rank(g)[r].v[i];
 	    if (v == NULL) {
@@ -1348,6 +1369,82 @@ void install_in_rank(graph_t * g, node_t * n)
     }
 }
 
+/* order nodes by their x in an earlier layout, then by current order */
+static int cmp_prev_x(const void *a, const void *b)
+{
+    node_t *v = *(node_t * const *)a, *w = *(node_t * const *)b;
+
+    if (ND_mval(v) < ND_mval(w))
+	return -1;
+    if (ND_mval(v) > ND_mval(w))
+	return 1;
+    return ND_order(v) - ND_order(w);
+}
+
+/* seed_order:
+ * If nswarm is set, sort the nodes of each rank of g that have an x from
+ * an earlier layout, the real nodes with a pos and the virtual nodes of
+ * the edges between them (see dot_prev_chain), by that x, so that mincross
+ * starts from the old ordering. Other nodes keep their place. The x is
+ * kept in ND_mval, which medians later overwrites.
+ */
+static void seed_order(graph_t * g)
+{
+    graph_t *root = dot_root(g);
+    Agsym_t *sym;
+    node_t *u, *v, **chain, **keyed;
+    edge_t *e;
+    double *x;
+    pointf p;
+    int r, i, k, n, max;
+
+    if (!mapbool(agget(root, "nswarm"))
+	|| !(sym = agattr(agroot(root), AGNODE, "pos", NULL)))
+	return;
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (i = 0; i < GD_rank(g)[r].n; i++) {
+	    v = GD_rank(g)[r].v[i];
+	    ND_mval(v) = NAN;
+	    if (ND_node_type(v) == NORMAL && dot_prev_coord(g, sym, v, &p))
+		ND_mval(v) = p.x;
+	}
+    }
+
+    max = GD_maxrank(root) - GD_minrank(root) + 1;
+    chain = N_NEW(max, node_t *);
+    x = N_NEW(max, double);
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	for (i = 0; i < GD_rank(g)[r].n; i++) {
+	    u = GD_rank(g)[r].v[i];
+	    if (ND_node_type(u) != NORMAL || isnan(ND_mval(u)))
+		continue;
+	    for (k = 0; (e = ND_out(u).list[k]); k++) {
+		n = dot_prev_chain(g, e, chain, x, max);
+		while (n-- > 0)
+		    ND_mval(chain[n]) = x[n];
+	    }
+	}
+    }
+    free(chain);
+    free(x);
+
+    for (r = GD_minrank(g); r <= GD_maxrank(g); r++) {
+	node_t **vlist = GD_rank(g)[r].v;
+	keyed = N_NEW(GD_rank(g)[r].n + 1, node_t *);
+	for (i = n = 0; i < GD_rank(g)[r].n; i++)
+	    if (!isnan(ND_mval(vlist[i])))
+		keyed[n++] = vlist[i];
+	qsort(keyed, n, sizeof(node_t *), cmp_prev_x);
+	for (i = k = 0; i < GD_rank(g)[r].n; i++) {
+	    if (!isnan(ND_mval(vlist[i]))) {
+		vlist[i] = keyed[k++];
+		ND_order(vlist[i]) = i;
+	    }
+	}
+	free(keyed);
+    }
+}
+
 /*	install nodes in ranks. the initial ordering ensure that series-parallel
  *	graphs such as trees are drawn with no crossings.  it tries searching
  *	in- and out-edges and takes the better of the two initial orderings.
@@ -1408,6 +1505,7 @@ void build_ranks(graph_t * g, int pass)
 		exchange(vlist[j], vlist[n - j]);
 	}
     }
+    seed_order(g);
 
     if (g == dot_root(g) && ncross(g) > 0)
 	transpose(g, FALSE);
@@ -1656,37 +1754,55 @@ static int local_cross(elist l, int dir)
     return cross;
 }
 
+/* Count is an accumulator (Fenwick) tree over the positions of rank r+1.
+ * count_add adds v at position i; count_upto returns the total at positions
+ * 0 through i, so each lookup and update costs O(log n) rather than a scan
+ * of the rank.
+ */
+static void count_add(int *Count, int n, int i, int v)
+{
+    for (i++; i <= n; i += i & -i)
+	Count[i] += v;
+}
+
+static int count_upto(int *Count, int i)
+{
+    int sum = 0;
+
+    for (i++; i > 0; i -= i & -i)
+	sum += Count[i];
+    return sum;
+}
+
 static int rcross(graph_t * g, int r)
 {
     static int *Count, C;
-    int top, bot, cross, max, i, k;
+    int top, bot, cross, total, nbot, i;
     node_t **rtop, *v;
 
     cross = 0;
-    max = 0;
+    total = 0;
     rtop = GD_rank(g)[r].v;
+    nbot = GD_rank(g)[r + 1].n;
 
     if (C <= GD_rank(Root)[r + 1].n) {
 	C = GD_rank(Root)[r + 1].n + 1;
 	Count = ALLOC(C, Count, int);
     }
 
-    for (i = 0; i < GD_rank(g)[r + 1].n; i++)
+    for (i = 0; i <= nbot; i++)
 	Count[i] = 0;
 
+    /* an edge crosses every edge seen so far that ends further right */
     for (top = 0; top < GD_rank(g)[r].n; top++) {
 	edge_t *e;
-	if (max > 0) {
-	    for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-		for (k = ND_order(aghead(e)) + 1; k <= max; k++)
-		    cross += Count[k] * ED_xpenalty(e);
-	    }
+	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
+	    int right = total - count_upto(Count, ND_order(aghead(e)));
+	    cross += right * ED_xpenalty(e);
 	}
 	for (i = 0; (e = ND_out(rtop[top]).list[i]); i++) {
-	    int inv = ND_order(aghead(e));
-	    if (inv > max)
-		max = inv;
-	    Count[inv] += ED_xpenalty(e);
+	    count_add(Count, nbot, ND_order(aghead(e)), ED_xpenalty(e));
+	    total += ED_xpenalty(e);
 	}
     }
     for (top = 0; top < GD_rank(g)[r].n; top++) {
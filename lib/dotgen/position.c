@@ -19,10 +19,16 @@
 
 #include <dotgen/dot.h>
 #include <dotgen/aspect.h>
+#include <cgraph/strcasecmp.h>
+#include <ctype.h>
+#include <math.h>
 #include <stdbool.h>
 
 static int nsiter2(graph_t * g);
-static void create_aux_edges(graph_t * g);
+static int xrank(graph_t * g);
+static void create_aux_edges(graph_t * g, bool bk);
+static void make_edge_pairs(graph_t * g);
+static void compress_graph(graph_t * g);
 static void remove_aux_edges(graph_t * g);
 static void set_xcoords(graph_t * g);
 static void set_ycoords(graph_t * g);
@@ -126,10 +132,18 @@ void dot_position(graph_t * g, aspect_t* asp)
     expand_leaves(g);
     if (flat_edges(g))
 	set_ycoords(g);
-    create_aux_edges(g);
-    if (rank(g, 2, nsiter2(g))) { /* LR balance == 2 */
+    const char *xcoord = agget(g, "xcoord");
+    bool bk = xcoord && strcasecmp(xcoord, "bk") == 0;
+    create_aux_edges(g, bk);
+    if (bk && bk_xcoord(g)) {
+	/* fall back to network simplex */
+	make_edge_pairs(g);
+	compress_graph(g);
+	bk = false;
+    }
+    if (!bk && xrank(g)) {
 	connectGraph (g);
-	const int rank_result = rank(g, 2, nsiter2(g));
+	const int rank_result = xrank(g);
 	assert(rank_result == 0);
     }
     set_xcoords(g);
@@ -149,6 +163,20 @@ static int nsiter2(graph_t * g)
     return maxiter;
 }
 
+/* xrank:
+ * Solve the auxiliary graph for the x coordinates using LR balance.
+ * If nswarm is set, the initial placement made by make_LR_constraints,
+ * which follows an earlier layout where the nodes have a pos, is kept as
+ * the starting solution of network simplex instead of being recomputed
+ * from scratch.
+ */
+static int xrank(graph_t * g)
+{
+    if (mapbool(agget(g, "nswarm")))
+	return rank_warm(g, 2, nsiter2(g));
+    return rank(g, 2, nsiter2(g));
+}
+
 static int go(node_t * u, node_t * v)
 {
     int i;
@@ -205,10 +233,198 @@ static void allocate_aux_edges(graph_t * g)
     }
 }
 
+/* dot_prev_coord:
+ * Read the pos attribute sym of n, as written by an earlier layout, and
+ * map it back to the coordinates dot works in, where ranks run down the y
+ * axis. The translation of that drawing is not undone, so the result is
+ * only meaningful relative to other nodes of the same graph.
+ * Returns false if n has no pos.
+ */
+bool dot_prev_coord(graph_t * g, Agsym_t * sym, node_t * n, pointf * p)
+{
+    if (sscanf(agxget(n, sym), "%lf,%lf", &p->x, &p->y) != 2)
+	return false;
+    if (Y_invert)
+	p->y = -p->y;
+    *p = cwrotatepf(*p, 90 * GD_rankdir(agroot(g)));
+    return true;
+}
+
+/* prev_edge_x:
+ * Find where the first spline in the pos attribute sym of e, as written
+ * by an earlier layout, crosses y, following its control polygon. The
+ * coordinates are mapped as in dot_prev_coord.
+ * Returns false if e has no pos or its spline does not reach y.
+ */
+static bool prev_edge_x(graph_t * g, Agsym_t * sym, edge_t * e, double y,
+			double *x)
+{
+    char *s = agxget(e, sym);
+    pointf p, q = {0, 0};
+    bool have_q = false;
+    int n;
+
+    for (;;) {
+	while (isspace((int)*s))
+	    s++;
+	if ((*s == 'e' || *s == 's') && s[1] == ',') {
+	    /* skip the arrowhead endpoints */
+	    if (sscanf(s + 2, "%lf,%lf%n", &p.x, &p.y, &n) < 2)
+		return false;
+	    s += 2 + n;
+	    continue;
+	}
+	if (sscanf(s, "%lf,%lf%n", &p.x, &p.y, &n) < 2)
+	    return false;
+	s += n;
+	if (Y_invert)
+	    p.y = -p.y;
+	p = cwrotatepf(p, 90 * GD_rankdir(agroot(g)));
+	if (have_q && q.y != p.y && (q.y - y) * (p.y - y) <= 0) {
+	    *x = q.x + (p.x - q.x) * (y - q.y) / (p.y - q.y);
+	    return true;
+	}
+	q = p;
+	have_q = true;
+    }
+}
+
+/* dot_prev_chain:
+ * Follow the fast edge e from a real node down the chain of virtual nodes
+ * it starts, storing up to max of them in chain. If the chain ends at a
+ * real node and both ends have a pos from an earlier layout, set x[i] to
+ * the x at which the old spline of the edge crossed the rank of chain[i],
+ * or failing that, to a point on the line between the ends.
+ * Returns the number of nodes set, or 0 if the chain could not be placed.
+ */
+int dot_prev_chain(graph_t * g, edge_t * e, node_t ** chain, double *x,
+		   int max)
+{
+    graph_t *root = agroot(g);
+    Agsym_t *sym = agattr(root, AGNODE, "pos", NULL);
+    Agsym_t *esym = agattr(root, AGEDGE, "pos", NULL);
+    node_t *u = agtail(e), *w;
+    edge_t *orig;
+    pointf p0, p1;
+    int i, n = 0;
+
+    for (w = aghead(e); ND_node_type(w) == VIRTUAL
+	 && ND_ranktype(w) != CLUSTER && ND_out(w).size == 1 && n < max;
+	 w = aghead(ND_out(w).list[0]))
+	chain[n++] = w;
+    if (n == 0 || !sym || ND_node_type(u) != NORMAL
+	|| ND_node_type(w) != NORMAL || !dot_prev_coord(g, sym, u, &p0)
+	|| !dot_prev_coord(g, sym, w, &p1))
+	return 0;
+    for (orig = e; ED_to_orig(orig); orig = ED_to_orig(orig));
+    for (i = 0; i < n; i++) {
+	double t = (double)(ND_rank(chain[i]) - ND_rank(u)) /
+	    (ND_rank(w) - ND_rank(u));
+	if (!esym || ED_edge_type(orig) != NORMAL
+	    || !prev_edge_x(g, esym, orig, p0.y + t * (p1.y - p0.y), &x[i]))
+	    x[i] = p0.x + t * (p1.x - p0.x);
+    }
+    return n;
+}
+
+/* free_seed:
+ * Free the result of seed_xs.
+ */
+static void free_seed(graph_t * g, double **seed)
+{
+    int i;
+
+    for (i = 0; i <= GD_maxrank(g) - GD_minrank(g); i++)
+	free(seed[i]);
+    free(seed);
+}
+
+/* seed_xs:
+ * If nswarm is set, return for each rank the x its nodes had in an
+ * earlier layout, indexed by order, or NAN where that is not known. Real
+ * nodes take the x of their pos, and the virtual nodes of edges between
+ * them the x given by dot_prev_chain. The values are shifted to be at
+ * least 0. Rank i is at index i - GD_minrank(g); GD_minrank is -1 when
+ * flat edge labels added a rank above rank 0. This must run on the fast
+ * graph, before the aux edges replace it.
+ * Returns NULL if nswarm is not set or no node has a pos.
+ */
+static double **seed_xs(graph_t * g)
+{
+    rank_t *rank = GD_rank(g);
+    Agsym_t *sym;
+    double **seed, *x;
+    double least = HUGE_VAL;
+    node_t *u, *v, **chain;
+    edge_t *e;
+    pointf p;
+    int i, j, k, n;
+    int r0 = GD_minrank(g);
+    int maxn = GD_maxrank(g) - r0 + 1;
+
+    if (!mapbool(agget(g, "nswarm"))
+	|| !(sym = agattr(agroot(g), AGNODE, "pos", NULL)))
+	return NULL;
+    seed = N_NEW(maxn, double *);
+    for (i = r0; i <= GD_maxrank(g); i++) {
+	seed[i - r0] = N_NEW(rank[i].n + 1, double);
+	for (j = 0; j < rank[i].n; j++) {
+	    v = rank[i].v[j];
+	    seed[i - r0][j] = NAN;
+	    if (ND_node_type(v) == NORMAL && dot_prev_coord(g, sym, v, &p))
+		seed[i - r0][j] = p.x;
+	}
+    }
+
+    chain = N_NEW(maxn, node_t *);
+    x = N_NEW(maxn, double);
+    for (i = r0; i <= GD_maxrank(g); i++) {
+	for (j = 0; j < rank[i].n; j++) {
+	    u = rank[i].v[j];
+	    if (ND_node_type(u) != NORMAL || isnan(seed[i - r0][j]))
+		continue;
+	    for (k = 0; (e = ND_out(u).list[k]); k++) {
+		n = dot_prev_chain(g, e, chain, x, maxn);
+		while (n-- > 0)
+		    seed[ND_rank(chain[n]) - r0][ND_order(chain[n])] = x[n];
+	    }
+	}
+    }
+    free(chain);
+    free(x);
+
+    for (i = r0; i <= GD_maxrank(g); i++)
+	for (j = 0; j < rank[i].n; j++)
+	    if (!isnan(seed[i - r0][j]))
+		least = MIN(least, seed[i - r0][j]);
+    if (least == HUGE_VAL) {
+	free_seed(g, seed);
+	return NULL;
+    }
+    for (i = r0; i <= GD_maxrank(g); i++)
+	for (j = 0; j < rank[i].n; j++)
+	    seed[i - r0][j] -= least;
+    return seed;
+}
+
+/* seed_x:
+ * Return the initial x of a node: least, or its seed if that is further
+ * right.
+ */
+static int seed_x(double seed, int least)
+{
+    if (!isnan(seed) && seed > least)
+	return ROUND(seed);
+    return least;
+}
+
 /* make_LR_constraints:
+ * Also set an initial x for each node, packing each rank from the left.
+ * Given a seed from seed_xs, nodes start at their seed x instead where
+ * that does not overlap the node to their left.
  */
 static void 
-make_LR_constraints(graph_t * g)
+make_LR_constraints(graph_t * g, double **seed)
 {
     int i, j, k;
     int sw;			/* self width */
@@ -232,6 +448,9 @@ make_LR_constraints(graph_t * g)
     for (i = GD_minrank(g); i <= GD_maxrank(g); i++) {
 	double last;
 	last = ND_rank(rank[i].v[0]) = 0;
+	if (seed)
+	    last = ND_rank(rank[i].v[0]) =
+		seed_x(seed[i - GD_minrank(g)][0], 0);
 	nodesep = sep[i & 1];
 	for (j = 0; j < rank[i].n; j++) {
 	    u = rank[i].v[j];
@@ -258,6 +477,9 @@ make_LR_constraints(graph_t * g)
 		width = ND_rw(u) + ND_lw(v) + nodesep;
 		e0 = make_aux_edge(u, v, width, 0);
 		last = (ND_rank(v) = last + width);
+		if (seed)
+		    last = ND_rank(v) =
+			seed_x(seed[i - GD_minrank(g)][j + 1], ND_rank(v));
 	    }
 
 	    /* constraints from labels of flat edges on previous rank */
@@ -526,13 +748,23 @@ static void compress_graph(graph_t * g)
     make_aux_edge(GD_ln(g), GD_rn(g), x, 1000);
 }
 
-static void create_aux_edges(graph_t * g)
+/* create_aux_edges:
+ * Brandes-Köpf placement only needs the constraints; the edge pairs that
+ * make up the network simplex objective are left out.
+ */
+static void create_aux_edges(graph_t * g, bool bk)
 {
+    double **seed = seed_xs(g);
+
     allocate_aux_edges(g);
-    make_LR_constraints(g);
-    make_edge_pairs(g);
+    make_LR_constraints(g, seed);
+    if (seed)
+	free_seed(g, seed);
+    if (!bk)
+	make_edge_pairs(g);
     pos_clusters(g);
-    compress_graph(g);
+    if (!bk)
+	compress_graph(g);
 }
 
 static void remove_aux_edges(graph_t * g)
@@ -25,6 +25,7 @@
 
 #include	<dotgen/dot.h>
 #include	<limits.h>
+#include	<stdbool.h>
 
 static void dot1_rank(graph_t * g, aspect_t* asp);
 static void dot2_rank(graph_t * g, aspect_t* asp);
@@ -376,18 +377,78 @@ minmax_edges2(graph_t * g, point slen)
     return (e != 0);
 }
 
+/* order y values decreasingly, the order of their ranks */
+static int cmpy(const void *a, const void *b)
+{
+    const double *y0 = a, *y1 = b;
+
+    if (*y0 > *y1)
+	return -1;
+    if (*y0 < *y1)
+	return 1;
+    return 0;
+}
+
+/* seed_ranks:
+ * If nswarm is set and the nodes of g have a pos from an earlier layout,
+ * set the rank of each set leader to its rank in that layout, for
+ * rank_warm to start from. The nodes of a rank share one y, so the
+ * distinct values of y over all nodes of g, from the top, number the
+ * ranks; ranks holding only edge labels have no nodes and are restored by
+ * doubling. Ranks holding only virtual nodes are lost, which rank_warm
+ * repairs.
+ * Returns true if any node was seeded.
+ */
+static bool seed_ranks(graph_t * g)
+{
+    graph_t *root = agroot(g);
+    Agsym_t *sym;
+    double *ys, *y;
+    node_t *n;
+    pointf p;
+    int i, cnt = 0, nys = 0;
+    int step = (GD_has_labels(root) & EDGE_LABEL) ? 2 : 1;
+
+    if (!mapbool(agget(root, "nswarm"))
+	|| !(sym = agattr(root, AGNODE, "pos", NULL)))
+	return false;
+    ys = N_NEW(agnnodes(g), double);
+    for (n = agfstnode(g); n; n = agnxtnode(g, n))
+	if (dot_prev_coord(g, sym, n, &p))
+	    ys[nys++] = p.y;
+    qsort(ys, nys, sizeof(double), cmpy);
+    for (i = 0; i < nys; i++)
+	if (cnt == 0 || ys[i] != ys[cnt - 1])
+	    ys[cnt++] = ys[i];
+    nys = cnt;
+    cnt = 0;
+    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
+	if (n == UF_find(n) && dot_prev_coord(g, sym, n, &p)) {
+	    y = bsearch(&p.y, ys, nys, sizeof(double), cmpy);
+	    ND_rank(n) = step * (int)(y - ys);
+	    cnt++;
+	}
+    }
+    free(ys);
+    return cnt > 0;
+}
+
 /* Run the network simplex algorithm on each component. */
 void rank1(graph_t * g)
 {
     int maxiter = INT_MAX;
     int c;
     char *s;
+    bool warm = seed_ranks(g);
 
     if ((s = agget(g, "nslimit1")))
 	maxiter = atof(s) * agnnodes(g);
     for (c = 0; c < GD_comp(g).size; c++) {
 	GD_nlist(g) = GD_comp(g).list[c];
-	rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
+	if (warm)
+	    rank_warm(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);
+	else
+	    rank(g, (GD_n_cluster(g) == 0 ? 1 : 0), maxiter);	/* TB balance */
     }
 }
 
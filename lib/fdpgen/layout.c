@@ -797,6 +797,57 @@ setClustNodes(graph_t* root)
     }
 }
 
+static int layout(graph_t * g, layout_info * infop);
+
+/* state for fdpComponent */
+typedef struct {
+    graph_t *g;			/* graph being laid out */
+    layout_info *infop;
+    xparams xpms;		/* parameters, shared as in fdp_tLayout */
+} fdp_args;
+
+/* fdpComponent:
+ * Lay out one connected component cg of a derived graph, recursively
+ * laying out the clusters it contains.
+ */
+static int fdpComponent(graph_t * cg, int i, void *state)
+{
+    fdp_args *args = state;
+    layout_info *infop = args->infop;
+    graph_t *sg;
+    node_t *n;
+    node_t* nxtnode;
+
+    (void)i;
+    fdp_tLayout(cg, &args->xpms);
+    for (n = agfstnode(cg); n; n = nxtnode) {
+	nxtnode = agnxtnode(cg, n);
+	if (ND_clust(n)) {
+	    pointf pt;
+	    sg = expandCluster(n, cg);	/* attach ports to sg */
+	    int r = layout(sg, infop);
+	    if (r != 0) {
+		return r;
+	    }
+	    ND_width(n) = BB(sg).UR.x;
+	    ND_height(n) = BB(sg).UR.y;
+	    pt.x = POINTS_PER_INCH * BB(sg).UR.x;
+	    pt.y = POINTS_PER_INCH * BB(sg).UR.y;
+	    ND_rw(n) = ND_lw(n) = pt.x/2;
+	    ND_ht(n) = pt.y;
+	} else if (IS_PORT(n))
+	    agdelete(cg, n);	/* remove ports from component */
+    }
+
+    /* Remove overlaps */
+    if (agnnodes(cg) >= 2) {
+	if (args->g == infop->rootg)
+	    normalize (cg);
+	fdp_xLayout(cg, &args->xpms);
+    }
+    return 0;
+}
+
 /* layout:
  * Given g with ports:
  *  Derive g' from g by reducing clusters to points (deriveGraph)
@@ -830,13 +881,10 @@ static int layout(graph_t * g, layout_info * infop)
     graph_t *dg;
     node_t *dn;
     node_t *n;
-    graph_t *cg;
     graph_t *sg;
     graph_t **cc;
-    graph_t **pg;
     int c_cnt;
     int pinned;
-    xparams xpms;
 
 #ifdef DEBUG
     incInd();
@@ -855,36 +903,12 @@ static int layout(graph_t * g, layout_info * infop)
     if (dg == NULL) {
 	return -1;
     }
-    cc = pg = findCComp(dg, &c_cnt, &pinned);
-
-    while ((cg = *pg++)) {
-	node_t* nxtnode;
-	fdp_tLayout(cg, &xpms);
-	for (n = agfstnode(cg); n; n = nxtnode) {
-	    nxtnode = agnxtnode(cg, n);
-	    if (ND_clust(n)) {
-		pointf pt;
-		sg = expandCluster(n, cg);	/* attach ports to sg */
-		int r = layout(sg, infop);
-		if (r != 0) {
-                    return r;
-		}
-		ND_width(n) = BB(sg).UR.x;
-		ND_height(n) = BB(sg).UR.y;
-		pt.x = POINTS_PER_INCH * BB(sg).UR.x;
-		pt.y = POINTS_PER_INCH * BB(sg).UR.y;
-		ND_rw(n) = ND_lw(n) = pt.x/2;
-		ND_ht(n) = pt.y;
-	    } else if (IS_PORT(n))
-		agdelete(cg, n);	/* remove ports from component */
-	}
+    cc = findCComp(dg, &c_cnt, &pinned);
 
-	/* Remove overlaps */
-	if (agnnodes(cg) >= 2) {
-	    if (g == infop->rootg)
-		normalize (cg);
-	    fdp_xLayout(cg, &xpms);
-	}
+    fdp_args args = {.g = g, .infop = infop};
+    int r = layoutGraphs(c_cnt, cc, fdpComponent, &args);
+    if (r != 0) {
+	return r;
     }
 
     /* At this point, each connected component has its nodes correctly
@@ -1,7 +1,11 @@
 #include <cassert>
+#include <cstddef>
+#include <exception>
+#include <functional>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include "GVContext.h"
 #include "GVLayout.h"
@@ -63,4 +67,40 @@ GVRenderData GVLayout::render(const std::string &format) const {
   return GVRenderData(result, length);
 }
 
+namespace {
+
+struct RenderSink {
+  const std::function<void(std::string_view)> &sink;
+  std::exception_ptr error;
+};
+
+// forward output to the C++ sink, stopping at the first exception since it
+// cannot be allowed to propagate through the C code
+std::size_t write_to_sink(const char *data, std::size_t len, void *ctx) {
+  auto &sink = *static_cast<RenderSink *>(ctx);
+  try {
+    sink.sink(std::string_view{data, len});
+  } catch (...) {
+    sink.error = std::current_exception();
+    return 0;
+  }
+  return len;
+}
+
+} // namespace
+
+void GVLayout::render(
+    const std::string &format,
+    const std::function<void(std::string_view)> &sink) const {
+  RenderSink ctx{sink, nullptr};
+  const auto rc = gvRenderCallback(m_gvc->c_struct(), m_g->c_struct(),
+                                   format.c_str(), write_to_sink, &ctx);
+  if (ctx.error) {
+    std::rethrow_exception(ctx.error);
+  }
+  if (rc) {
+    throw std::runtime_error("Rendering failed");
+  }
+}
+
 } // namespace GVC
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string_view>
 
 #include "GVContext.h"
 #include "GVRenderData.h"
@@ -44,6 +46,11 @@ public:
   // render the layout in the specified format
   GVRenderData render(const std::string &format) const;
 
+  // render the layout in the specified format, passing the output to the sink
+  // in chunks as it is produced instead of collecting it in memory
+  void render(const std::string &format,
+              const std::function<void(std::string_view)> &sink) const;
+
 private:
   std::shared_ptr<GVContext> m_gvc;
   std::shared_ptr<CGraph::AGraph> m_g;
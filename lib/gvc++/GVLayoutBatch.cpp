@@ -0,0 +1,39 @@
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GVContext.h"
+#include "GVLayout.h"
+#include "GVLayoutBatch.h"
+#include "GVRenderData.h"
+#include <cgraph++/AGraph.h>
+
+namespace GVC {
+
+std::vector<GVBatchResult>
+layout_batch(const std::shared_ptr<GVContext> &gvc,
+             const std::vector<std::shared_ptr<CGraph::AGraph>> &graphs,
+             const std::string &engine, const std::string &format) {
+  std::vector<GVBatchResult> results;
+  results.reserve(graphs.size());
+
+  for (const auto &g : graphs) {
+    auto &result = results.emplace_back();
+    const auto start = std::chrono::steady_clock::now();
+    try {
+      const auto layout = GVLayout(gvc, g, engine);
+      // the layout is freed when it goes out of scope, but the rendered data
+      // is independent of it
+      result.data = std::make_unique<GVRenderData>(layout.render(format));
+    } catch (...) {
+      result.error = std::current_exception();
+    }
+    result.latency = std::chrono::steady_clock::now() - start;
+  }
+
+  return results;
+}
+
+} // namespace GVC
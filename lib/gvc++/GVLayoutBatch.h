@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GVContext.h"
+#include "GVRenderData.h"
+#include <cgraph++/AGraph.h>
+
+#ifdef _WIN32
+#if gvc___EXPORTS // CMake's substitution of gvc++_EXPORTS
+#define GVLAYOUTBATCH_API __declspec(dllexport)
+#else
+#define GVLAYOUTBATCH_API __declspec(dllimport)
+#endif
+#else
+#define GVLAYOUTBATCH_API /* nothing */
+#endif
+
+namespace GVC {
+
+/**
+ * @brief The GVBatchResult struct holds the outcome of laying out and
+ * rendering one graph of a batch
+ */
+
+struct GVLAYOUTBATCH_API GVBatchResult {
+  // the rendered layout, or null if layout or rendering failed
+  std::unique_ptr<GVRenderData> data;
+  // the exception thrown by layout or rendering, if any
+  std::exception_ptr error;
+  // wall clock time spent on layout and rendering of this graph
+  std::chrono::steady_clock::duration latency{};
+};
+
+/**
+ * @brief Lay out each graph with the given engine and render it in the given
+ * format, reusing a single context for the whole batch.
+ *
+ * A failure in one graph is recorded in its result and does not affect the
+ * others. The results are in the same order as the graphs.
+ */
+GVLAYOUTBATCH_API std::vector<GVBatchResult>
+layout_batch(const std::shared_ptr<GVContext> &gvc,
+             const std::vector<std::shared_ptr<CGraph::AGraph>> &graphs,
+             const std::string &engine, const std::string &format);
+
+} // namespace GVC
+
+#undef GVLAYOUTBATCH_API
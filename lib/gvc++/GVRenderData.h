@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <string_view>
+#include <utility>
 
 #ifdef _WIN32
 #if gvc___EXPORTS // CMake's substitution of gvc++_EXPORTS
@@ -31,10 +32,16 @@ public:
   GVRenderData(GVRenderData &) = delete;
   GVRenderData &operator=(GVRenderData &) = delete;
 
-  // delete move for now since we cannot use default because we manage a C
-  // string using a raw pointer
-  GVRenderData(GVRenderData &&) = delete;
-  GVRenderData &operator=(GVRenderData &&) = delete;
+  // moving transfers ownership of the C string, leaving the source empty
+  GVRenderData(GVRenderData &&other) noexcept
+      : m_data(std::exchange(other.m_data, nullptr)),
+        m_length(std::exchange(other.m_length, 0)) {}
+  GVRenderData &operator=(GVRenderData &&other) noexcept {
+    using std::swap;
+    swap(m_data, other.m_data);
+    swap(m_length, other.m_length);
+    return *this;
+  }
 
   // get the rendered string as a C string. The string is null terminated, but
   // that is not useful for binary formats. Combine with the length method for
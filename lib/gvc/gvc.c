@@ -17,7 +17,10 @@
 #include <gvc/gvcproc.h>
 #include <gvc/gvconfig.h>
 #include <gvc/gvio.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 GVC_t *gvContext(void)
 {
@@ -222,6 +225,88 @@ int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result, unsi
     return rc;
 }
 
+/* State of a gvRenderCallback call. Output is collected in buf and passed
+ * to the caller whenever it fills, so the caller sees a few large writes
+ * rather than one per gvputs.
+ */
+typedef struct {
+    size_t (*write_fn)(const char *data, size_t len, void *ctx);
+    void *ctx;
+    bool failed;
+    size_t len;
+    char buf[BUFSIZ];
+} render_sink_t;
+
+static void render_sink_flush(render_sink_t *sink)
+{
+    if (sink->len > 0 && !sink->failed
+	&& sink->write_fn(sink->buf, sink->len, sink->ctx) != sink->len)
+	sink->failed = true;
+    sink->len = 0;
+}
+
+static size_t render_sink_write(GVJ_t *job, const char *s, size_t len)
+{
+    render_sink_t *sink = job->gvc->render_sink;
+
+    if (sink->len + len > sizeof(sink->buf))
+	render_sink_flush(sink);
+    if (len >= sizeof(sink->buf)) {
+	if (!sink->failed && sink->write_fn(s, len, sink->ctx) != len)
+	    sink->failed = true;
+    } else {
+	memcpy(sink->buf + sink->len, s, len);
+	sink->len += len;
+    }
+    /* always claim success, as gvwrite exits on a short write */
+    return len;
+}
+
+/* Render layout in a specified format to a caller-supplied write function */
+int gvRenderCallback(GVC_t *gvc, graph_t *g, const char *format,
+                     size_t (*write_fn)(const char *data, size_t len,
+                                        void *ctx),
+                     void *ctx)
+{
+    int rc;
+    GVJ_t *job;
+    render_sink_t sink = {.write_fn = write_fn, .ctx = ctx};
+    size_t (*old_write_fn)(GVJ_t *job, const char *s, size_t len);
+
+    g = g->root;
+
+    /* create a job for the required format */
+    rc = gvjobs_output_langname(gvc, format);
+    job = gvc->job;
+    if (rc == NO_SUPPORT) {
+	agerr(AGERR, "Format: \"%s\" not recognized. Use one of:%s\n",
+                format, gvplugin_list(gvc, API_device, format));
+	return -1;
+    }
+
+    job->output_lang = gvrender_select(job, job->output_langname);
+    if (!LAYOUT_DONE(g) && !(job->flags & LAYOUT_NOT_REQUIRED)) {
+	agerrorf( "Layout was not done\n");
+	return -1;
+    }
+
+    old_write_fn = gvc->write_fn;
+    gvc->write_fn = render_sink_write;
+    gvc->render_sink = &sink;
+
+    rc = gvRenderJobs(gvc, g);
+    gvrender_end_job(job);
+    gvjobs_delete(gvc);
+
+    render_sink_flush(&sink);
+    gvc->write_fn = old_write_fn;
+    gvc->render_sink = NULL;
+
+    if (rc == 0 && sink.failed)
+	rc = -1;
+    return rc;
+}
+
 /* gvFreeRenderData:
  * Utility routine to free memory allocated in gvRenderData, as the application code may use
  * a different runtime library.
@@ -85,6 +85,15 @@ GVC_API int gvRenderContext(GVC_t *gvc, graph_t *g, const char *format, void *co
 /* Render layout in a specified format to a malloc'ed string */
 GVC_API int gvRenderData(GVC_t *gvc, graph_t *g, const char *format, char **result, unsigned int *length);
 
+/* Render layout in a specified format, passing the output to write_fn in
+ * chunks as it is produced instead of collecting it in memory. write_fn must
+ * return len on success; any other value stops further output and makes
+ * gvRenderCallback return -1. */
+GVC_API int gvRenderCallback(GVC_t *gvc, graph_t *g, const char *format,
+                             size_t (*write_fn)(const char *data, size_t len,
+                                                void *ctx),
+                             void *ctx);
+
 /* Free memory allocated and pointed to by *result in gvRenderData */
 GVC_API void gvFreeRenderData (char* data);
 
@@ -87,6 +87,8 @@ extern "C" {
 
         /* externally provided write() displine */
 	size_t (*write_fn) (GVJ_t *job, const char *s, size_t len);
+	/* caller's sink while gvRenderCallback is running */
+	void *render_sink;
 
 	/* fonts and textlayout */
 	Dtdisc_t textfont_disc;
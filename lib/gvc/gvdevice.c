@@ -133,6 +133,9 @@ int gvdevice_initialize(GVJ_t * job)
     }
     else if (job->output_data) {
     }
+    else if (gvc->write_fn && gvc->render_sink) {
+	/* output goes to the gvRenderCallback sink */
+    }
     /* if the device has no initialization then it uses file output */
     else if (!job->output_file) {        /* if not yet opened */
         if (gvc->common.auto_outfile_names)
@@ -22,6 +22,8 @@ typedef struct {
 } Agraph_t;
 
 extern void agsetfile(const char *);
+extern int agmapfile(void *);
+extern void agunmapfile(void *);
 
 #include <ingraphs/ingraphs.h>
 
@@ -144,13 +146,20 @@ newIngGraphs(ingraph_state * sp , Agraph_t** graphs, ingdisc *disc)
     return new_ing(sp, 0, graphs, disc);
 }
 
+/* Named files are mapped when possible, so that readers using cgraph's
+ * default I/O discipline parse them from memory.
+ */
 static void *dflt_open(char *f)
 {
-    return fopen(f, "r");
+    FILE *fp = fopen(f, "r");
+    if (fp)
+	agmapfile(fp);
+    return fp;
 }
 
 static int dflt_close(void *fp)
 {
+    agunmapfile(fp);
     return fclose(fp);
 }
 
@@ -660,67 +660,48 @@ double *getSizes(Agraph_t * g, pointf pad, int* n_elabels, int** elabels)
 SparseMatrix makeMatrix(Agraph_t* g, SparseMatrix *D)
 {
     SparseMatrix A = 0;
-    Agnode_t *n;
-    Agedge_t *e;
+    Agcsr_t *csr;
     Agsym_t *sym;
-    int nnodes;
-    int nedges;
-    int i, row;
-    int *I;
-    int *J;
+    int i;
     double *val;
-    double v;
     int type = MATRIX_TYPE_REAL;
     Agsym_t* symD = NULL;
     double* valD = NULL;
 
     if (!g)
 	return NULL;
-    nnodes = agnnodes(g);
-    nedges = agnedges(g);
+    sym = agfindedgeattr(g, "weight");
+    if (!(csr = agcsr(g, sym, 1)))
+	return NULL;
 
     /* Assign node ids */
-    i = 0;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n))
-	ND_id(n) = i++;
+    for (i = 0; i < csr->nnodes; i++)
+	ND_id(csr->nodes[i]) = i;
 
-    I = N_GNEW(nedges, int);
-    J = N_GNEW(nedges, int);
-    val = N_GNEW(nedges, double);
-
-    sym = agfindedgeattr(g, "weight");
-    if (D) {
-	symD = agfindedgeattr(g, "len");
-	valD = N_NEW(nedges, double);
+    if (!(val = csr->weight)) {
+	val = N_GNEW(csr->nedges, double);
+	for (i = 0; i < csr->nedges; i++)
+	    val[i] = 1;
     }
-
-    i = 0;
-    for (n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	row = ND_id(n);
-	for (e = agfstout(g, n); e; e = agnxtout(g, e)) {
-	    I[i] = row;
-	    J[i] = ND_id(aghead(e));
-	    if (!sym || sscanf(agxget(e, sym), "%lf", &v) != 1)
-		v = 1;
-	    val[i] = v;
+    if (D) {
 	/* edge length */
-	    if (symD) {
-		if (sscanf (agxget (e, symD), "%lf", &v) != 1) v = 1;
-		valD[i] = v;
-	    }
-	    i++;
-	}
+	symD = agfindedgeattr(g, "len");
+	if (symD)
+	    valD = agcsrcolumn(csr, symD, 1);
+	else
+	    valD = N_NEW(csr->nedges, double);
     }
 
-    A = SparseMatrix_from_coordinate_arrays(nedges, nnodes, nnodes, I, J,
+    A = SparseMatrix_from_coordinate_arrays(csr->nedges, csr->nnodes,
+					    csr->nnodes, csr->tail, csr->head,
 					    val, type, sizeof(double));
 
-    if (D) *D = SparseMatrix_from_coordinate_arrays(nedges, nnodes, nnodes, I, J, valD, type, sizeof(double));
+    if (D) *D = SparseMatrix_from_coordinate_arrays(csr->nedges, csr->nnodes, csr->nnodes, csr->tail, csr->head, valD, type, sizeof(double));
 
-    free(I);
-    free(J);
-    free(val);
+    if (val != csr->weight)
+	free(val);
     free (valD);
+    agcsrfree(csr);
 
     return A;
 }
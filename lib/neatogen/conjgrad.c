@@ -163,11 +163,12 @@ cleanup1:
 
 int
 conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
-			   double tol, int max_iterations)
+			   double tol, int max_iterations, int nthreads)
 {
     /* Solves Ax=b using Conjugate-Gradients method */
     /* A is a packed symmetric matrix */
     /* matrux A is "packed" (only upper triangular portion exists, row-major); */
+    /* the products with A are shared out between nthreads threads */
 
     int i, rv = 0;
 
@@ -181,7 +182,7 @@ conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
     orthog1f(n, x);
     orthog1f(n, b);
 
-    right_mult_with_vector_ff(A, n, x, Ax);
+    right_mult_with_vectors_ff(A, n, 1, &x, &Ax, nthreads);
     /* centering Ax */
     orthog1f(n, Ax);
 
@@ -196,7 +197,7 @@ conjugate_gradient_mkernel(float *A, float *x, float *b, int n,
 	orthog1f(n, x);
 	orthog1f(n, r);
 
-	right_mult_with_vector_ff(A, n, p, Ap);
+	right_mult_with_vectors_ff(A, n, 1, &p, &Ap, nthreads);
 	/* centering Ap */
 	orthog1f(n, Ap);
 
@@ -31,7 +31,7 @@ extern "C" {
 				     double, int, boolean);
 
     extern int conjugate_gradient_mkernel(float *, float *, float *, int,
-					   double, int);
+					   double, int, int);
 
 #ifdef __cplusplus
 }
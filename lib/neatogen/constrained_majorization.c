@@ -96,7 +96,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
     if (!directionalityExist) {
 	return stress_majorization_kD_mkernel(graph, n, nedges_graph,
 					      d_coords, nodes, dim, opts,
-					      model, maxi);
+					      model, maxi, 1);
     }
 
 	/******************************************************************
@@ -110,7 +110,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    /* the dim==2 case is handled below                      */
 	    if (stress_majorization_kD_mkernel(graph, n, nedges_graph,
 					   d_coords + 1, nodes, dim - 1,
-					   opts, model, 15) < 0)
+					   opts, model, 15, 1) < 0)
 		return -1;
 	    /* now copy the y-axis into the (dim-1)-axis */
 	    for (i = 0; i < n; i++) {
@@ -133,7 +133,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    /* no hierarchy found, use faster algorithm */
 	    return stress_majorization_kD_mkernel(graph, n, nedges_graph,
 						  d_coords, nodes, dim,
-						  opts, model, maxi);
+						  opts, model, maxi, 1);
 	}
 
 	if (levels_gap > 0) {
@@ -487,7 +487,7 @@ int stress_majorization_with_hierarchy(vtx_data * graph,	/* Input graph in spars
 	    } else {
 		/* use conjugate gradient for all dimensions except y */
 		if (conjugate_gradient_mkernel(lap2, coords[k], b[k], n,
-					   conj_tol, n)) {
+					   conj_tol, n, 1)) {
 		    iterations = -1;
 		    goto finish;
 		}
@@ -428,7 +428,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	     * optimisation which should be considerably faster
 	     */
 	    if (conjugate_gradient_mkernel(lap2, coords[0], b[0], n,
-				       tolerance_cg, n) < 0) {
+				       tolerance_cg, n, 1) < 0) {
 		iterations = -1;
 		goto finish;
 	    }
@@ -451,7 +451,7 @@ int stress_majorization_cola(vtx_data * graph,	/* Input graph in sparse represen
 	    }
 	} else {
 	    conjugate_gradient_mkernel(lap2, coords[1], b[1], n,
-				       tolerance_cg, n);
+				       tolerance_cg, n, 1);
 	}
     }
     if (Verbose) {
@@ -8,9 +8,11 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include "config.h"
 
 #include <neatogen/matrix_ops.h>
 #include <common/memory.h>
+#include <common/parallel.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
@@ -349,9 +351,12 @@ right_mult_with_vector(vtx_data * matrix, int n, double *vector,
 
     double res;
     for (i = 0; i < n; i++) {
+	const int nedges = matrix[i].nedges;
+	const float *ewgts = matrix[i].ewgts;
+	const int *edges = matrix[i].edges;
 	res = 0;
-	for (j = 0; j < matrix[i].nedges; j++)
-	    res += matrix[i].ewgts[j] * vector[matrix[i].edges[j]];
+	for (j = 0; j < nedges; j++)
+	    res += ewgts[j] * vector[edges[j]];
 	result[i] = res;
     }
     /* orthog1(n,vector); */
@@ -512,6 +517,132 @@ void right_mult_with_vector_ff
     }
 }
 
+/* add rows lo, ..., hi - 1 of the packed matrix times each of the dim
+ * vectors to results
+ */
+static void packed_rows_mult(float *packed_matrix, int n, int dim,
+			     float **vectors, float **results, int lo, int hi)
+{
+    int i, j, k, index;
+    float vector_i;
+
+    float res;
+    index = lo * n - lo * (lo - 1) / 2;
+    for (i = lo; i < hi; index += n - i, i++) {
+	const float *row = packed_matrix + index;
+	for (k = 0; k < dim; k++) {
+	    const float *vector = vectors[k];
+	    float *result = results[k];
+	    res = 0;
+	    vector_i = vector[i];
+	    /* deal with main diag */
+	    res += row[0] * vector_i;
+	    /* deal with off diag */
+	    for (j = i + 1; j < n; j++) {
+		res += row[j - i] * vector[j];
+		result[j] += row[j - i] * vector_i;
+	    }
+	    result[i] += res;
+	}
+    }
+}
+
+/* a packed matrix product shared out between threads */
+typedef struct {
+    float *packed_matrix;
+    int n;
+    int dim;
+    float **vectors;
+    float ***results;		/* results of each part, zeroed. Those of part 0 are the output */
+} packed_mult_job;
+
+/* the rows of part t. Row i has n - i entries, so the parts get the same
+ * number of entries rather than of rows.
+ */
+static int packed_rows_start(int n, int t, int nthreads)
+{
+    double total = (double) n * (n + 1) / 2;
+    double target = total * t / nthreads;
+    int i = 0;
+    double done = 0;
+
+    while (i < n && done < target) {
+	done += n - i;
+	i++;
+    }
+    return i;
+}
+
+static void packed_mult_part(void *arg, int t, int nthreads)
+{
+    packed_mult_job *job = arg;
+
+    packed_rows_mult(job->packed_matrix, job->n, job->dim, job->vectors,
+		     job->results[t], packed_rows_start(job->n, t, nthreads),
+		     packed_rows_start(job->n, t + 1, nthreads));
+}
+
+/* add the results of parts 1, ..., nthreads - 1 to those of part 0, in that
+ * order, so the sums do not depend on the timing of the threads
+ */
+static void packed_mult_reduce(void *arg, int t, int nthreads)
+{
+    packed_mult_job *job = arg;
+    int k, i, s, lo, hi;
+
+    parallel_range(job->n, t, nthreads, &lo, &hi);
+    for (k = 0; k < job->dim; k++)
+	for (s = 1; s < nthreads; s++)
+	    for (i = lo; i < hi; i++)
+		job->results[0][k][i] += job->results[s][k][i];
+}
+
+/* right_mult_with_vectors_ff:
+ * Same as calling right_mult_with_vector_ff for each of the dim vectors,
+ * but sweeps the packed matrix only once. Each row is reused for all the
+ * vectors while it is still in cache, which matters for the O(n^2) stress
+ * Laplacians. The per-vector summation order is unchanged.
+ * With nthreads > 1, the rows are shared out between threads that each sum
+ * into their own copy of the results. The copies are added up in a fixed
+ * order, so the results are the same in every run with the same nthreads.
+ */
+void right_mult_with_vectors_ff(float *packed_matrix, int n, int dim,
+				float **vectors, float **results, int nthreads)
+{
+    int i, k, t;
+    packed_mult_job job;
+
+    for (k = 0; k < dim; k++) {
+	for (i = 0; i < n; i++) {
+	    results[k][i] = 0;
+	}
+    }
+    if (nthreads <= 1) {
+	packed_rows_mult(packed_matrix, n, dim, vectors, results, 0, n);
+	return;
+    }
+
+    job.packed_matrix = packed_matrix;
+    job.n = n;
+    job.dim = dim;
+    job.vectors = vectors;
+    job.results = N_GNEW(nthreads, float **);
+    job.results[0] = results;
+    for (t = 1; t < nthreads; t++) {
+	job.results[t] = N_GNEW(dim, float *);
+	for (k = 0; k < dim; k++)
+	    job.results[t][k] = N_GNEW(n, float);
+    }
+    parallel_run(nthreads, packed_mult_part, &job);
+    parallel_run(nthreads, packed_mult_reduce, &job);
+    for (t = 1; t < nthreads; t++) {
+	for (k = 0; k < dim; k++)
+	    free(job.results[t][k]);
+	free(job.results[t]);
+    }
+    free(job.results);
+}
+
 void
 vectors_substractionf(int n, float *vector1, float *vector2, float *result)
 {
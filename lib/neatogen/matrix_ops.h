@@ -58,6 +58,8 @@ extern "C" {
 
     extern void orthog1f(int n, float *vec);
     extern void right_mult_with_vector_ff(float *, int, float *, float *);
+    extern void right_mult_with_vectors_ff(float *, int, int, float **,
+					   float **, int);
     extern void vectors_substractionf(int, float *, float *, float *);
     extern void vectors_additionf(int n, float *vector1, float *vector2,
 				  float *result);
@@ -24,8 +24,14 @@
 #include <neatogen/digcola.h>
 #endif
 #include <neatogen/kkutils.h>
+#include <neatogen/bfs.h>
+#include <neatogen/dijkstra.h>
 #include <common/pointset.h>
 #include <neatogen/sgd.h>
+#ifdef SFDP
+#include <sparse/SparseMatrix.h>
+#include <sfdpgen/stress_model.h>
+#endif
 #include <cgraph/strcasecmp.h>
 
 #ifndef HAVE_SRAND48
@@ -657,6 +663,10 @@ static int neatoMode(graph_t * g)
 	    mode = MODE_MAJOR;
 	else if (streq(str, "sgd"))
 		mode = MODE_SGD;
+#ifdef SFDP
+	else if (streq(str, "sparse"))
+	    mode = MODE_SPARSE;
+#endif
 #ifdef DIGCOLA
 	else if (streq(str, "hier"))
 	    mode = MODE_HIER;
@@ -768,7 +778,8 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 {
     vtx_data *graph;
     node_t** nodes;
-    int ne = agnedges(g);	/* upper bound */
+    Agcsr_t *csr = agcsr(g, NULL, 0);
+    int ne = csr->nedges;	/* upper bound */
     int *edges;
     float *ewgts = NULL;
     node_t *np;
@@ -808,10 +819,13 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 	edists = N_GNEW(2*ne+nv,float);
 #endif
 
-    i = 0;
     ne = 0;
-    for (np = agfstnode(g); np; np = agnxtnode(g, np)) {
+    for (i = 0; i < csr->nnodes; i++) {
 	int j = 1;		/* index of neighbors */
+	int nout = csr->out[i + 1] - csr->out[i];
+	int deg = nout + csr->in[i + 1] - csr->in[i];
+	int k;
+	np = csr->nodes[i];
 	clearPM(ps);
 	assert(ND_id(np) == i);
 	nodes[i] = np;
@@ -833,9 +847,13 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 #endif
 	i_nedges = 1;		/* one for the self */
 
-	for (ep = agfstedge(g, np); ep; ep = agnxtedge(g, ep, np)) {
-	    if (aghead(ep) == agtail(ep))
+	/* out edges, then in edges, as agfstedge/agnxtedge visit them */
+	for (k = 0; k < deg; k++) {
+	    int x = k < nout ? csr->out[i] + k
+	                     : csr->in_edge[csr->in[i] + k - nout];
+	    if (csr->tail[x] == csr->head[x])
 		continue;	/* ignore loops */
+	    ep = csr->edges[x];
 	    idx = checkEdge(ps, ep, j);
 	    if (idx != j) {	/* seen before */
 		if (haveWt)
@@ -875,7 +893,6 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
 #ifdef USE_STYLES
 	graph[i].styles = NULL;
 #endif
-	i++;
     }
 #ifdef DIGCOLA
     if (haveDir) {
@@ -887,7 +904,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     ne /= 2;			/* every edge is counted twice */
 
     /* If necessary, release extra memory. */
-    if (ne != agnedges(g)) {
+    if (ne != csr->nedges) {
 	edges = RALLOC(2 * ne + nv, graph[0].edges, int);
 	if (haveLen)
 	    ewgts = RALLOC(2 * ne + nv, graph[0].ewgts, float);
@@ -915,6 +932,7 @@ static vtx_data *makeGraphData(graph_t * g, int nv, int *nedges, int mode, int m
     else
         free (nodes);
     freePM(ps);
+    agcsrfree(csr);
     return graph;
 }
 
@@ -1133,6 +1151,7 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
 #endif
     int init = checkStart(g, nv, mode == MODE_HIER ? INIT_SELF : INIT_RANDOM);
     int opts = checkExp (g);
+    int nthreads = late_int(g, agfindgraphattr(g, "threads"), 1, 1);
 
     if (init == INIT_SELF)
 	opts |= opt_smart_init;
@@ -1240,7 +1259,7 @@ majorization(graph_t *mg, graph_t * g, int nv, int mode, int model, int dim, adj
     }
     else
 #endif
-	rv = stress_majorization_kD_mkernel(gp, nv, ne, coords, nodes, Ndim, opts, model, MaxIter);
+	rv = stress_majorization_kD_mkernel(gp, nv, ne, coords, nodes, Ndim, opts, model, MaxIter, nthreads);
 
     if (rv < 0) {
 	agerr(AGPREV, "layout aborted\n");
@@ -1330,6 +1349,173 @@ static void kkNeato(Agraph_t * g, int nG, int model)
     solve_model(g, nG);
 }
 
+#ifdef SFDP
+/* addPivotDists:
+ * Append the shortest path distances from npivots pivots to all other nodes
+ * to the coordinate lists of a sparse distance matrix holding nz entries,
+ * and return the new number of entries. Pairs joined by an edge are
+ * already there and are skipped. As in embed_graph, each pivot is the node
+ * farthest from the pivots chosen before it.
+ */
+static int addPivotDists(vtx_data * graph, int n, int npivots, int nz,
+			 int *I, int *J, double *val)
+{
+    float *dist = N_GNEW(n, float);
+    float *mindist = N_GNEW(n, float);
+    bool *adjacent = N_NEW(n, bool);
+    bool *done = N_NEW(n, bool);	/* pivots whose distances are in */
+    bool weighted = graph[0].ewgts != NULL;
+    DistType *hops = NULL;
+    Queue Q;
+    int i, j, k, p = 0;
+
+    if (!weighted) {
+	hops = N_GNEW(n, DistType);
+	mkQueue(&Q, n);
+    }
+    for (i = 0; i < n; i++)
+	mindist[i] = MAXFLOAT;
+
+    for (k = 0; k < npivots; k++) {
+	float maxdist = -1;
+
+	if (weighted)
+	    dijkstra_f(p, graph, n, dist);
+	else {
+	    bfs(p, graph, n, hops, &Q);
+	    for (i = 0; i < n; i++)
+		dist[i] = hops[i];
+	}
+
+	for (j = 1; j < graph[p].nedges; j++)
+	    adjacent[graph[p].edges[j]] = true;
+	for (i = 0; i < n; i++) {
+	    /* pairs with an earlier pivot came in with that pivot */
+	    if (i == p || adjacent[i] || done[i] || dist[i] >= MAXFLOAT)
+		continue;
+	    I[nz] = p;
+	    J[nz] = i;
+	    val[nz++] = dist[i];
+	    I[nz] = i;
+	    J[nz] = p;
+	    val[nz++] = dist[i];
+	}
+	for (j = 1; j < graph[p].nedges; j++)
+	    adjacent[graph[p].edges[j]] = false;
+	done[p] = true;
+
+	for (i = 0; i < n; i++) {
+	    mindist[i] = MIN(mindist[i], dist[i]);
+	    if (!done[i] && mindist[i] > maxdist) {
+		maxdist = mindist[i];
+		p = i;
+	    }
+	}
+    }
+
+    if (!weighted) {
+	freeQueue(&Q);
+	free(hops);
+    }
+    free(done);
+    free(adjacent);
+    free(mindist);
+    free(dist);
+    return nz;
+}
+
+/* sparseStress:
+ * Solve stress using the sparse stress model shared with sfdp, over the
+ * pairs of nodes joined by an edge, with target distance len, and the
+ * pairs of a node and one of num_pivots_stress pivots, with their shortest
+ * path distance as target. Each term has weight 1/d^2. Memory and time per
+ * iteration grow with the number of nodes times the number of pivots,
+ * rather than with the square of the number of nodes as in majorization.
+ * Pinned nodes keep their position, as in majorization.
+ */
+static void sparseStress(graph_t * g, int nv)
+{
+    SparseMatrix D;
+    node_t *v;
+    edge_t *e;
+    vtx_data *gp;
+    int *mark = N_GNEW(nv, int);
+    int npivots = MIN(nv, num_pivots_stress);
+    int ne = 2 * agnedges(g) + 2 * npivots * nv;
+    int *I = N_GNEW(ne, int);
+    int *J = N_GNEW(ne, int);
+    double *val = N_GNEW(ne, double);
+    double *x;
+    bool *unfixed = N_NEW(nv, bool);
+    int i, nz = 0, flag, n_pinned = 0;
+
+    if (checkStart(g, nv, INIT_RANDOM) != INIT_REGULAR) {
+	for (v = agfstnode(g); v; v = agnxtnode(g, v))
+	    if (!hasPos(v))
+		randompos(v, 1);
+    }
+    for (v = agfstnode(g); v; v = agnxtnode(g, v)) {
+	unfixed[ND_id(v)] = !isFixed(v);
+	if (isFixed(v))
+	    n_pinned++;
+    }
+
+    /* Store each adjacent pair once in each direction, so multi-edges
+     * and anti-parallel edges do not add up their lengths.
+     */
+    for (i = 0; i < nv; i++)
+	mark[i] = -1;
+    for (v = agfstnode(g); v; v = agnxtnode(g, v)) {
+	int vi = ND_id(v);
+	for (e = agfstedge(g, v); e; e = agnxtedge(g, e, v)) {
+	    node_t *w = aghead(e) == v ? agtail(e) : aghead(e);
+	    int wi = ND_id(w);
+	    if (wi == vi || mark[wi] == vi)
+		continue;
+	    mark[wi] = vi;
+	    I[nz] = vi;
+	    J[nz] = wi;
+	    val[nz] = ED_dist(e);
+	    nz++;
+	}
+    }
+    gp = makeGraphData(g, nv, &ne, MODE_SPARSE, MODEL_SHORTPATH, NULL);
+    nz = addPivotDists(gp, nv, npivots, nz, I, J, val);
+    freeGraphData(gp);
+    D = SparseMatrix_from_coordinate_arrays(nz, nv, nv, I, J, val,
+					    MATRIX_TYPE_REAL, sizeof(double));
+    free(mark);
+    free(I);
+    free(J);
+    free(val);
+
+    x = N_GNEW(nv * Ndim, double);
+    for (v = agfstnode(g); v; v = agnxtnode(g, v))
+	for (i = 0; i < Ndim; i++)
+	    x[ND_id(v) * Ndim + i] = ND_pos(v)[i];
+
+    if (Verbose) {
+	fprintf(stderr, "Solving sparse stress model: ");
+	start_timer();
+    }
+    stress_model(Ndim, D, D, &x, TRUE, MaxIter, Epsilon,
+		 n_pinned > 0 ? unfixed : NULL, &flag);
+    if (Verbose)
+	fprintf(stderr, "%.2f sec\n", elapsed_sec());
+    if (flag)
+	agerr(AGWARN, "sparse stress model failed in graph %s\n", agnameof(g));
+    else {
+	for (v = agfstnode(g); v; v = agnxtnode(g, v))
+	    for (i = 0; i < Ndim; i++)
+		ND_pos(v)[i] = x[ND_id(v) * Ndim + i];
+    }
+
+    free(x);
+    free(unfixed);
+    SparseMatrix_delete(D);
+}
+#endif
+
 /* neatoLayout:
  * Use stress optimization to layout a single component
  */
@@ -1346,6 +1532,8 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
 	MaxIter = DFLT_ITERATIONS;
     else if (layoutMode == MODE_SGD)
 	MaxIter = 30;
+    else if (layoutMode == MODE_SPARSE)
+	MaxIter = 200;
     else
 	MaxIter = 100 * agnnodes(g);
 
@@ -1355,7 +1543,11 @@ neatoLayout(Agraph_t * mg, Agraph_t * g, int layoutMode, int layoutModel,
     if (layoutMode == MODE_KK)
 	kkNeato(g, nG, layoutModel);
     else if (layoutMode == MODE_SGD)
-	sgd(g, layoutModel);
+	sgd(g, layoutModel, late_int(g, agfindgraphattr(g, "threads"), 1, 1));
+#ifdef SFDP
+    else if (layoutMode == MODE_SPARSE)
+	sparseStress(g, nG);
+#endif
     else
 	majorization(mg, g, nG, layoutMode, layoutModel, Ndim, am);
 }
@@ -1402,6 +1594,32 @@ static void doEdges(Agraph_t* g)
     spline_edges0(g, TRUE);
 }
 
+/* state shared by the components of a graph, for neatoComponent */
+typedef struct {
+    Agraph_t *g;		/* root graph */
+    int layoutMode;
+    int model;
+    adjust_data *am;
+    boolean noTranslate;
+} neato_args;
+
+/* neatoComponent:
+ * Lay out one connected component of a disconnected graph.
+ */
+static int neatoComponent(graph_t * gc, int i, void *state)
+{
+    neato_args *args = state;
+
+    (void)i;
+    nodeInduce(gc);
+    neatoLayout(args->g, gc, args->layoutMode, args->model, args->am);
+    removeOverlapWith(gc, args->am);
+    setEdgeType (gc, EDGETYPE_LINE);
+    if (args->noTranslate) doEdges(gc);
+    else spline_edges(gc);
+    return 0;
+}
+
 /* neato_layout:
  */
 void neato_layout(Agraph_t * g)
@@ -1454,15 +1672,8 @@ void neato_layout(Agraph_t * g)
 
 	    if (n_cc > 1) {
 		boolean *bp;
-		for (i = 0; i < n_cc; i++) {
-		    gc = cc[i];
-		    nodeInduce(gc);
-		    neatoLayout(g, gc, layoutMode, model, &am);
-		    removeOverlapWith(gc, &am);
-		    setEdgeType (gc, EDGETYPE_LINE);
-		    if (noTranslate) doEdges(gc);
-		    else spline_edges(gc);
-		}
+		neato_args args = {g, layoutMode, model, &am, noTranslate};
+		layoutGraphs(n_cc, cc, neatoComponent, &args);
 		if (pin) {
 		    bp = N_NEW(n_cc, boolean);
 		    bp[0] = TRUE;
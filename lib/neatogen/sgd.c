@@ -1,8 +1,11 @@
+#include "config.h"
+
 #include <neatogen/neato.h>
 #include <neatogen/sgd.h>
 #include <neatogen/dijkstra.h>
 #include <neatogen/randomkit.h>
 #include <neatogen/neatoprocs.h>
+#include <common/parallel.h>
 #include <math.h>
 #include <stdlib.h>
 
@@ -19,13 +22,12 @@ static float calculate_stress(float *pos, term_sgd *terms, int n_terms) {
     return stress;
 }
 // it is much faster to shuffle term rather than pointers to term, even though the swap is more expensive
-static rk_state rstate;
-static void fisheryates_shuffle(term_sgd *terms, int n_terms) {
+static void fisheryates_shuffle(term_sgd *terms, int n_terms, rk_state *rstate) {
     int i;
     for (i=n_terms-1; i>=1; i--) {
         // srand48() is called in neatoinit.c, so no need to seed here
         //int j = (int)(drand48() * (i+1));
-        int j = rk_interval(i, &rstate);
+        int j = rk_interval(i, rstate);
 
         term_sgd temp = terms[i];
         terms[i] = terms[j];
@@ -33,45 +35,179 @@ static void fisheryates_shuffle(term_sgd *terms, int n_terms) {
     }
 }
 
+// perform one pass of updates over all terms
+// unfixed is NULL when no node is pinned, which saves two scattered loads per term
+static void sgd_epoch(float *pos, const term_sgd *terms, int n_terms, float eta, const bool *unfixed) {
+    int ij;
+    for (ij=0; ij<n_terms; ij++) {
+        const int i = terms[ij].i, j = terms[ij].j;
+        // cap step size
+        float mu = eta * terms[ij].w;
+        if (mu > 1)
+            mu = 1;
+
+        float dx = pos[2*i] - pos[2*j];
+        float dy = pos[2*i+1] - pos[2*j+1];
+        float mag = hypotf(dx, dy);
+
+        float r = (mu * (mag-terms[ij].d)) / (2*mag);
+        float r_x = r * dx;
+        float r_y = r * dy;
+
+        if (!unfixed || unfixed[i]) {
+            pos[2*i] -= r_x;
+            pos[2*i+1] -= r_y;
+        }
+        if (!unfixed || unfixed[j]) {
+            pos[2*j] += r_x;
+            pos[2*j+1] += r_y;
+        }
+    }
+}
+
+// With threads, the nodes are dealt out at random into 2*nthreads blocks,
+// and the terms are grouped by the pair of blocks of their endpoints. An
+// epoch is a round robin schedule over the blocks: in each of its
+// 2*nthreads-1 rounds every block is paired with one other, and each thread
+// updates the terms of one pair. The pairs of a round share no nodes, so the
+// threads never write to the same position, and the layout only depends on
+// the seed and the number of threads. Terms within a block are handled
+// in the first round.
+typedef struct {
+    term_sgd *terms; // terms of each pair of blocks, cells[a*n_blocks+b] for a <= b
+    int *starts; // the terms of cell c are terms[starts[c]] ... terms[starts[c+1]-1]
+    int n_blocks;
+    int round; // the round being worked on
+    float eta;
+    float *pos;
+    const bool *unfixed;
+    rk_state *rstates; // one for each part, so shuffles do not depend on timing
+} sgd_job;
+
+static void sgd_cell(sgd_job *job, int a, int b, rk_state *rstate) {
+    const int c = a * job->n_blocks + b;
+    term_sgd *terms = job->terms + job->starts[c];
+    const int n_terms = job->starts[c + 1] - job->starts[c];
+    fisheryates_shuffle(terms, n_terms, rstate);
+    sgd_epoch(job->pos, terms, n_terms, job->eta, job->unfixed);
+}
+
+static void sgd_part(void *arg, int t, int nthreads) {
+    sgd_job *job = arg;
+    const int last = job->n_blocks - 1, r = job->round;
+    int a, b;
+    (void)nthreads;
+
+    // the circle method: block last stays put, the others rotate around it
+    if (t == 0) {
+        a = last;
+        b = r;
+    } else {
+        a = (r + t) % last;
+        b = (r - t + last) % last;
+    }
+    if (a > b) {
+        int tmp = a;
+        a = b;
+        b = tmp;
+    }
+    if (r == 0) {
+        sgd_cell(job, a, a, &job->rstates[t]);
+        sgd_cell(job, b, b, &job->rstates[t]);
+    }
+    sgd_cell(job, a, b, &job->rstates[t]);
+}
+
+// group the terms by the blocks of their endpoints, as set out above
+static void sgd_blocks(sgd_job *job, term_sgd *terms, int n_terms, int n, int nthreads, rk_state *rstate) {
+    const int n_blocks = 2 * nthreads;
+    int *block = N_NEW(n, int);
+    int *fill;
+    int i, ij, c;
+
+    // a random permutation of the nodes, cut into blocks of equal size
+    for (i = 0; i < n; i++) {
+        block[i] = i;
+    }
+    for (i = n - 1; i >= 1; i--) {
+        int j = rk_interval(i, rstate);
+        int tmp = block[i];
+        block[i] = block[j];
+        block[j] = tmp;
+    }
+    int *node_block = N_NEW(n, int);
+    for (i = 0; i < n; i++) {
+        node_block[block[i]] = (int)((long long)i * n_blocks / n);
+    }
+    free(block);
+
+    job->n_blocks = n_blocks;
+    job->starts = N_NEW(n_blocks * n_blocks + 1, int);
+    job->terms = N_NEW(n_terms, term_sgd);
+    for (ij = 0; ij < n_terms; ij++) {
+        int a = node_block[terms[ij].i], b = node_block[terms[ij].j];
+        job->starts[(a < b ? a * n_blocks + b : b * n_blocks + a) + 1]++;
+    }
+    for (c = 0; c < n_blocks * n_blocks; c++) {
+        job->starts[c + 1] += job->starts[c];
+    }
+    fill = N_NEW(n_blocks * n_blocks, int);
+    for (ij = 0; ij < n_terms; ij++) {
+        int a = node_block[terms[ij].i], b = node_block[terms[ij].j];
+        c = a < b ? a * n_blocks + b : b * n_blocks + a;
+        job->terms[job->starts[c] + fill[c]++] = terms[ij];
+    }
+    free(fill);
+    free(node_block);
+}
+
 // graph_sgd data structure exists only to make dijkstras faster
 static graph_sgd * extract_adjacency(graph_t *G, int model) {
-    node_t *np;
-    edge_t *ep;
-    int n_nodes = 0, n_edges = 0;
-    for (np = agfstnode(G); np; np = agnxtnode(G,np)) {
-        assert(ND_id(np) == n_nodes);
-        n_nodes++;
-        for (ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-            if (agtail(ep) != aghead(ep)) { // ignore self-loops and double edges
-                n_edges++;
-            }
+    Agcsr_t *csr = agcsr(G, NULL, 0);
+    int n_nodes, n_edges = 0;
+    int x;
+    // every edge that is not a self-loop is seen from both of its ends
+    for (x = 0; x < csr->nedges; x++) {
+        if (csr->tail[x] != csr->head[x]) {
+            n_edges += 2;
         }
     }
     graph_sgd *graph = N_NEW(1, graph_sgd);
-    graph->sources = N_NEW(n_nodes+1, int);
-    graph->pinneds = N_NEW(n_nodes, bool);
+    graph->sources = N_NEW(csr->nnodes+1, int);
+    graph->pinneds = N_NEW(csr->nnodes, bool);
     graph->targets = N_NEW(n_edges, int);
     graph->weights = N_NEW(n_edges, float);
 
-    graph->n = n_nodes;
+    graph->n = csr->nnodes;
     graph->sources[graph->n] = n_edges; // to make looping nice
 
-    n_nodes = 0, n_edges = 0;
-    for (np = agfstnode(G); np; np = agnxtnode(G,np)) {
+    // neighbours are visited as agfstedge/agnxtedge would: out edges, then in edges
+    n_edges = 0;
+    for (n_nodes = 0; n_nodes < csr->nnodes; n_nodes++) {
+        assert(ND_id(csr->nodes[n_nodes]) == n_nodes);
         graph->sources[n_nodes] = n_edges;
-        graph->pinneds[n_nodes] = isFixed(np);
-        for (ep = agfstedge(G, np); ep; ep = agnxtedge(G, ep, np)) {
-            if (agtail(ep) == aghead(ep)) { // ignore self-loops and double edges
+        graph->pinneds[n_nodes] = isFixed(csr->nodes[n_nodes]);
+        for (x = csr->out[n_nodes]; x < csr->out[n_nodes+1]; x++) {
+            if (csr->head[x] == n_nodes) { // ignore self-loops
+                continue;
+            }
+            graph->targets[n_edges] = csr->head[x];
+            graph->weights[n_edges] = ED_dist(csr->edges[x]);
+            assert(graph->weights[n_edges] > 0);
+            n_edges++;
+        }
+        for (x = csr->in[n_nodes]; x < csr->in[n_nodes+1]; x++) {
+            int e = csr->in_edge[x];
+            if (csr->tail[e] == n_nodes) { // ignore self-loops
                 continue;
             }
-            node_t *target = (agtail(ep) == np) ? aghead(ep) : agtail(ep); // in case edge is reversed
-            graph->targets[n_edges] = ND_id(target);
-            graph->weights[n_edges] = ED_dist(ep);
+            graph->targets[n_edges] = csr->tail[e];
+            graph->weights[n_edges] = ED_dist(csr->edges[e]);
             assert(graph->weights[n_edges] > 0);
             n_edges++;
         }
-        n_nodes++;
     }
+    agcsrfree(csr);
     assert(n_nodes == graph->n);
     assert(n_edges == graph->sources[graph->n]);
     graph->sources[n_nodes] = n_edges;
@@ -142,7 +278,8 @@ static void free_adjacency(graph_sgd *graph) {
 
 
 void sgd(graph_t *G, /* input graph */
-        int model /* distance model */)
+        int model, /* distance model */
+        int nthreads /* threads for the optimisation */)
 {
     if (model == MODEL_CIRCUIT) {
         agerr(AGWARN, "circuit model not yet supported in Gmode=sgd, reverting to shortpath model\n");
@@ -207,6 +344,8 @@ void sgd(graph_t *G, /* input graph */
         pos[2*i+1] = ND_pos(node)[1];
         unfixed[i] = !isFixed(node);
     }
+    // n_fixed actually counts the unfixed nodes, see above
+    const bool *movable = n_fixed < n ? unfixed : NULL;
 
     // perform optimisation
     if (Verbose) {
@@ -214,35 +353,51 @@ void sgd(graph_t *G, /* input graph */
         start_timer();
     }
     int t;
+    rk_state rstate;
     rk_seed(0, &rstate); // TODO: get seed from graph
-    for (t=0; t<MaxIter; t++) {
-        fisheryates_shuffle(terms, n_terms);
-        float eta = eta_max * exp(-lambda * t);
-        for (ij=0; ij<n_terms; ij++) {
-            // cap step size
-            float mu = eta * terms[ij].w;
-            if (mu > 1)
-                mu = 1;
-
-            float dx = pos[2*terms[ij].i] - pos[2*terms[ij].j];
-            float dy = pos[2*terms[ij].i+1] - pos[2*terms[ij].j+1];
-            float mag = hypotf(dx, dy);
-
-            float r = (mu * (mag-terms[ij].d)) / (2*mag);
-            float r_x = r * dx;
-            float r_y = r * dy;
-
-            if (unfixed[terms[ij].i]) {
-                pos[2*terms[ij].i] -= r_x;
-                pos[2*terms[ij].i+1] -= r_y;
+    if (nthreads > 1) {
+        sgd_job job;
+        sgd_blocks(&job, terms, n_terms, n, nthreads, &rstate);
+        free(terms);
+        terms = job.terms;
+        job.pos = pos;
+        job.unfixed = movable;
+        job.rstates = N_NEW(nthreads, rk_state);
+        for (i = 0; i < nthreads; i++) {
+            rk_seed(i + 1, &job.rstates[i]);
+        }
+        int *rounds = N_NEW(job.n_blocks - 1, int);
+        for (i = 0; i < job.n_blocks - 1; i++) {
+            rounds[i] = i;
+        }
+        for (t=0; t<MaxIter; t++) {
+            job.eta = eta_max * exp(-lambda * t);
+            // visit the rounds in a different order each epoch
+            for (i = job.n_blocks - 2; i >= 1; i--) {
+                int j = rk_interval(i, &rstate);
+                int tmp = rounds[i];
+                rounds[i] = rounds[j];
+                rounds[j] = tmp;
+            }
+            for (i = 0; i < job.n_blocks - 1; i++) {
+                job.round = rounds[i];
+                parallel_run(nthreads, sgd_part, &job);
             }
-            if (unfixed[terms[ij].j]) {
-                pos[2*terms[ij].j] += r_x;
-                pos[2*terms[ij].j+1] += r_y;
+            if (Verbose) {
+                fprintf(stderr, " %.3f", calculate_stress(pos, terms, n_terms));
             }
         }
-        if (Verbose) {
-            fprintf(stderr, " %.3f", calculate_stress(pos, terms, n_terms));
+        free(rounds);
+        free(job.rstates);
+        free(job.starts);
+    } else {
+        for (t=0; t<MaxIter; t++) {
+            fisheryates_shuffle(terms, n_terms, &rstate);
+            float eta = eta_max * exp(-lambda * t);
+            sgd_epoch(pos, terms, n_terms, eta, movable);
+            if (Verbose) {
+                fprintf(stderr, " %.3f", calculate_stress(pos, terms, n_terms));
+            }
         }
     }
     if (Verbose) {
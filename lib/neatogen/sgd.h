@@ -18,7 +18,7 @@ typedef struct graph_sgd {
     float *weights; // weights of edges (length sources[n])
 } graph_sgd;
 
-extern void sgd(graph_t *, int);
+extern void sgd(graph_t *, int, int);
 
 #ifdef __cplusplus
 }
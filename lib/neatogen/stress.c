@@ -8,6 +8,7 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include "config.h"
 
 #include <neatogen/neato.h>
 #include <neatogen/dijkstra.h>
@@ -18,6 +19,7 @@
 #include <neatogen/embed_graph.h>
 #include <neatogen/kkutils.h>
 #include <neatogen/stress.h>
+#include <common/parallel.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -699,29 +701,78 @@ finish0:
     return iterations;
 }
 
-/* compute_weighted_apsp_packed:
- * Edge lengths can be any float > 0
+/* the shortest paths of apsp_packed. Each part fills the rows of the packed
+ * matrix of a block of sources, with its own search scratch space.
  */
-static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
+typedef struct {
+    vtx_data *graph;
+    int n;
+    float *Dij;
+} apsp_job;
+
+static float *packed_row(float *Dij, int n, int i)
 {
-    int i, j, count;
-    float *Dij = N_NEW(n * (n + 1) / 2, float);
+    return Dij + (size_t)i * n - (size_t)i * (i - 1) / 2;
+}
 
+static void weighted_apsp_part(void *arg, int t, int nthreads)
+{
+    apsp_job *job = arg;
+    int i, lo, hi, n = job->n;
     float *Di = N_NEW(n, float);
+
+    parallel_range(n, t, nthreads, &lo, &hi);
+    for (i = lo; i < hi; i++) {
+	dijkstra_f(i, job->graph, n, Di);
+	memcpy(packed_row(job->Dij, n, i), Di + i, (n - i) * sizeof(float));
+    }
+    free(Di);
+}
+
+static void apsp_part(void *arg, int t, int nthreads)
+{
+    apsp_job *job = arg;
+    int i, j, lo, hi, n = job->n;
+    float *row;
+    DistType *Di = N_NEW(n, DistType);
     Queue Q;
 
     mkQueue(&Q, n);
-
-    count = 0;
-    for (i = 0; i < n; i++) {
-	dijkstra_f(i, graph, n, Di);
+    parallel_range(n, t, nthreads, &lo, &hi);
+    for (i = lo; i < hi; i++) {
+	bfs(i, job->graph, n, Di, &Q);
+	row = packed_row(job->Dij, n, i);
 	for (j = i; j < n; j++) {
-	    Dij[count++] = Di[j];
+	    row[j - i] = ((float) Di[j]);
 	}
     }
     free(Di);
     freeQueue(&Q);
-    return Dij;
+}
+
+/* apsp_packed:
+ * All-pairs shortest paths as a packed upper triangular matrix, with
+ * the searches shared out between nthreads threads. Edge lengths can be
+ * any float > 0 if weighted, else they are assumed integral.
+ */
+static float *apsp_packed(vtx_data * graph, int n, bool weighted,
+			  int nthreads)
+{
+    apsp_job job;
+
+    job.graph = graph;
+    job.n = n;
+    job.Dij = N_NEW(n * (n + 1) / 2, float);
+    parallel_run(nthreads, weighted ? weighted_apsp_part : apsp_part, &job);
+    return job.Dij;
+}
+
+/* compute_weighted_apsp_packed:
+ * Edge lengths can be any float > 0
+ */
+static float *compute_weighted_apsp_packed(vtx_data * graph, int n)
+{
+    return apsp_packed(graph, n, true, 1);
 }
 
 
@@ -763,24 +814,7 @@ float *mdsModel(vtx_data * graph, int nG)
  */
 float *compute_apsp_packed(vtx_data * graph, int n)
 {
-    int i, j, count;
-    float *Dij = N_NEW(n * (n + 1) / 2, float);
-
-    DistType *Di = N_NEW(n, DistType);
-    Queue Q;
-
-    mkQueue(&Q, n);
-
-    count = 0;
-    for (i = 0; i < n; i++) {
-	bfs(i, graph, n, Di, &Q);
-	for (j = i; j < n; j++) {
-	    Dij[count++] = ((float) Di[j]);
-	}
-    }
-    free(Di);
-    freeQueue(&Q);
-    return Dij;
+    return apsp_packed(graph, n, false, 1);
 }
 
 float *compute_apsp_artifical_weights_packed(vtx_data * graph, int n)
@@ -880,7 +914,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 				   int dim,	/* dimemsionality of layout */
 				   int opts,    /* options */
 				   int model,	/* model */
-				   int maxi	/* max iterations */
+				   int maxi,	/* max iterations */
+				   int nthreads	/* threads for the dense work */
     )
 {
     int iterations;		/* output: number of iteration of the process */
@@ -901,6 +936,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     double old_stress, new_stress;
     bool converged;
     float **b = NULL;
+    float **lap2_coords = NULL;
     float *tmp_coords = NULL;
     float *dist_accumulator = NULL;
     float *lap1 = NULL;
@@ -953,10 +989,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
     if (!Dij) {
 	if (Verbose)
 	    fprintf(stderr, "Calculating shortest paths");
-	if (graph->ewgts)
-	    Dij = compute_weighted_apsp_packed(graph, n);
-	else
-	    Dij = compute_apsp_packed(graph, n);
+	Dij = apsp_packed(graph, n, graph->ewgts != NULL, nthreads);
     }
 
     if (Verbose) {
@@ -1099,6 +1132,12 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	b[k] = b[0] + k * n;
     }
 
+    lap2_coords = N_NEW(dim, float *);
+    lap2_coords[0] = N_NEW(dim * n, float);
+    for (k = 1; k < dim; k++) {
+	lap2_coords[k] = lap2_coords[0] + k * n;
+    }
+
     tmp_coords = N_NEW(n, float);
     dist_accumulator = N_NEW(n, float);
     lap1 = NULL;
@@ -1195,10 +1234,8 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	}
 
 	/* Now compute b[] */
-	for (k = 0; k < dim; k++) {
-	    /* b[k] := lap1*coords[k] */
-	    right_mult_with_vector_ff(lap1, n, coords[k], b[k]);
-	}
+	/* b[k] := lap1*coords[k] */
+	right_mult_with_vectors_ff(lap1, n, dim, coords, b, nthreads);
 
 
 	/* compute new stress  */
@@ -1216,9 +1253,9 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    fread(lap2, sizeof(float), lap_length, fp);
 	}
 #endif
+	right_mult_with_vectors_ff(lap2, n, dim, coords, lap2_coords, nthreads);
 	for (k = 0; k < dim; k++) {
-	    right_mult_with_vector_ff(lap2, n, coords[k], tmp_coords);
-	    new_stress -= vectors_inner_productf(n, coords[k], tmp_coords);
+	    new_stress -= vectors_inner_productf(n, coords[k], lap2_coords[k]);
 	}
 #ifdef ALTERNATIVE_STRESS_CALC
 	mat_stress = new_stress;
@@ -1244,7 +1281,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 	    if (havePinned) {
 		copy_vectorf(n, coords[k], tmp_coords);
 		if (conjugate_gradient_mkernel(lap2, tmp_coords, b[k], n,
-					   conj_tol, n) < 0) {
+					   conj_tol, n, nthreads) < 0) {
 		    iterations = -1;
 		    goto finish1;
 		}
@@ -1255,7 +1292,7 @@ int stress_majorization_kD_mkernel(vtx_data * graph,	/* Input graph in sparse re
 		}
 	    } else {
 		if (conjugate_gradient_mkernel(lap2, coords[k], b[k], n,
-					   conj_tol, n) < 0) {
+					   conj_tol, n, nthreads) < 0) {
 		    iterations = -1;
 		    goto finish1;
 		}
@@ -1291,6 +1328,10 @@ finish1:
 	free(b[0]);
 	free(b);
     }
+    if (lap2_coords) {
+	free(lap2_coords[0]);
+	free(lap2_coords);
+    }
     free(tmp_coords);
     free(dist_accumulator);
     free(degrees);
@@ -48,7 +48,8 @@ extern "C" {
 					      int dim,	/* dimemsionality of layout */
 					      int opts,	/* option flags */
 					      int model,	/* model */
-					      int maxi	/* max iterations */
+					      int maxi,	/* max iterations */
+					      int nthreads	/* threads for the dense work */
 	);
 
 extern float *compute_apsp_packed(vtx_data * graph, int n);
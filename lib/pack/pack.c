@@ -723,7 +723,7 @@ polyRects(int ng, boxf* gs, pack_info * pinfo)
     ginfo *info;
     ginfo **sinfo;
     point *places;
-    Dict_t *ps;
+    PointSet *ps;
     int i;
     point center;
 
@@ -801,7 +801,7 @@ polyGraphs(int ng, Agraph_t ** gs, Agraph_t * root, pack_info * pinfo)
     ginfo *info;
     ginfo **sinfo;
     point *places;
-    Dict_t *ps;
+    PointSet *ps;
     int i;
     boolean *fixed = pinfo->fixed;
     int fixed_cnt = 0;
@@ -1173,6 +1173,44 @@ packSubgraphs(int ng, Agraph_t ** gs, Agraph_t * root, pack_info * info)
     return ret;
 }
 
+/* layoutGraphs:
+ * Lay out each of the ng graphs in gs, in order, by calling
+ * layout(gs[i], i, state). Components of one root graph share its
+ * dictionaries, string pool and memory discipline, so the components are
+ * laid out one after another on the calling thread. layout may rely on
+ * this order and carry state from one component to the next: twopi keeps
+ * the center of the first component as the root, and neato and sfdp
+ * share one adjust_data across components.
+ * Returns 0 on success. Otherwise, returns the first non-zero value
+ * returned by layout; the remaining graphs are not laid out.
+ */
+int layoutGraphs(int ng, Agraph_t ** gs, pack_layout_fn layout,
+		 void *state)
+{
+    int i, ret;
+
+    for (i = 0; i < ng; i++) {
+	if ((ret = layout(gs[i], i, state)))
+	    return ret;
+    }
+    return 0;
+}
+
+/* packLayouts:
+ * Lay out the subgraphs gs of root with layoutGraphs, then pack them
+ * with packSubgraphs.
+ * Returns 0 on success.
+ */
+int packLayouts(int ng, Agraph_t ** gs, Agraph_t * root, pack_info * info,
+		pack_layout_fn layout, void *state)
+{
+    int ret;
+
+    if ((ret = layoutGraphs(ng, gs, layout, state)))
+	return ret;
+    return packSubgraphs(ng, gs, root, info);
+}
+
 /* pack_graph:
  * Pack subgraphs followed by postprocessing.
  */
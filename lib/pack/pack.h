@@ -40,6 +40,10 @@ extern "C" {
 
 typedef unsigned int packval_t;
 
+/* lay out graph g, the i'th of those passed to layoutGraphs or packLayouts;
+ * returns 0 on success */
+typedef int (*pack_layout_fn)(Agraph_t * g, int i, void *state);
+
     typedef struct {
 	float aspect;		/* desired aspect ratio */
 	int sz;			/* row/column size size */
@@ -69,6 +73,11 @@ typedef unsigned int packval_t;
     PACK_API int packGraphs(int, Agraph_t **, Agraph_t *, pack_info *);
     PACK_API int packSubgraphs(int, Agraph_t **, Agraph_t *, pack_info *);
     PACK_API int pack_graph(int ng, Agraph_t** gs, Agraph_t* root, boolean* fixed);
+    PACK_API int layoutGraphs(int ng, Agraph_t ** gs, pack_layout_fn layout,
+			      void *state);
+    PACK_API int packLayouts(int ng, Agraph_t ** gs, Agraph_t * root,
+			     pack_info * info, pack_layout_fn layout,
+			     void *state);
 
     PACK_API int shiftGraphs(int, Agraph_t**, point*, Agraph_t*, int);
 
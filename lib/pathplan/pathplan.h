@@ -22,12 +22,23 @@ extern "C" {
     extern int Pshortestpath(Ppoly_t * boundary, Ppoint_t endpoints[2],
 			     Ppolyline_t * output_route);
 
+/* as Pshortestpath, but writing into output_route->ps, a caller-owned array
+ * from malloc with room for *capacity points or NULL, grown as needed */
+    extern int Pshortestpath_r(Ppoly_t * boundary, Ppoint_t endpoints[2],
+			       Ppolyline_t * output_route, int *capacity);
+
 /* fit a spline to an input polyline, without touching barrier segments */
     extern int Proutespline(Pedge_t * barriers, int n_barriers,
 			    Ppolyline_t input_route,
 			    Pvector_t endpoint_slopes[2],
 			    Ppolyline_t * output_route);
 
+/* as Proutespline, with a caller-owned output like Pshortestpath_r */
+    extern int Proutespline_r(Pedge_t * barriers, int n_barriers,
+			      Ppolyline_t input_route,
+			      Pvector_t endpoint_slopes[2],
+			      Ppolyline_t * output_route, int *capacity);
+
 /* utility function to convert from a set of polygonal obstacles to barriers */
     extern int Ppolybarriers(Ppoly_t ** polys, int npolys,
 			     Pedge_t ** barriers, int *n_barriers);
@@ -35,6 +46,10 @@ extern "C" {
 /* function to convert a polyline into a spline representation */
     extern void make_polyline(Ppolyline_t line, Ppolyline_t* sline);
 
+/* as make_polyline, with a caller-owned output like Pshortestpath_r */
+    extern void make_polyline_r(Ppolyline_t line, Ppolyline_t* sline,
+                                int *capacity);
+
 #undef extern
 
 #ifdef __cplusplus
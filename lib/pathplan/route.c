@@ -11,8 +11,6 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <setjmp.h>
-#include <stdlib.h>
 #include <math.h>
 #include <pathplan/pathutil.h>
 #include <pathplan/solvers.h>
@@ -34,17 +32,22 @@ typedef struct tna_t {
 
 #define POINTSIZE sizeof (Ppoint_t)
 
-static jmp_buf jbuf;
-
-static Ppoint_t *ops;
-static int opn, opl;
-
-static int reallyroutespline(Pedge_t *, int,
-			     Ppoint_t *, int, Ppoint_t, Ppoint_t);
+/* The state of one call to Proutespline_r: scratch space for the
+ * parameterization, shared by all the recursive calls as each one is done
+ * with it before recursing, and the caller's buffer for the output points.
+ */
+typedef struct {
+    tna_t *tnas;
+    Ppoint_t *ops;
+    int opn, opl;
+} route_t;
+
+static int reallyroutespline(route_t *, Pedge_t *, int, Ppoint_t *, int,
+			     Ppoint_t, Ppoint_t);
 static int mkspline(Ppoint_t *, int, tna_t *, Ppoint_t, Ppoint_t,
 		    Ppoint_t *, Ppoint_t *, Ppoint_t *, Ppoint_t *);
-static int splinefits(Pedge_t *, int, Ppoint_t, Pvector_t, Ppoint_t,
-		      Pvector_t, Ppoint_t *, int);
+static int splinefits(route_t *, Pedge_t *, int, Ppoint_t, Pvector_t,
+		      Ppoint_t, Pvector_t, Ppoint_t *, int);
 static int splineisinside(Pedge_t *, int, Ppoint_t *);
 static int splineintersectsline(Ppoint_t *, Ppoint_t *, double *);
 static void points2coeff(double, double, double, double, double *);
@@ -52,7 +55,7 @@ static void addroot(double, double *, int *);
 
 static Pvector_t normv(Pvector_t);
 
-static void growops(int);
+static int growops(route_t *, int);
 
 static Ppoint_t add(Ppoint_t, Ppoint_t);
 static Ppoint_t sub(Ppoint_t, Ppoint_t);
@@ -66,56 +69,83 @@ static double B3(double t);
 static double B01(double t);
 static double B23(double t);
 
-/* Proutespline:
+/* Proutespline_r:
  * Given a set of edgen line segments edges as obstacles, a template
  * path input, and endpoint vectors evs, construct a spline fitting the
- * input and endpoing vectors, and return in output.
+ * input and endpoing vectors, and return in output. On entry, output->ps
+ * is NULL or an array from malloc with room for *capacity points. It is
+ * reallocated as needed and stays owned by the caller, so one buffer can
+ * serve many calls. Calls with distinct buffers share no state.
  * Return 0 on success and -1 on failure, including no memory.
  */
-int Proutespline(Pedge_t * edges, int edgen, Ppolyline_t input,
-		 Ppoint_t evs[2], Ppolyline_t * output)
+int Proutespline_r(Pedge_t * edges, int edgen, Ppolyline_t input,
+		   Ppoint_t evs[2], Ppolyline_t * output, int *capacity)
 {
     Ppoint_t *inps;
     int inpn;
+    route_t rt = {0};
+    int rc;
 
     /* unpack into previous format rather than modify legacy code */
     inps = input.ps;
     inpn = input.pn;
 
-    if (setjmp(jbuf))
+    rt.ops = output->ps;
+    rt.opn = output->ps ? *capacity : 0;
+    output->pn = 0;
+    if (!(rt.tnas = malloc(sizeof(tna_t) * inpn))) {
+	prerror("cannot allocate tnas");
 	return -1;
+    }
 
     /* generate the splines */
     evs[0] = normv(evs[0]);
     evs[1] = normv(evs[1]);
-    opl = 0;
-    growops(4);
-    ops[opl++] = inps[0];
-    if (reallyroutespline(edges, edgen, inps, inpn, evs[0], evs[1]) == -1)
+    rc = growops(&rt, 4);
+    if (rc == 0) {
+	rt.ops[rt.opl++] = inps[0];
+	rc = reallyroutespline(&rt, edges, edgen, inps, inpn, evs[0],
+			       evs[1]);
+    }
+    free(rt.tnas);
+    output->ps = rt.ops;
+    *capacity = rt.opn;
+    if (rc == -1)
 	return -1;
-    output->pn = opl;
-    output->ps = ops;
+    output->pn = rt.opl;
 
     return 0;
 }
 
-static int reallyroutespline(Pedge_t * edges, int edgen,
-			     Ppoint_t * inps, int inpn, Ppoint_t ev0,
-			     Ppoint_t ev1)
+/* Proutespline:
+ * As Proutespline_r, but output->ps points into a buffer owned by the
+ * library, which is only valid until the next call.
+ */
+int Proutespline(Pedge_t * edges, int edgen, Ppolyline_t input,
+		 Ppoint_t evs[2], Ppolyline_t * output)
 {
+    static Ppoint_t *ops;
+    static int opn;
+    Ppolyline_t spl = {ops, 0};
+    int rc;
+
+    rc = Proutespline_r(edges, edgen, input, evs, &spl, &opn);
+    ops = spl.ps;
+    if (rc == 0)
+	*output = spl;
+    return rc;
+}
+
+static int reallyroutespline(route_t * rt, Pedge_t * edges, int edgen,
+			     Ppoint_t * inps, int inpn,
+			     Ppoint_t ev0, Ppoint_t ev1)
+{
+    tna_t *tnas = rt->tnas;
     Ppoint_t p1, p2, cp1, cp2, p;
     Pvector_t v1, v2, splitv, splitv1, splitv2;
     double maxd, d, t;
-    int maxi, i, spliti;
+    int maxi, i, spliti, fits;
 
-    static tna_t *tnas;
-    static int tnan;
-
-    if (tnan < inpn) {
-	if (!(tnas = realloc(tnas, sizeof(tna_t) * inpn)))
-	    return -1;
-	tnan = inpn;
-    }
     tnas[0].t = 0;
     for (i = 1; i < inpn; i++)
 	tnas[i].t = tnas[i - 1].t + dist(inps[i], inps[i - 1]);
@@ -127,8 +157,8 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     }
     if (mkspline(inps, inpn, tnas, ev0, ev1, &p1, &v1, &p2, &v2) == -1)
 	return -1;
-    if (splinefits(edges, edgen, p1, v1, p2, v2, inps, inpn))
-	return 0;
+    if ((fits = splinefits(rt, edges, edgen, p1, v1, p2, v2, inps, inpn)))
+	return fits > 0 ? 0 : -1;
     cp1 = add(p1, scale(v1, 1 / 3.0));
     cp2 = sub(p2, scale(v2, 1 / 3.0));
     for (maxd = -1, maxi = -1, i = 1; i < inpn - 1; i++) {
@@ -142,10 +172,11 @@ static int reallyroutespline(Pedge_t * edges, int edgen,
     splitv1 = normv(sub(inps[spliti], inps[spliti - 1]));
     splitv2 = normv(sub(inps[spliti + 1], inps[spliti]));
     splitv = normv(add(splitv1, splitv2));
-    reallyroutespline(edges, edgen, inps, spliti + 1, ev0, splitv);
-    reallyroutespline(edges, edgen, &inps[spliti], inpn - spliti, splitv,
-		      ev1);
-    return 0;
+    if (reallyroutespline(rt, edges, edgen, inps, spliti + 1, ev0,
+			  splitv) == -1)
+	return -1;
+    return reallyroutespline(rt, edges, edgen, &inps[spliti], inpn - spliti,
+			     splitv, ev1);
 }
 
 static int mkspline(Ppoint_t * inps, int inpn, tna_t * tnas, Ppoint_t ev0,
@@ -203,8 +234,12 @@ static double dist_n(Ppoint_t * p, int n)
     return rv;
 }
 
-static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
-		      Pvector_t va, Ppoint_t pb, Pvector_t vb,
+/* splinefits:
+ * Try to fit a single Bezier segment and append it to rt->ops.
+ * Return 1 if it fits, 0 if it does not, and -1 on allocation failure.
+ */
+static int splinefits(route_t * rt, Pedge_t * edges, int edgen,
+		      Ppoint_t pa, Pvector_t va, Ppoint_t pb, Pvector_t vb,
 		      Ppoint_t * inps, int inpn)
 {
     Ppoint_t sps[4];
@@ -239,9 +274,10 @@ static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
 	first = 0;
 
 	if (splineisinside(edges, edgen, &sps[0])) {
-	    growops(opl + 4);
+	    if (growops(rt, rt->opl + 4) == -1)
+		return -1;
 	    for (pi = 1; pi < 4; pi++)
-		ops[opl].x = sps[pi].x, ops[opl++].y = sps[pi].y;
+		rt->ops[rt->opl++] = sps[pi];
 #if defined(DEBUG) && DEBUG >= 1
 	    fprintf(stderr, "success: %f %f\n", a, b);
 #endif
@@ -249,9 +285,10 @@ static int splinefits(Pedge_t * edges, int edgen, Ppoint_t pa,
 	}
 	if (a == 0 && b == 0) {
 	    if (forceflag) {
-		growops(opl + 4);
+		if (growops(rt, rt->opl + 4) == -1)
+		    return -1;
 		for (pi = 1; pi < 4; pi++)
-		    ops[opl].x = sps[pi].x, ops[opl++].y = sps[pi].y;
+		    rt->ops[rt->opl++] = sps[pi];
 #if defined(DEBUG) && DEBUG >= 1
 		fprintf(stderr, "forced straight line: %f %f\n", a, b);
 #endif
@@ -410,15 +447,25 @@ static Pvector_t normv(Pvector_t v)
     return v;
 }
 
-static void growops(int newopn)
+/* growops:
+ * Make room for at least newopn output points, at least doubling the
+ * buffer so that appending stays linear.
+ */
+static int growops(route_t * rt, int newopn)
 {
-    if (newopn <= opn)
-	return;
-    if (!(ops = realloc(ops, POINTSIZE * newopn))) {
+    Ppoint_t *nops;
+
+    if (newopn <= rt->opn)
+	return 0;
+    if (newopn < 2 * rt->opn)
+	newopn = 2 * rt->opn;
+    if (!(nops = realloc(rt->ops, POINTSIZE * newopn))) {
 	prerror("cannot realloc ops");
-	longjmp(jbuf,1);
+	return -1;
     }
-    opn = newopn;
+    rt->ops = nops;
+    rt->opn = newopn;
+    return 0;
 }
 
 static Ppoint_t add(Ppoint_t p1, Ppoint_t p2)
@@ -54,44 +54,85 @@ typedef struct deque_t {
     int pnlpn, fpnlpi, lpnlpi, apex;
 } deque_t;
 
-static pointnlink_t *pnls, **pnlps;
-static int pnln, pnll;
+/* The working space of Pshortestpath_r, and the buffer for its output */
+typedef struct {
+    pointnlink_t *pnls, **pnlps;
+    int pnln, pnll;
 
-static triangle_t *tris;
-static int trin, tril;
+    triangle_t *tris;
+    int trin, tril;
 
-static deque_t dq;
+    deque_t dq;
 
-static Ppoint_t *ops;
-static int opn;
+    Ppoint_t *ops;
+    int opn;
+} shortest_t;
 
-static int triangulate(pointnlink_t **, int);
+static int shortestpath(shortest_t *, Ppoly_t *, Ppoint_t[2],
+			Ppolyline_t *);
+
+static int triangulate(shortest_t *, pointnlink_t **, int);
 static bool isdiagonal(int, int, pointnlink_t **, int);
-static int loadtriangle(pointnlink_t *, pointnlink_t *, pointnlink_t *);
-static void connecttris(int, int);
-static bool marktripath(int, int);
+static int loadtriangle(shortest_t *, pointnlink_t *, pointnlink_t *,
+			pointnlink_t *);
+static void connecttris(shortest_t *, int, int);
+static bool marktripath(shortest_t *, int, int);
 
-static void add2dq(int, pointnlink_t *);
-static void splitdq(int, int);
-static int finddqsplit(pointnlink_t *);
+static void add2dq(deque_t *, int, pointnlink_t *);
+static void splitdq(deque_t *, int, int);
+static int finddqsplit(deque_t *, pointnlink_t *);
 
 static int ccw(Ppoint_t *, Ppoint_t *, Ppoint_t *);
 static bool intersects(Ppoint_t *, Ppoint_t *, Ppoint_t *, Ppoint_t *);
 static bool between(Ppoint_t *, Ppoint_t *, Ppoint_t *);
-static int pointintri(int, Ppoint_t *);
+static int pointintri(shortest_t *, int, Ppoint_t *);
 
-static int growpnls(int);
-static int growtris(int);
-static int growdq(int);
-static int growops(int);
+static int growpnls(shortest_t *, int);
+static int growtris(shortest_t *, int);
+static int growdq(shortest_t *, int);
+static int growops(shortest_t *, int);
 
-/* Pshortestpath:
+/* Pshortestpath_r:
  * Find a shortest path contained in the polygon polyp going between the
- * points supplied in eps. The resulting polyline is stored in output.
+ * points supplied in eps. The resulting polyline is stored in output. On
+ * entry, output->ps is NULL or an array from malloc with room for
+ * *capacity points. It is reallocated as needed and stays owned by the
+ * caller. Calls with distinct buffers share no state.
  * Return 0 on success, -1 on bad input, -2 on memory allocation problem. 
  */
+int Pshortestpath_r(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output,
+		    int *capacity)
+{
+    shortest_t s = {0};
+    int rc;
+
+    s.ops = output->ps;
+    s.opn = output->ps ? *capacity : 0;
+    rc = shortestpath(&s, polyp, eps, output);
+    output->ps = s.ops;
+    *capacity = s.opn;
+    free(s.pnls);
+    free(s.pnlps);
+    free(s.tris);
+    free(s.dq.pnlps);
+    return rc;
+}
+
+/* Pshortestpath:
+ * As Pshortestpath_r, but output->ps points into a buffer owned by the
+ * library, which is only valid until the next call.
+ */
 int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 {
+    static shortest_t s;
+
+    return shortestpath(&s, polyp, eps, output);
+}
+
+static int shortestpath(shortest_t * s, Ppoly_t * polyp, Ppoint_t eps[2],
+			Ppolyline_t * output)
+{
+    deque_t *dq = &s->dq;
     int pi, minpi;
     double minx;
     Ppoint_t p1, p2, p3;
@@ -105,13 +146,13 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 #endif
 
     /* make space */
-    if (growpnls(polyp->pn) != 0)
+    if (growpnls(s, polyp->pn) != 0)
 	return -2;
-    pnll = 0;
-    tril = 0;
-    if (growdq(polyp->pn * 2) != 0)
+    s->pnll = 0;
+    s->tril = 0;
+    if (growdq(s, polyp->pn * 2) != 0)
 	return -2;
-    dq.fpnlpi = dq.pnlpn / 2, dq.lpnlpi = dq.fpnlpi - 1;
+    dq->fpnlpi = dq->pnlpn / 2, dq->lpnlpi = dq->fpnlpi - 1;
 
     /* make sure polygon is CCW and load pnls array */
     for (pi = 0, minx = HUGE_VAL, minpi = -1; pi < polyp->pn; pi++) {
@@ -128,94 +169,94 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 		&& polyp->ps[pi].x == polyp->ps[pi + 1].x
 		&& polyp->ps[pi].y == polyp->ps[pi + 1].y)
 		continue;
-	    pnls[pnll].pp = &polyp->ps[pi];
-	    pnls[pnll].link = &pnls[pnll % polyp->pn];
-	    pnlps[pnll] = &pnls[pnll];
-	    pnll++;
+	    s->pnls[s->pnll].pp = &polyp->ps[pi];
+	    s->pnls[s->pnll].link = &s->pnls[s->pnll % polyp->pn];
+	    s->pnlps[s->pnll] = &s->pnls[s->pnll];
+	    s->pnll++;
 	}
     } else {
 	for (pi = 0; pi < polyp->pn; pi++) {
 	    if (pi > 0 && polyp->ps[pi].x == polyp->ps[pi - 1].x &&
 		polyp->ps[pi].y == polyp->ps[pi - 1].y)
 		continue;
-	    pnls[pnll].pp = &polyp->ps[pi];
-	    pnls[pnll].link = &pnls[pnll % polyp->pn];
-	    pnlps[pnll] = &pnls[pnll];
-	    pnll++;
+	    s->pnls[s->pnll].pp = &polyp->ps[pi];
+	    s->pnls[s->pnll].link = &s->pnls[s->pnll % polyp->pn];
+	    s->pnlps[s->pnll] = &s->pnls[s->pnll];
+	    s->pnll++;
 	}
     }
 
 #if defined(DEBUG) && DEBUG >= 1
-    fprintf(stderr, "points\n%d\n", pnll);
-    for (pnli = 0; pnli < pnll; pnli++)
-	fprintf(stderr, "%f %f\n", pnls[pnli].pp->x, pnls[pnli].pp->y);
+    fprintf(stderr, "points\n%d\n", s->pnll);
+    for (pnli = 0; pnli < s->pnll; pnli++)
+	fprintf(stderr, "%f %f\n", s->pnls[pnli].pp->x, s->pnls[pnli].pp->y);
 #endif
 
     /* generate list of triangles */
-    if (triangulate(pnlps, pnll))
+    if (triangulate(s, s->pnlps, s->pnll))
 	return -2;
 
 #if defined(DEBUG) && DEBUG >= 2
-    fprintf(stderr, "triangles\n%d\n", tril);
-    for (trii = 0; trii < tril; trii++)
+    fprintf(stderr, "triangles\n%d\n", s->tril);
+    for (trii = 0; trii < s->tril; trii++)
 	for (ei = 0; ei < 3; ei++)
-	    fprintf(stderr, "%f %f\n", tris[trii].e[ei].pnl0p->pp->x,
-		    tris[trii].e[ei].pnl0p->pp->y);
+	    fprintf(stderr, "%f %f\n", s->tris[trii].e[ei].pnl0p->pp->x,
+		    s->tris[trii].e[ei].pnl0p->pp->y);
 #endif
 
     /* connect all pairs of triangles that share an edge */
-    for (trii = 0; trii < tril; trii++)
-	for (trij = trii + 1; trij < tril; trij++)
-	    connecttris(trii, trij);
+    for (trii = 0; trii < s->tril; trii++)
+	for (trij = trii + 1; trij < s->tril; trij++)
+	    connecttris(s, trii, trij);
 
     /* find first and last triangles */
-    for (trii = 0; trii < tril; trii++)
-	if (pointintri(trii, &eps[0]))
+    for (trii = 0; trii < s->tril; trii++)
+	if (pointintri(s, trii, &eps[0]))
 	    break;
-    if (trii == tril) {
+    if (trii == s->tril) {
 	prerror("source point not in any triangle");
 	return -1;
     }
     ftrii = trii;
-    for (trii = 0; trii < tril; trii++)
-	if (pointintri(trii, &eps[1]))
+    for (trii = 0; trii < s->tril; trii++)
+	if (pointintri(s, trii, &eps[1]))
 	    break;
-    if (trii == tril) {
+    if (trii == s->tril) {
 	prerror("destination point not in any triangle");
 	return -1;
     }
     ltrii = trii;
 
     /* mark the strip of triangles from eps[0] to eps[1] */
-    if (!marktripath(ftrii, ltrii)) {
+    if (!marktripath(s, ftrii, ltrii)) {
 	prerror("cannot find triangle path");
 	/* a straight line is better than failing */
-	if (growops(2) != 0)
+	if (growops(s, 2) != 0)
 		return -2;
 	output->pn = 2;
-	ops[0] = eps[0], ops[1] = eps[1];
-	output->ps = ops;
+	s->ops[0] = eps[0], s->ops[1] = eps[1];
+	output->ps = s->ops;
 	return 0;
     }
 
     /* if endpoints in same triangle, use a single line */
     if (ftrii == ltrii) {
-	if (growops(2) != 0)
+	if (growops(s, 2) != 0)
 		return -2;
 	output->pn = 2;
-	ops[0] = eps[0], ops[1] = eps[1];
-	output->ps = ops;
+	s->ops[0] = eps[0], s->ops[1] = eps[1];
+	output->ps = s->ops;
 	return 0;
     }
 
     /* build funnel and shortest path linked list (in add2dq) */
     epnls[0].pp = &eps[0], epnls[0].link = NULL;
     epnls[1].pp = &eps[1], epnls[1].link = NULL;
-    add2dq(DQ_FRONT, &epnls[0]);
-    dq.apex = dq.fpnlpi;
+    add2dq(dq, DQ_FRONT, &epnls[0]);
+    dq->apex = dq->fpnlpi;
     trii = ftrii;
     while (trii != -1) {
-	trip = &tris[trii];
+	trip = &s->tris[trii];
 	trip->mark = 2;
 
 	/* find the left and right points of the exiting edge */
@@ -223,11 +264,11 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 	    if (trip->e[ei].rtp && trip->e[ei].rtp->mark == 1)
 		break;
 	if (ei == 3) {		/* in last triangle */
-	    if (ccw(&eps[1], dq.pnlps[dq.fpnlpi]->pp,
-		    dq.pnlps[dq.lpnlpi]->pp) == ISCCW)
-		lpnlp = dq.pnlps[dq.lpnlpi], rpnlp = &epnls[1];
+	    if (ccw(&eps[1], dq->pnlps[dq->fpnlpi]->pp,
+		    dq->pnlps[dq->lpnlpi]->pp) == ISCCW)
+		lpnlp = dq->pnlps[dq->lpnlpi], rpnlp = &epnls[1];
 	    else
-		lpnlp = &epnls[1], rpnlp = dq.pnlps[dq.lpnlpi];
+		lpnlp = &epnls[1], rpnlp = dq->pnlps[dq->lpnlpi];
 	} else {
 	    pnlp = trip->e[(ei + 1) % 3].pnl1p;
 	    if (ccw(trip->e[ei].pnl0p->pp, pnlp->pp,
@@ -239,32 +280,32 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 
 	/* update deque */
 	if (trii == ftrii) {
-	    add2dq(DQ_BACK, lpnlp);
-	    add2dq(DQ_FRONT, rpnlp);
+	    add2dq(dq, DQ_BACK, lpnlp);
+	    add2dq(dq, DQ_FRONT, rpnlp);
 	} else {
-	    if (dq.pnlps[dq.fpnlpi] != rpnlp
-		&& dq.pnlps[dq.lpnlpi] != rpnlp) {
+	    if (dq->pnlps[dq->fpnlpi] != rpnlp
+		&& dq->pnlps[dq->lpnlpi] != rpnlp) {
 		/* add right point to deque */
-		splitindex = finddqsplit(rpnlp);
-		splitdq(DQ_BACK, splitindex);
-		add2dq(DQ_FRONT, rpnlp);
+		splitindex = finddqsplit(dq, rpnlp);
+		splitdq(dq, DQ_BACK, splitindex);
+		add2dq(dq, DQ_FRONT, rpnlp);
 		/* if the split is behind the apex, then reset apex */
-		if (splitindex > dq.apex)
-		    dq.apex = splitindex;
+		if (splitindex > dq->apex)
+		    dq->apex = splitindex;
 	    } else {
 		/* add left point to deque */
-		splitindex = finddqsplit(lpnlp);
-		splitdq(DQ_FRONT, splitindex);
-		add2dq(DQ_BACK, lpnlp);
+		splitindex = finddqsplit(dq, lpnlp);
+		splitdq(dq, DQ_FRONT, splitindex);
+		add2dq(dq, DQ_BACK, lpnlp);
 		/* if the split is in front of the apex, then reset apex */
-		if (splitindex < dq.apex)
-		    dq.apex = splitindex;
+		if (splitindex < dq->apex)
+		    dq->apex = splitindex;
 	    }
 	}
 	trii = -1;
 	for (ei = 0; ei < 3; ei++)
 	    if (trip->e[ei].rtp && trip->e[ei].rtp->mark == 1) {
-		trii = trip->e[ei].rtp - tris;
+		trii = trip->e[ei].rtp - s->tris;
 		break;
 	    }
     }
@@ -278,18 +319,18 @@ int Pshortestpath(Ppoly_t * polyp, Ppoint_t eps[2], Ppolyline_t * output)
 
     for (pi = 0, pnlp = &epnls[1]; pnlp; pnlp = pnlp->link)
 	pi++;
-    if (growops(pi) != 0)
+    if (growops(s, pi) != 0)
 	return -2;
     output->pn = pi;
     for (pi = pi - 1, pnlp = &epnls[1]; pnlp; pi--, pnlp = pnlp->link)
-	ops[pi] = *pnlp->pp;
-    output->ps = ops;
+	s->ops[pi] = *pnlp->pp;
+    output->ps = s->ops;
 
     return 0;
 }
 
 /* triangulate polygon */
-static int triangulate(pointnlink_t ** pnlps, int pnln)
+static int triangulate(shortest_t * s, pointnlink_t ** pnlps, int pnln)
 {
     int pnli, pnlip1, pnlip2;
 
@@ -301,17 +342,17 @@ static int triangulate(pointnlink_t ** pnlps, int pnln)
 			pnlip2 = (pnli + 2) % pnln;
 			if (isdiagonal(pnli, pnlip2, pnlps, pnln)) 
 			{
-				if (loadtriangle(pnlps[pnli], pnlps[pnlip1], pnlps[pnlip2]) != 0)
+				if (loadtriangle(s, pnlps[pnli], pnlps[pnlip1], pnlps[pnlip2]) != 0)
 					return -1;
 				for (pnli = pnlip1; pnli < pnln - 1; pnli++)
 					pnlps[pnli] = pnlps[pnli + 1];
-				return triangulate(pnlps, pnln - 1);
+				return triangulate(s, pnlps, pnln - 1);
 			}
 		}
 		prerror("triangulation failed");
     } 
 	else {
-		if (loadtriangle(pnlps[0], pnlps[1], pnlps[2]) != 0)
+		if (loadtriangle(s, pnlps[0], pnlps[1], pnlps[2]) != 0)
 			return -1;
 	}
 
@@ -354,18 +395,18 @@ static bool isdiagonal(int pnli, int pnlip2, pointnlink_t ** pnlps,
     return true;
 }
 
-static int loadtriangle(pointnlink_t * pnlap, pointnlink_t * pnlbp,
-			 pointnlink_t * pnlcp)
+static int loadtriangle(shortest_t * s, pointnlink_t * pnlap,
+			pointnlink_t * pnlbp, pointnlink_t * pnlcp)
 {
     triangle_t *trip;
     int ei;
 
     /* make space */
-    if (tril >= trin) {
-	if (growtris(trin + 20) != 0)
+    if (s->tril >= s->trin) {
+	if (growtris(s, s->trin + 20) != 0)
 		return -1;
     }
-    trip = &tris[tril++];
+    trip = &s->tris[s->tril++];
     trip->mark = 0;
     trip->e[0].pnl0p = pnlap, trip->e[0].pnl1p = pnlbp, trip->e[0].rtp =
 	NULL;
@@ -380,14 +421,14 @@ static int loadtriangle(pointnlink_t * pnlap, pointnlink_t * pnlbp,
 }
 
 /* connect a pair of triangles at their common edge (if any) */
-static void connecttris(int tri1, int tri2)
+static void connecttris(shortest_t * s, int tri1, int tri2)
 {
     triangle_t *tri1p, *tri2p;
     int ei, ej;
 
     for (ei = 0; ei < 3; ei++) {
 	for (ej = 0; ej < 3; ej++) {
-	    tri1p = &tris[tri1], tri2p = &tris[tri2];
+	    tri1p = &s->tris[tri1], tri2p = &s->tris[tri2];
 	    if ((tri1p->e[ei].pnl0p->pp == tri2p->e[ej].pnl0p->pp &&
 		 tri1p->e[ei].pnl1p->pp == tri2p->e[ej].pnl1p->pp) ||
 		(tri1p->e[ei].pnl0p->pp == tri2p->e[ej].pnl1p->pp &&
@@ -398,60 +439,60 @@ static void connecttris(int tri1, int tri2)
 }
 
 /* find and mark path from trii, to trij */
-static bool marktripath(int trii, int trij)
+static bool marktripath(shortest_t * s, int trii, int trij)
 {
     int ei;
 
-    if (tris[trii].mark)
+    if (s->tris[trii].mark)
 	return false;
-    tris[trii].mark = 1;
+    s->tris[trii].mark = 1;
     if (trii == trij)
 	return true;
     for (ei = 0; ei < 3; ei++)
-	if (tris[trii].e[ei].rtp &&
-	    marktripath(tris[trii].e[ei].rtp - tris, trij))
+	if (s->tris[trii].e[ei].rtp &&
+	    marktripath(s, s->tris[trii].e[ei].rtp - s->tris, trij))
 	    return true;
-    tris[trii].mark = 0;
+    s->tris[trii].mark = 0;
     return false;
 }
 
 /* add a new point to the deque, either front or back */
-static void add2dq(int side, pointnlink_t * pnlp)
+static void add2dq(deque_t * dq, int side, pointnlink_t * pnlp)
 {
     if (side == DQ_FRONT) {
-	if (dq.lpnlpi - dq.fpnlpi >= 0)
-	    pnlp->link = dq.pnlps[dq.fpnlpi];	/* shortest path links */
-	dq.fpnlpi--;
-	dq.pnlps[dq.fpnlpi] = pnlp;
+	if (dq->lpnlpi - dq->fpnlpi >= 0)
+	    pnlp->link = dq->pnlps[dq->fpnlpi];	/* shortest path links */
+	dq->fpnlpi--;
+	dq->pnlps[dq->fpnlpi] = pnlp;
     } else {
-	if (dq.lpnlpi - dq.fpnlpi >= 0)
-	    pnlp->link = dq.pnlps[dq.lpnlpi];	/* shortest path links */
-	dq.lpnlpi++;
-	dq.pnlps[dq.lpnlpi] = pnlp;
+	if (dq->lpnlpi - dq->fpnlpi >= 0)
+	    pnlp->link = dq->pnlps[dq->lpnlpi];	/* shortest path links */
+	dq->lpnlpi++;
+	dq->pnlps[dq->lpnlpi] = pnlp;
     }
 }
 
-static void splitdq(int side, int index)
+static void splitdq(deque_t * dq, int side, int index)
 {
     if (side == DQ_FRONT)
-	dq.lpnlpi = index;
+	dq->lpnlpi = index;
     else
-	dq.fpnlpi = index;
+	dq->fpnlpi = index;
 }
 
-static int finddqsplit(pointnlink_t * pnlp)
+static int finddqsplit(deque_t * dq, pointnlink_t * pnlp)
 {
     int index;
 
-    for (index = dq.fpnlpi; index < dq.apex; index++)
-	if (ccw(dq.pnlps[index + 1]->pp, dq.pnlps[index]->pp, pnlp->pp) ==
+    for (index = dq->fpnlpi; index < dq->apex; index++)
+	if (ccw(dq->pnlps[index + 1]->pp, dq->pnlps[index]->pp, pnlp->pp) ==
 	    ISCCW)
 	    return index;
-    for (index = dq.lpnlpi; index > dq.apex; index--)
-	if (ccw(dq.pnlps[index - 1]->pp, dq.pnlps[index]->pp, pnlp->pp) ==
+    for (index = dq->lpnlpi; index > dq->apex; index--)
+	if (ccw(dq->pnlps[index - 1]->pp, dq->pnlps[index]->pp, pnlp->pp) ==
 	    ISCW)
 	    return index;
-    return dq.apex;
+    return dq->apex;
 }
 
 /* ccw test: CCW, CW, or co-linear */
@@ -498,67 +539,67 @@ static bool between(Ppoint_t * pap, Ppoint_t * pbp, Ppoint_t * pcp)
 	(p2.x * p2.x + p2.y * p2.y <= p1.x * p1.x + p1.y * p1.y);
 }
 
-static int pointintri(int trii, Ppoint_t * pp)
+static int pointintri(shortest_t * s, int trii, Ppoint_t * pp)
 {
     int ei, sum;
 
     for (ei = 0, sum = 0; ei < 3; ei++)
-	if (ccw(tris[trii].e[ei].pnl0p->pp,
-		tris[trii].e[ei].pnl1p->pp, pp) != ISCW)
+	if (ccw(s->tris[trii].e[ei].pnl0p->pp,
+		s->tris[trii].e[ei].pnl1p->pp, pp) != ISCW)
 	    sum++;
     return (sum == 3 || sum == 0);
 }
 
-static int growpnls(int newpnln)
+static int growpnls(shortest_t * s, int newpnln)
 {
-    if (newpnln <= pnln)
+    if (newpnln <= s->pnln)
 	return 0;
-    if (!(pnls = realloc(pnls, POINTNLINKSIZE * newpnln))) {
+    if (!(s->pnls = realloc(s->pnls, POINTNLINKSIZE * newpnln))) {
 	prerror("cannot realloc pnls");
 	return -1;
     }
-    if (!(pnlps = realloc(pnlps, POINTNLINKPSIZE * newpnln))) {
+    if (!(s->pnlps = realloc(s->pnlps, POINTNLINKPSIZE * newpnln))) {
 	prerror("cannot realloc pnlps");
 	return -1;
     }
-    pnln = newpnln;
+    s->pnln = newpnln;
     return 0;
 }
 
-static int growtris(int newtrin)
+static int growtris(shortest_t * s, int newtrin)
 {
-    if (newtrin <= trin)
+    if (newtrin <= s->trin)
 	return 0;
-    if (!(tris = realloc(tris, TRIANGLESIZE * newtrin))) {
+    if (!(s->tris = realloc(s->tris, TRIANGLESIZE * newtrin))) {
 	prerror("cannot realloc tris");
 	return -1;
     }
-    trin = newtrin;
+    s->trin = newtrin;
 
     return 0;
 }
 
-static int growdq(int newdqn)
+static int growdq(shortest_t * s, int newdqn)
 {
-    if (newdqn <= dq.pnlpn)
+    if (newdqn <= s->dq.pnlpn)
 	return 0;
-    if (!(dq.pnlps = realloc(dq.pnlps, POINTNLINKPSIZE * newdqn))) {
+    if (!(s->dq.pnlps = realloc(s->dq.pnlps, POINTNLINKPSIZE * newdqn))) {
 	prerror("cannot realloc dq.pnls");
 	return -1;
     }
-    dq.pnlpn = newdqn;
+    s->dq.pnlpn = newdqn;
     return 0;
 }
 
-static int growops(int newopn)
+static int growops(shortest_t * s, int newopn)
 {
-    if (newopn <= opn)
+    if (newopn <= s->opn)
 	return 0;
-    if (!(ops = realloc(ops, POINTSIZE * newopn))) {
+    if (!(s->ops = realloc(s->ops, POINTSIZE * newopn))) {
 	prerror("cannot realloc ops");
 	return -1;
     }
-    opn = newopn;
+    s->opn = newopn;
 
     return 0;
 }
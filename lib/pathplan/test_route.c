@@ -0,0 +1,107 @@
+// basic unit tester for Proutespline
+
+#ifdef NDEBUG
+#error this is not intended to be compiled with assertions off
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// include route.c and what it uses so we can be compiled standalone
+#include <pathplan/route.c>
+#include <pathplan/solvers.c>
+
+// two rectangular obstacles, one above and one below the route
+static Pedge_t barriers[8];
+
+static void make_barriers(void) {
+  const Ppoint_t above[] = {{3, 3}, {5, 3}, {5, 5}, {3, 5}};
+  const Ppoint_t below[] = {{1, -3}, {7, -3}, {7, -1}, {1, -1}};
+  for (int i = 0; i < 4; i++) {
+    barriers[i].a = above[i];
+    barriers[i].b = above[(i + 1) % 4];
+    barriers[4 + i].a = below[i];
+    barriers[4 + i].b = below[(i + 1) % 4];
+  }
+}
+
+static Ppoint_t path[] = {{0, 0}, {2, 1.5}, {4, 2}, {6, 1.5}, {8, 0}};
+
+static void check(Ppolyline_t spline, const Ppoint_t *expected, int n) {
+  assert(spline.pn == n);
+  for (int i = 0; i < n; i++) {
+    assert(fabs(spline.ps[i].x - expected[i].x) < 1e-9);
+    assert(fabs(spline.ps[i].y - expected[i].y) < 1e-9);
+  }
+}
+
+// a route with free slopes at its ends
+static const Ppoint_t free_ends[] = {
+    {0, 0}, {0, 0}, {2.0123840200001872, 2}, {4, 2},
+    {5.9876159799998128, 2}, {8, 0}, {8, 0}};
+
+// the same route leaving and arriving horizontally
+static const Ppoint_t horizontal_ends[] = {
+    {0, 0}, {1.987615979999813, 0}, {2.0123840200001872, 2}, {4, 2},
+    {5.9876159799998128, 2}, {6.0123840200001872, 0}, {8, 0}};
+
+static void test_route(void) {
+  Ppolyline_t input = {path, sizeof(path) / sizeof(path[0])};
+  Pvector_t evs[2] = {{0, 0}, {0, 0}};
+  Ppolyline_t spline;
+
+  int rc = Proutespline(barriers, 8, input, evs, &spline);
+  assert(rc == 0);
+  check(spline, free_ends, sizeof(free_ends) / sizeof(free_ends[0]));
+}
+
+// calls with their own buffers must not disturb each other
+static void test_independent_outputs(void) {
+  Ppolyline_t input = {path, sizeof(path) / sizeof(path[0])};
+  Pvector_t evs1[2] = {{0, 0}, {0, 0}};
+  Pvector_t evs2[2] = {{1, 0}, {1, 0}};
+  Ppolyline_t spline1 = {0}, spline2 = {0};
+  int cap1 = 0, cap2 = 0;
+
+  int rc = Proutespline_r(barriers, 8, input, evs1, &spline1, &cap1);
+  assert(rc == 0);
+  rc = Proutespline_r(barriers, 8, input, evs2, &spline2, &cap2);
+  assert(rc == 0);
+  assert(spline1.ps != spline2.ps);
+
+  check(spline1, free_ends, sizeof(free_ends) / sizeof(free_ends[0]));
+  check(spline2, horizontal_ends,
+        sizeof(horizontal_ends) / sizeof(horizontal_ends[0]));
+
+  // a buffer can be reused, and is only grown when too small
+  Ppoint_t *ps = spline1.ps;
+  rc = Proutespline_r(barriers, 8, input, evs2, &spline1, &cap1);
+  assert(rc == 0);
+  assert(spline1.ps == ps);
+  check(spline1, horizontal_ends,
+        sizeof(horizontal_ends) / sizeof(horizontal_ends[0]));
+
+  free(spline1.ps);
+  free(spline2.ps);
+}
+
+int main(void) {
+
+#define RUN(t)                                                                 \
+  do {                                                                         \
+    printf("running test_%s... ", #t);                                         \
+    fflush(stdout);                                                            \
+    test_##t();                                                                \
+    printf("OK\n");                                                            \
+  } while (0)
+
+  make_barriers();
+  RUN(route);
+  RUN(independent_outputs);
+
+#undef RUN
+
+  return EXIT_SUCCESS;
+}
@@ -52,19 +52,21 @@ int Ppolybarriers(Ppoly_t ** polys, int npolys, Pedge_t ** barriers,
     return 1;
 }
 
-/* make_polyline:
+/* make_polyline_r:
+ * As make_polyline, but the points are written to sline->ps, which is NULL
+ * or an array from malloc with room for *capacity points. It is grown as
+ * needed and stays owned by the caller.
  */
 void
-make_polyline(Ppolyline_t line, Ppolyline_t* sline)
+make_polyline_r(Ppolyline_t line, Ppolyline_t* sline, int *capacity)
 {
-    static int isz = 0;
-    static Ppoint_t* ispline = 0;
+    Ppoint_t* ispline = sline->ps;
     int i, j;
     int npts = 4 + 3*(line.pn-2);
 
-    if (npts > isz) {
+    if (!ispline || npts > *capacity) {
 	ispline = ALLOC(npts, ispline, Ppoint_t); 
-	isz = npts;
+	*capacity = npts;
     }
 
     j = i = 0;
@@ -81,3 +83,16 @@ make_polyline(Ppolyline_t line, Ppolyline_t* sline)
     sline->ps = ispline;
 }
 
+/* make_polyline:
+ */
+void
+make_polyline(Ppolyline_t line, Ppolyline_t* sline)
+{
+    static int isz = 0;
+    static Ppoint_t* ispline = 0;
+
+    sline->ps = ispline;
+    make_polyline_r(line, sline, &isz);
+    ispline = sline->ps;
+}
+
@@ -117,6 +117,7 @@ StressMajorizationSmoother StressMajorizationSmoother2_new(SparseMatrix A, int d
   sm = GNEW(struct StressMajorizationSmoother_struct);
   sm->scaling = 1.;
   sm->data = NULL;
+  sm->unfixed = NULL;
   sm->scheme = SM_SCHEME_NORMAL;
   sm->tol_cg = 0.01;
   sm->maxit_cg = (int)sqrt((double) A->m);
@@ -318,6 +319,7 @@ StressMajorizationSmoother SparseStressMajorizationSmoother_new(SparseMatrix A,
   sm = MALLOC(sizeof(struct StressMajorizationSmoother_struct));
   sm->scaling = 1.;
   sm->data = NULL;
+  sm->unfixed = NULL;
   sm->scheme = SM_SCHEME_NORMAL;
   sm->D = A;
   sm->tol_cg = 0.01;
@@ -644,12 +646,14 @@ double StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim,
 	    dd[j] = 0;
 	  } else {
 	    if (dist == 0){
+	      int mv = sm->unfixed && !sm->unfixed[jd[j]] ? i : jd[j];
 	      dij = d[j]/w[j];/* the ideal distance */
-	      /* perturb so points do not sit at the same place */
-	      for (k = 0; k < dim; k++) x[jd[j]*dim+k] += 0.0001*(drand()+.0001)*dij;
+	      /* perturb so points do not sit at the same place, moving one that is not pinned */
+	      if (!sm->unfixed || sm->unfixed[mv])
+		for (k = 0; k < dim; k++) x[mv*dim+k] += 0.0001*(drand()+.0001)*dij;
 	      dist = distance(x, dim, i, jd[j]);	
 	    }
-	    dd[j] = d[j]/dist;
+	    dd[j] = dist == 0 ? 0 : d[j]/dist;/* two pinned nodes may share a place */
 	    
 	  }
 	diag += dd[j];
@@ -708,6 +712,11 @@ double StressMajorizationSmoother_smooth(StressMajorizationSmoother sm, int dim,
     }
 
     if (flag) goto RETURN;
+    if (sm->unfixed){/* pinned nodes go back to where they started */
+      for (i = 0; i < m; i++){
+	if (!sm->unfixed[i]) memcpy(&y[i*dim], &x0[i*dim], sizeof(double)*dim);
+      }
+    }
 #ifdef DEBUG_PRINT
     if (Verbose) fprintf(stderr, "stress2 = %g\n",get_stress(m, dim, iw, jw, w, d, y, sm->scaling, sm->data, 1));
 #endif
@@ -780,6 +789,7 @@ TriangleSmoother TriangleSmoother_new(SparseMatrix A, int dim, double lambda0, d
   sm = N_GNEW(1,struct TriangleSmoother_struct);
   sm->scaling = 1;
   sm->data = NULL;
+  sm->unfixed = NULL;
   sm->scheme = SM_SCHEME_NORMAL;
   sm->tol_cg = 0.01;
   sm->maxit_cg = (int)sqrt((double) A->m);
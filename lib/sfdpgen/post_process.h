@@ -11,6 +11,7 @@
 #pragma once
 
 #include <sfdpgen/spring_electrical.h>
+#include <stdbool.h>
 
 enum {SM_SCHEME_NORMAL, SM_SCHEME_NORMAL_ELABEL, SM_SCHEME_UNIFORM_STRESS, SM_SCHEME_MAXENT, SM_SCHEME_STRESS_APPROX, SM_SCHEME_STRESS};
 
@@ -27,6 +28,7 @@ struct StressMajorizationSmoother_struct {
 		 typically the Laplacian only needs to be solved very crudely as it is part of an
 		 outer iteration.*/
   int maxit_cg;
+  const bool *unfixed;/* NULL, or false for the nodes that are pinned and keep their initial position. Owned by the caller */
 };
 
 typedef struct StressMajorizationSmoother_struct *StressMajorizationSmoother;
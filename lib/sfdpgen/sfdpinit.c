@@ -135,7 +135,7 @@ static void sfdpLayout(graph_t * g, spring_electrical_control ctrl,
 	    D = DD;
 	}
 
-	stress_model(Ndim, A, D, &pos, TRUE, maxit, tol, &flag);
+	stress_model(Ndim, A, D, &pos, TRUE, maxit, tol, NULL, &flag);
 	}
 	break;
     }
@@ -265,6 +265,32 @@ tuneControl (graph_t* g, spring_electrical_control ctrl)
 	agerr (AGWARN, "label_scheme = %d > 4 : ignoring\n", ctrl->edge_labeling_scheme);
 	ctrl->edge_labeling_scheme = 0;
     }
+    ctrl->nthreads = late_int(g, agfindgraphattr(g, "threads"), 1, 1);
+}
+
+/* state shared by the components of a graph, for sfdpComponent */
+typedef struct {
+    spring_electrical_control ctrl;
+    int hops;
+    pointf pad;
+    int doAdjust;
+    adjust_data *am;
+} sfdp_args;
+
+/* sfdpComponent:
+ * Lay out one connected component of a disconnected graph.
+ */
+static int sfdpComponent(graph_t * sg, int i, void *state)
+{
+    sfdp_args *args = state;
+
+    (void)i;
+    nodeInduce(sg);
+    sfdpLayout(sg, args->ctrl, args->hops, args->pad);
+    if (args->doAdjust) removeOverlapWith(sg, args->am);
+    setEdgeType(sg, EDGETYPE_LINE);
+    spline_edges(sg);
+    return 0;
 }
 
 void sfdp_layout(graph_t * g)
@@ -277,7 +303,6 @@ void sfdp_layout(graph_t * g)
 
     if (agnnodes(g)) {
 	Agraph_t **ccs;
-	Agraph_t *sg;
 	int ncc;
 	int i;
 	expand_t sep;
@@ -319,18 +344,11 @@ void sfdp_layout(graph_t * g)
 	    spline_edges(g);
 	} else {
 	    pack_info pinfo;
+	    sfdp_args args = {ctrl, hops, pad, doAdjust, &am};
 	    getPackInfo(g, l_node, CL_OFFSET, &pinfo);
 	    pinfo.doSplines = 1;
 
-	    for (i = 0; i < ncc; i++) {
-		sg = ccs[i];
-		nodeInduce(sg);
-		sfdpLayout(sg, ctrl, hops, pad);
-		if (doAdjust) removeOverlapWith(sg, &am);
-		setEdgeType(sg, EDGETYPE_LINE);
-		spline_edges(sg);
-	    }
-	    packSubgraphs(ncc, ccs, g, &pinfo);
+	    packLayouts(ncc, ccs, g, &pinfo, sfdpComponent, &args);
 	}
 	for (i = 0; i < ncc; i++) {
 	    agdelete(g, ccs[i]);
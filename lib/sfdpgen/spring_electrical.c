@@ -20,6 +20,7 @@
 #include <common/memory.h>
 #include <common/arith.h>
 #include <common/logic.h>
+#include <common/parallel.h>
 #include <math.h>
 #include <common/globals.h>
 #include <stdbool.h>
@@ -66,6 +67,7 @@ spring_electrical_control spring_electrical_control_new(){
   ctrl->initial_scaling = -4;
   ctrl->rotation = 0.;
   ctrl->edge_labeling_scheme = 0;
+  ctrl->nthreads = 1;
   return ctrl;
 }
 
@@ -100,7 +102,7 @@ void spring_electrical_control_print(spring_electrical_control ctrl){
   fprintf (stderr, "  smoothing %s overlap %d initial_scaling %.03f do_shrinking %d\n",
     smoothings[ctrl->smoothing], ctrl->overlap, ctrl->initial_scaling, ctrl->do_shrinking);
   fprintf (stderr, "  octree scheme %s method %s\n", tschemes[ctrl->tscheme], methods[ctrl->method]);
-  fprintf (stderr, "  edge_labeling_scheme %d\n", ctrl->edge_labeling_scheme);
+  fprintf (stderr, "  edge_labeling_scheme %d threads %d\n", ctrl->edge_labeling_scheme, ctrl->nthreads);
 }
 
 void oned_optimizer_delete(oned_optimizer opt){
@@ -482,19 +484,52 @@ void force_print(FILE *fp, int n, int dim, double *x, double *force){
 }
 
 
+/* the attractive forces of spring_electrical_embedding_fast. Each node only
+   adds to its own force, so the nodes are shared out in blocks. */
+typedef struct {
+  int dim;
+  int n;
+  int *ia;
+  int *ja;
+  double CRK;
+  double *x;
+  double *force;
+} attractive_job;
+
+static void attractive_force_part(void *arg, int t, int nthreads){
+  attractive_job *job = arg;
+  int dim = job->dim, *ia = job->ia, *ja = job->ja;
+  double CRK = job->CRK, *x = job->x, *f, dist;
+  int i, j, k, lo, hi;
+
+  parallel_range(job->n, t, nthreads, &lo, &hi);
+  for (i = lo; i < hi; i++){
+    f = &(job->force[i*dim]);
+    for (j = ia[i]; j < ia[i+1]; j++){
+      if (ja[j] == i) continue;
+      dist = distance(x, dim, i, ja[j]);
+      for (k = 0; k < dim; k++){
+	f[k] -= CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
+      }
+    }
+  }
+}
+
 void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *node_weights, double *x, int *flag){
   /* x is a point to a 1D array, x[i*dim+j] gives the coordinate of the i-th node at dimension j.  */
   SparseMatrix A = A0;
   int m, n;
-  int i, j, k;
+  int i, k;
   double p = ctrl->p, K = ctrl->K, C = ctrl->C, CRK, tol = ctrl->tol, maxiter = ctrl->maxiter, cool = ctrl->cool, step = ctrl->step, KP;
   int *ia = NULL, *ja = NULL;
   double *xold = NULL;
-  double *f = NULL, dist, F, Fnorm = 0, Fnorm0;
+  double *f = NULL, F, Fnorm = 0, Fnorm0;
   int iter = 0;
   int adaptive_cooling = ctrl->adaptive_cooling;
   QuadTree qt = NULL;
+  QuadTree_arena qt_arena = NULL;
   double counts[4], *force = NULL;
+  attractive_job attractive;
 #ifdef TIME
   clock_t start, end, start0;
   double qtree_cpu = 0, qtree_cpu0 = 0, qtree_new_cpu = 0, qtree_new_cpu0 = 0;
@@ -535,6 +570,14 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
 
   xold = MALLOC(sizeof(double)*dim*n);
   force = MALLOC(sizeof(double)*dim*n);
+  attractive.dim = dim;
+  attractive.n = n;
+  attractive.ia = ia;
+  attractive.ja = ja;
+  attractive.CRK = CRK;
+  attractive.force = force;
+  /* the quadtree is rebuilt every iteration, so keep its storage around */
+  qt_arena = QuadTree_arena_new();
 
   do {
 #ifdef TIME
@@ -552,9 +595,9 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
     start = clock();
 #endif
     if (ctrl->use_node_weights){
-      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, node_weights);
+      qt = QuadTree_arena_new_from_point_list(qt_arena, dim, n, max_qtree_level, x, node_weights);
     } else {
-      qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
+      qt = QuadTree_arena_new_from_point_list(qt_arena, dim, n, max_qtree_level, x, NULL);
     }
 
 #ifdef TIME
@@ -566,7 +609,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
     start = clock();
 #endif
 
-    QuadTree_get_repulsive_force(qt, force, x, ctrl->bh, p, KP, counts, flag);
+    QuadTree_get_repulsive_force(qt, force, x, ctrl->bh, p, KP, counts, ctrl->nthreads, flag);
 
     assert(!(*flag));
 
@@ -576,16 +619,8 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
 #endif
 
     /* attractive force   C^((2-p)/3) ||x_i-x_j||/K * (x_j - x_i) */
-    for (i = 0; i < n; i++){
-      f = &(force[i*dim]);
-      for (j = ia[i]; j < ia[i+1]; j++){
-	if (ja[j] == i) continue;
-	dist = distance(x, dim, i, ja[j]);
-	for (k = 0; k < dim; k++){
-	  f[k] -= CRK*(x[i*dim+k] - x[ja[j]*dim+k])*dist;
-	}
-      }
-    }
+    attractive.x = x;
+    parallel_run(ctrl->nthreads, attractive_force_part, &attractive);
 
 
     /* move */
@@ -602,15 +637,6 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
 
 
     if (qt) {
-#ifdef TIME
-      start = clock();
-#endif
-      QuadTree_delete(qt);
-#ifdef TIME
-      end = clock();
-      qtree_new_cpu += ((double) (end - start)) / CLOCKS_PER_SEC;
-#endif
-
 #ifdef TIME
       qtree_cpu0 = qtree_cpu - qtree_cpu0;
       qtree_new_cpu0 = qtree_new_cpu - qtree_new_cpu0;
@@ -662,6 +688,7 @@ void spring_electrical_embedding_fast(int dim, SparseMatrix A0, spring_electrica
   free(xold);
   if (A != A0) SparseMatrix_delete(A);
   free(force);
+  QuadTree_arena_delete(qt_arena);
 }
 
 static void spring_electrical_embedding_slow(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *node_weights, double *x, int *flag){
@@ -913,6 +940,53 @@ static void spring_electrical_embedding_slow(int dim, SparseMatrix A0, spring_el
 
 
 
+/* the repulsive forces of spring_electrical_embedding from the quadtree
+   supernodes. They only depend on the tree and on the position of the node
+   itself, which nothing else moves during an iteration, so they can all be
+   found before the nodes are moved one by one. */
+typedef struct {
+  QuadTree qt;
+  int dim;
+  int n;
+  double bh;
+  double p;
+  double KP;
+  double *x;
+  double *force;/* the force on node i is force[i*dim+k] */
+  double *counts;/* the supernode search counts of each part */
+  double *nsuper;/* the number of supernodes of each part */
+} supernode_job;
+
+static void supernode_force_part(void *arg, int t, int nthreads){
+  supernode_job *job = arg;
+  int dim = job->dim, nsuper = 0, nsupermax = 10, flag;
+  double *x = job->x, *f, dist, counts;
+  double *center = MALLOC(sizeof(double)*nsupermax*dim);
+  double *supernode_wgts = MALLOC(sizeof(double)*nsupermax);
+  double *distances = MALLOC(sizeof(double)*nsupermax);
+  int i, j, k, lo, hi;
+
+  parallel_range(job->n, t, nthreads, &lo, &hi);
+  job->counts[t] = job->nsuper[t] = 0;
+  for (i = lo; i < hi; i++){
+    QuadTree_get_supernodes(job->qt, job->bh, &(x[dim*i]), i, &nsuper, &nsupermax,
+			    &center, &supernode_wgts, &distances, &counts, &flag);
+    job->counts[t] += counts;
+    job->nsuper[t] += nsuper;
+    f = &(job->force[i*dim]);
+    for (k = 0; k < dim; k++) f[k] = 0.;
+    for (j = 0; j < nsuper; j++){
+      dist = MAX(distances[j], MINDIST);
+      for (k = 0; k < dim; k++){
+	f[k] += supernode_wgts[j]*job->KP*(x[i*dim+k] - center[j*dim+k])/pow(dist, 1.- job->p);
+      }
+    }
+  }
+  free(center);
+  free(supernode_wgts);
+  free(distances);
+}
+
 void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_control ctrl, double *node_weights, double *x, int *flag){
   /* x is a point to a 1D array, x[i*dim+j] gives the coordinate of the i-th node at dimension j.  */
   SparseMatrix A = A0;
@@ -928,6 +1002,8 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   int USE_QT = FALSE;
   int nsuper = 0, nsupermax = 10;
   double *center = NULL, *supernode_wgts = NULL, *distances = NULL, nsuper_avg, counts = 0, counts_avg = 0;
+  supernode_job supernodes;
+  double *repulsive = NULL;
 #ifdef TIME
   clock_t start, end, start0, start2;
   double qtree_cpu = 0, qtree_cpu0 = 0;
@@ -971,6 +1047,18 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   KP = pow(K, 1 - p);
   CRK = pow(C, (2.-p)/3.)/K;
 
+  if (USE_QT && ctrl->nthreads > 1){
+    repulsive = MALLOC(sizeof(double)*dim*n);
+    supernodes.dim = dim;
+    supernodes.n = n;
+    supernodes.bh = ctrl->bh;
+    supernodes.p = p;
+    supernodes.KP = KP;
+    supernodes.force = repulsive;
+    supernodes.counts = MALLOC(sizeof(double)*ctrl->nthreads);
+    supernodes.nsuper = MALLOC(sizeof(double)*ctrl->nthreads);
+  }
+
 #ifdef DEBUG_0
   {
     FILE *f;
@@ -1016,7 +1104,15 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
 	qt = QuadTree_new_from_point_list(dim, n, max_qtree_level, x, NULL);
       }
 
-	
+      if (repulsive){
+	supernodes.qt = qt;
+	supernodes.x = x;
+	parallel_run(ctrl->nthreads, supernode_force_part, &supernodes);
+	for (j = 0; j < ctrl->nthreads; j++){
+	  counts_avg += supernodes.counts[j];
+	  nsuper_avg += supernodes.nsuper[j];
+	}
+      }
     }
 #ifdef TIME
     start2 = clock();
@@ -1034,7 +1130,9 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
       }
 
       /* repulsive force K^(1 - p)/||x_i-x_j||^(1 - p) (x_i - x_j) */
-      if (USE_QT){
+      if (repulsive){
+	for (k = 0; k < dim; k++) f[k] += repulsive[i*dim+k];
+      } else if (USE_QT){
 #ifdef TIME
 	start = clock();
 #endif
@@ -1155,6 +1253,11 @@ void spring_electrical_embedding(int dim, SparseMatrix A0, spring_electrical_con
   free(center);
   free(supernode_wgts);
   free(distances);
+  if (repulsive){
+    free(repulsive);
+    free(supernodes.counts);
+    free(supernodes.nsuper);
+  }
 }
 
 static void scale_coord(int n, int dim, double *x, int *id, int *jd, double *d, double dj){
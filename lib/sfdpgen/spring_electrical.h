@@ -59,6 +59,7 @@ struct spring_electrical_control_struct {
 			       0 (no action, default), 1 (penalty based method to make that kind of node close to the center of its neighbor), 
 			       1 (penalty based method to make that kind of node close to the old center of its neighbor),
 			       3 (two step process of overlap removal and straightening) */
+  int nthreads;/* number of threads for the force calculations, default 1 */
 };
 
 typedef struct  spring_electrical_control_struct  *spring_electrical_control; 
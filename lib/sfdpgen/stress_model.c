@@ -4,7 +4,7 @@
 #include <sfdpgen/post_process.h>
 #include <sfdpgen/stress_model.h>
 
-static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_weighted, int maxit_sm, double tol, int *flag){
+static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_weighted, int maxit_sm, double tol, const bool *unfixed, int *flag){
   int m;
   SparseStressMajorizationSmoother sm;
   double lambda = 0;
@@ -29,10 +29,11 @@ static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_
     for (i = 0; i < dim*m; i++) (*x)[i] = drand();
   }
 
+  /* pinned positions are final, so the initial layout must not be rescaled */
   if (edge_len_weighted){
-    sm = SparseStressMajorizationSmoother_new(A, dim, lambda, *x, WEIGHTING_SCHEME_SQR_DIST, TRUE);/* do not under weight the long distances */
+    sm = SparseStressMajorizationSmoother_new(A, dim, lambda, *x, WEIGHTING_SCHEME_SQR_DIST, !unfixed);/* do not under weight the long distances */
   } else {
-    sm = SparseStressMajorizationSmoother_new(A, dim, lambda, *x, WEIGHTING_SCHEME_NONE, TRUE);/* weight the long distances */
+    sm = SparseStressMajorizationSmoother_new(A, dim, lambda, *x, WEIGHTING_SCHEME_NONE, !unfixed);/* weight the long distances */
   }
 
   if (!sm) {
@@ -43,6 +44,7 @@ static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_
 
   sm->tol_cg = 0.1; /* we found that there is no need to solve the Laplacian accurately */
   sm->scheme = SM_SCHEME_STRESS;
+  sm->unfixed = unfixed;
   SparseStressMajorizationSmoother_smooth(sm, dim, *x, maxit_sm, tol);
   for (i = 0; i < dim*m; i++) {
     (*x)[i] /= sm->scaling;
@@ -53,6 +55,6 @@ static void stress_model_core(int dim, SparseMatrix B, double **x, int edge_len_
   if (A != B) SparseMatrix_delete(A);
 }
 
-void stress_model(int dim, SparseMatrix A, SparseMatrix D, double **x, int edge_len_weighted, int maxit_sm, double tol, int *flag){
-  stress_model_core(dim, D, x, edge_len_weighted, maxit_sm, tol, flag);
+void stress_model(int dim, SparseMatrix A, SparseMatrix D, double **x, int edge_len_weighted, int maxit_sm, double tol, const bool *unfixed, int *flag){
+  stress_model_core(dim, D, x, edge_len_weighted, maxit_sm, tol, unfixed, flag);
 }
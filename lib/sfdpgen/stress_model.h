@@ -1,3 +1,6 @@
 #pragma once
 
-void stress_model(int dim, SparseMatrix A, SparseMatrix D, double **x, int edge_len_weighted, int maxit, double tol, int *flag);
+#include <stdbool.h>
+
+/* unfixed is NULL, or false for the nodes that are pinned at their position in x */
+void stress_model(int dim, SparseMatrix A, SparseMatrix D, double **x, int edge_len_weighted, int maxit, double tol, const bool *unfixed, int *flag);
@@ -36,6 +36,7 @@ UniformStressSmoother UniformStressSmoother_new(int dim, SparseMatrix A, double
 
   sm = MALLOC(sizeof(struct StressMajorizationSmoother_struct));
   sm->data = NULL;
+  sm->unfixed = NULL;
   sm->scheme = SM_SCHEME_UNIFORM_STRESS;
   sm->lambda = NULL;
   sm->data = MALLOC(sizeof(double)*2);
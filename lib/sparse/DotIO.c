@@ -82,16 +82,15 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, double **label_sizes, double **x,
 {
   SparseMatrix A = 0;
   Agnode_t* n;
-  Agedge_t* e;
+  Agcsr_t *csr;
   Agsym_t *sym, *symD = NULL;
   Agsym_t *psym;
   int nnodes;
   int nedges;
-  int i, row;
+  int i;
   int* I;
   int* J;
   double *val, *valD = NULL;
-  double v;
   int type = MATRIX_TYPE_REAL;
   double padding = 10;
   int nedge_nodes = 0;
@@ -99,20 +98,22 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, double **label_sizes, double **x,
 
 
   if (!g) return NULL;
-  nnodes = agnnodes (g);
-  nedges = agnedges (g);
   if (format != FORMAT_CSR && format != FORMAT_COORD) {
     fprintf (stderr, "Format %d not supported\n", format);
     exit (1);
   }
 
+  sym = agattr(g, AGEDGE, "weight", NULL);
+  if (!(csr = agcsr(g, sym, 1))) return NULL;
+  nnodes = csr->nnodes;
+  nedges = csr->nedges;
+
   /* Assign node ids */
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n))
-    ND_id(n) = i++;
+  for (i = 0; i < nnodes; i++)
+    ND_id(csr->nodes[i]) = i;
 
   if (format == FORMAT_COORD){
-    A = SparseMatrix_new(i, i, nedges, MATRIX_TYPE_REAL, format);
+    A = SparseMatrix_new(nnodes, nnodes, nedges, MATRIX_TYPE_REAL, format);
     A->nz = nedges;
     I = A->ia;
     J = A->ja;
@@ -123,42 +124,29 @@ SparseMatrix_import_dot (Agraph_t* g, int dim, double **label_sizes, double **x,
     val = N_NEW(nedges, double);
   }
 
-  sym = agattr(g, AGEDGE, "weight", NULL);
   if (D) {
     symD = agattr(g, AGEDGE, "len", NULL);
-    valD = N_NEW(nedges, double);
+    valD = symD ? agcsrcolumn(csr, symD, 1) : N_NEW(nedges, double);
   }
-  i = 0;
-  for (n = agfstnode (g); n; n = agnxtnode (g, n)) {
-    if (edge_label_nodes && strncmp(agnameof(n), "|edgelabel|",11)==0) nedge_nodes++;
-    row = ND_id(n);
-    for (e = agfstout (g, n); e; e = agnxtout (g, e)) {
-      I[i] = row;
-      J[i] = ND_id(aghead(e));
-
-      /* edge weight */
-      if (sym) {
-        if (sscanf (agxget(e,sym), "%lf", &v) != 1) v = 1;
-      } else {
-        v = 1;
-      }
-      val[i] = v;
-
-      /* edge length */
-      if (symD) {
-        if (sscanf (agxget (e, symD), "%lf", &v) != 1) {
-          v = 72;
-        } else {
-          v *= 72;/* len is specified in inch. Convert to points */
-        }
-	valD[i] = v;
-      } else if (valD) {
-        valD[i] = 72;
-      }
-
-      i++;
+  if (edge_label_nodes) {
+    for (i = 0; i < nnodes; i++)
+      if (strncmp(agnameof(csr->nodes[i]), "|edgelabel|",11)==0) nedge_nodes++;
+  }
+  for (i = 0; i < nedges; i++) {
+    I[i] = csr->tail[i];
+    J[i] = csr->head[i];
+
+    /* edge weight */
+    val[i] = sym ? csr->weight[i] : 1;
+
+    /* edge length */
+    if (symD) {
+      valD[i] *= 72;/* len is specified in inch. Convert to points */
+    } else if (valD) {
+      valD[i] = 72;
     }
   }
+  agcsrfree(csr);
   
   if (edge_label_nodes) {
     *edge_label_nodes = MALLOC(sizeof(int)*nedge_nodes);
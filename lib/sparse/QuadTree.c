@@ -8,9 +8,12 @@
  * Contributors: Details at https://graphviz.org
  *************************************************************************/
 
+#include "config.h"
+
 #include <sparse/general.h>
 #include <common/geom.h>
 #include <common/arith.h>
+#include <common/parallel.h>
 #include <math.h>
 #include <sparse/LinkedList.h>
 #include <sparse/QuadTree.h>
@@ -26,13 +29,97 @@ struct node_data_struct {
 
 typedef struct node_data_struct *node_data;
 
+typedef struct arena_block_struct *arena_block;
+
+struct arena_block_struct {
+  arena_block next;
+  size_t size;/* capacity of data in bytes */
+  size_t used;
+  char *data;
+};
+
+struct QuadTree_arena_struct {
+  /* a list of blocks that is filled from the front. Resetting the arena only
+     rewinds it, so a quadtree rebuilt every iteration reuses the same blocks
+     instead of allocating and freeing each cell and point separately. */
+  arena_block first;
+  arena_block last;
+  arena_block current;
+};
+
+#define ARENA_BLOCK_SIZE (1 << 16)
+
+QuadTree_arena QuadTree_arena_new(void){
+  QuadTree_arena arena;
+  arena = MALLOC(sizeof(struct QuadTree_arena_struct));
+  arena->first = arena->last = arena->current = NULL;
+  return arena;
+}
+
+void QuadTree_arena_delete(QuadTree_arena arena){
+  arena_block b, next;
+  if (!arena) return;
+  for (b = arena->first; b; b = next){
+    next = b->next;
+    free(b->data);
+    free(b);
+  }
+  free(arena);
+}
+
+static void arena_reset(QuadTree_arena arena){
+  arena->current = arena->first;
+  if (arena->current) arena->current->used = 0;
+}
+
+/* allocate size bytes from arena, or from the heap if arena is NULL */
+static void *qt_alloc(QuadTree_arena arena, size_t size){
+  arena_block b;
+  void *p;
+
+  if (!arena) return MALLOC(size);
 
-static node_data node_data_new(int dim, double weight, double *coord, int id){
+  /* keep every allocation aligned for doubles and pointers */
+  size = (size + sizeof(double) - 1)/sizeof(double)*sizeof(double);
+  b = arena->current;
+  while (b && b->used + size > b->size){
+    b = b->next;
+    if (b) b->used = 0;
+  }
+  if (!b){
+    b = MALLOC(sizeof(struct arena_block_struct));
+    b->size = MAX(size, ARENA_BLOCK_SIZE);
+    b->data = MALLOC(b->size);
+    b->used = 0;
+    b->next = NULL;
+    if (arena->last){
+      arena->last->next = b;
+    } else {
+      arena->first = b;
+    }
+    arena->last = b;
+  }
+  arena->current = b;
+  p = b->data + b->used;
+  b->used += size;
+  return p;
+}
+
+static SingleLinkedList qt_list_prepend(QuadTree_arena arena, SingleLinkedList l, void *data){
+  SingleLinkedList head;
+  if (!arena) return SingleLinkedList_prepend(l, data);
+  head = qt_alloc(arena, sizeof(struct SingleLinkedList_struct));
+  head->data = data;
+  head->next = l;
+  return head;
+}
+
+static node_data node_data_new(QuadTree_arena arena, int dim, double weight, double *coord, int id){
   node_data nd;
   int i;
-  nd = MALLOC(sizeof(struct node_data_struct));
+  nd = qt_alloc(arena, sizeof(struct node_data_struct));
   nd->node_weight = weight;
-  nd->coord = MALLOC(sizeof(double)*dim);
+  nd->coord = qt_alloc(arena, sizeof(double)*dim);
   nd->id = id;
   for (i = 0; i < dim; i++) nd->coord[i] = coord[i];
   nd->data = NULL;
@@ -138,34 +225,81 @@ void QuadTree_get_supernodes(QuadTree qt, double bh, double *point, int nodeid,
 }
 
 
-static double *get_or_assign_node_force(double *force, int i, SingleLinkedList l, int dim){
-
-  double *f = (double*) node_data_get_data(SingleLinkedList_get_data(l));
-
-  if (!f){
-    node_data_get_data(SingleLinkedList_get_data(l)) = &(force[i*dim]);
-    f = (double*) node_data_get_data(SingleLinkedList_get_data(l));
-  }
-  return f;
-}
 static double *get_or_alloc_force_qt(QuadTree qt, int dim){
   int i;
   double *force = (double*) qt->data;
   if (!force){
-    qt->data = MALLOC(sizeof(double)*dim);
+    qt->data = qt_alloc(qt->arena, sizeof(double)*dim);
     force = (double*) qt->data;
     for (i = 0; i < dim; i++) force[i] = 0.;
   }
   return force;
 }
 
-static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double *x, double *force, double bh, double p, double KP, double *counts){
+/* pairs of cells, pair i is cells[2*i] and cells[2*i+1] */
+typedef struct {
+  QuadTree *cells;
+  int n;
+  int size;
+} cell_pairs;
+
+static void cell_pairs_append(cell_pairs *pairs, QuadTree qt1, QuadTree qt2){
+  if (pairs->n >= pairs->size){
+    pairs->size = MAX(2*pairs->size, 16);
+    pairs->cells = REALLOC(pairs->cells, sizeof(QuadTree)*2*pairs->size);
+  }
+  pairs->cells[2*pairs->n] = qt1;
+  pairs->cells[2*pairs->n+1] = qt2;
+  pairs->n++;
+}
+
+/* inputs and outputs of a pass of QuadTree_repulsive_force_interact */
+typedef struct {
+  double *x;
+  double bh;
+  double p;
+  double KP;
+  double *force;/* force on point i, force[i*dim+j] */
+  double *cellforce;/* force on the cell numbered i, cellforce[i*dim+j]. If NULL the force is kept in the cell's data */
+  double counts[2];/* number of cell-cell and point-point interactions */
+  cell_pairs *pairs;/* if not NULL, pairs of cells that have to be split are put here when depth reaches 0 */
+} repulsive_t;
+
+static double *cell_force(repulsive_t *r, QuadTree qt, int dim){
+  if (r->cellforce) return &(r->cellforce[qt->index*dim]);
+  return get_or_alloc_force_qt(qt, dim);
+}
+
+/* add the repulsive force between two points or supernodes of weights w1
+ * and w2, a distance dist apart, to f1 and subtract it from f2. The power
+ * of the distance only depends on the pair, so it is computed once here
+ * rather than once per dimension.
+ */
+static void repulsive_force_pair(int dim, double *x1, double *x2, double w1,
+                                 double w2, double dist, double p, double KP,
+                                 double *f1, double *f2){
+  double f, denom;
+  int k;
+
+  if (p == -1){
+    denom = dist*dist;
+  } else {
+    denom = pow(dist, 1.- p);
+  }
+  for (k = 0; k < dim; k++){
+    f = w1*w2*KP*(x1[k] - x2[k])/denom;
+    f1[k] += f;
+    f2[k] -= f;
+  }
+}
+
+static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, repulsive_t *r, int depth){
   /* calculate the all to all reopulsive force and accumulate on each node of the quadtree if an interaction is possible.
-     force[i*dim+j], j=1,...,dim is the force on node i 
+     r->force[i*dim+j], j=1,...,dim is the force on node i 
    */
   SingleLinkedList l1, l2;
-  double *x1, *x2, dist, wgt1, wgt2, f, *f1, *f2, w1, w2;
-  int dim, i, j, i1, i2, k;
+  double *x1, *x2, dist, wgt1, wgt2, *f1, *f2, w1, w2;
+  int dim, i, j, i1, i2;
   QuadTree qt11, qt12; 
 
   if (!qt1 || !qt2) return;
@@ -177,24 +311,16 @@ static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double
 
   /* far enough, calculate repulsive force */
   dist = point_distance(qt1->average, qt2->average, dim); 
-  if (qt1->width + qt2->width < bh*dist){
-    counts[0]++;
+  if (qt1->width + qt2->width < r->bh*dist){
+    r->counts[0]++;
     x1 = qt1->average;
     w1 = qt1->total_weight;
-    f1 = get_or_alloc_force_qt(qt1, dim);
+    f1 = cell_force(r, qt1, dim);
     x2 = qt2->average;
     w2 = qt2->total_weight;
-    f2 = get_or_alloc_force_qt(qt2, dim);
+    f2 = cell_force(r, qt2, dim);
     assert(dist > 0);
-    for (k = 0; k < dim; k++){
-      if (p == -1){
-	f = w1*w2*KP*(x1[k] - x2[k])/(dist*dist);
-      } else {
-	f = w1*w2*KP*(x1[k] - x2[k])/pow(dist, 1.- p);
-      }
-      f1[k] += f;
-      f2[k] -= f;
-    }
+    repulsive_force_pair(dim, x1, x2, w1, w2, dist, r->p, r->KP, f1, f2);
     return;
   }
 
@@ -205,28 +331,20 @@ static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double
       x1 = node_data_get_coord(SingleLinkedList_get_data(l1));
       wgt1 = node_data_get_weight(SingleLinkedList_get_data(l1));
       i1 = node_data_get_id(SingleLinkedList_get_data(l1));
-      f1 = get_or_assign_node_force(force, i1, l1, dim);
+      f1 = &(r->force[i1*dim]);
       l2 = qt2->l;
       while (l2){
-	x2 = node_data_get_coord(SingleLinkedList_get_data(l2));
-	wgt2 = node_data_get_weight(SingleLinkedList_get_data(l2));
 	i2 = node_data_get_id(SingleLinkedList_get_data(l2));
-	f2 = get_or_assign_node_force(force, i2, l2, dim);
+	f2 = &(r->force[i2*dim]);
 	if ((qt1 == qt2 && i2 < i1) || i1 == i2) {
 	  l2 = SingleLinkedList_get_next(l2);
 	  continue;
 	}
-	counts[1]++;
-	dist = distance_cropped(x, dim, i1, i2);
-	for (k = 0; k < dim; k++){
-	  if (p == -1){
-	    f = wgt1*wgt2*KP*(x1[k] - x2[k])/(dist*dist);
-	  } else {
-	    f = wgt1*wgt2*KP*(x1[k] - x2[k])/pow(dist, 1.- p);
-	  }
-	  f1[k] += f;
-	  f2[k] -= f;
-	}
+	x2 = node_data_get_coord(SingleLinkedList_get_data(l2));
+	wgt2 = node_data_get_weight(SingleLinkedList_get_data(l2));
+	r->counts[1]++;
+	dist = distance_cropped(r->x, dim, i1, i2);
+	repulsive_force_pair(dim, x1, x2, wgt1, wgt2, dist, r->p, r->KP, f1, f2);
 	l2 = SingleLinkedList_get_next(l2);
       }
       l1 = SingleLinkedList_get_next(l1);
@@ -234,6 +352,10 @@ static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double
     return;
   }
 
+  if (r->pairs && depth == 0){
+    cell_pairs_append(r->pairs, qt1, qt2);
+    return;
+  }
 
   /* identical, split one */
   if (qt1 == qt2){
@@ -241,7 +363,7 @@ static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double
 	qt11 = qt1->qts[i];
 	for (j = i; j < 1<<dim; j++){
 	  qt12 = qt1->qts[j];
-	  QuadTree_repulsive_force_interact(qt11, qt12, x, force, bh, p, KP, counts);
+	  QuadTree_repulsive_force_interact(qt11, qt12, r, depth - 1);
 	}
       }
   } else {
@@ -249,22 +371,22 @@ static void QuadTree_repulsive_force_interact(QuadTree qt1, QuadTree qt2, double
     if (qt1->width > qt2->width && !l1){
       for (i = 0; i < 1<<dim; i++){
 	qt11 = qt1->qts[i];
-	QuadTree_repulsive_force_interact(qt11, qt2, x, force, bh, p, KP, counts);
+	QuadTree_repulsive_force_interact(qt11, qt2, r, depth - 1);
       }
     } else if (qt2->width > qt1->width && !l2){
       for (i = 0; i < 1<<dim; i++){
 	qt11 = qt2->qts[i];
-	QuadTree_repulsive_force_interact(qt11, qt1, x, force, bh, p, KP, counts);
+	QuadTree_repulsive_force_interact(qt11, qt1, r, depth - 1);
       }
     } else if (!l1){/* pick one that is not at the last level */
       for (i = 0; i < 1<<dim; i++){
 	qt11 = qt1->qts[i];
-	QuadTree_repulsive_force_interact(qt11, qt2, x, force, bh, p, KP, counts);
+	QuadTree_repulsive_force_interact(qt11, qt2, r, depth - 1);
       }
     } else if (!l2){
       for (i = 0; i < 1<<dim; i++){
 	qt11 = qt2->qts[i];
-	QuadTree_repulsive_force_interact(qt11, qt1, x, force, bh, p, KP, counts);
+	QuadTree_repulsive_force_interact(qt11, qt1, r, depth - 1);
       }
     } else {
       assert(0); /* can be both at the leaf level since that should be catched at the beginning of this func. */
@@ -289,7 +411,7 @@ static void QuadTree_repulsive_force_accumulate(QuadTree qt, double *force, doub
   if (l){
     while (l){
       i = node_data_get_id(SingleLinkedList_get_data(l));
-      f2 = get_or_assign_node_force(force, i, l, dim);
+      f2 = &(force[i*dim]);
       wgt2 = node_data_get_weight(SingleLinkedList_get_data(l));
       wgt2 = wgt2/wgt;
       for (k = 0; k < dim; k++) f2[k] += wgt2*f[k];
@@ -311,7 +433,125 @@ static void QuadTree_repulsive_force_accumulate(QuadTree qt, double *force, doub
 
 }
 
-void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts, int *flag){
+/* the interaction pass shared out between threads */
+typedef struct {
+  cell_pairs pairs;/* pair i is worked on by thread i % nthreads */
+  QuadTree *cells;/* the cells of the tree, by index */
+  int ncells;
+  int nforce;/* length of each force array */
+  repulsive_t *parts;/* what each thread works on */
+} repulsive_job;
+
+enum {PAIRS_PER_THREAD = 16};
+
+static int count_cells(QuadTree qt){
+  int i, n;
+  if (!qt) return 0;
+  n = 1;
+  if (qt->qts){
+    for (i = 0; i < 1<<qt->dim; i++) n += count_cells(qt->qts[i]);
+  }
+  return n;
+}
+
+static void number_cells(QuadTree qt, QuadTree *cells, int *ncells){
+  int i;
+  if (!qt) return;
+  qt->index = *ncells;
+  cells[(*ncells)++] = qt;
+  /* allocated up front, so that the threads never allocate from the arena */
+  get_or_alloc_force_qt(qt, qt->dim);
+  if (qt->qts){
+    for (i = 0; i < 1<<qt->dim; i++) number_cells(qt->qts[i], cells, ncells);
+  }
+}
+
+static void repulsive_force_part(void *arg, int t, int nthreads){
+  repulsive_job *job = arg;
+  int i;
+
+  for (i = t; i < job->pairs.n; i += nthreads){
+    QuadTree_repulsive_force_interact(job->pairs.cells[2*i], job->pairs.cells[2*i+1], &(job->parts[t]), 0);
+  }
+}
+
+/* add the forces found by threads 1, ..., nthreads - 1 to those of thread 0,
+   in that order, which keeps the result independent of the timing */
+static void repulsive_force_reduce(void *arg, int t, int nthreads){
+  repulsive_job *job = arg;
+  double *f, *f2;
+  int i, k, s, lo, hi, dim = job->cells[0]->dim;
+
+  parallel_range(job->nforce, t, nthreads, &lo, &hi);
+  for (s = 1; s < nthreads; s++){
+    f2 = job->parts[s].force;
+    for (i = lo; i < hi; i++) job->parts[0].force[i] += f2[i];
+  }
+
+  parallel_range(job->ncells, t, nthreads, &lo, &hi);
+  for (i = lo; i < hi; i++){
+    f = (double*) job->cells[i]->data;
+    for (s = 1; s < nthreads; s++){
+      f2 = &(job->parts[s].cellforce[i*dim]);
+      for (k = 0; k < dim; k++) f[k] += f2[k];
+    }
+  }
+}
+
+static void QuadTree_repulsive_force_interact_threaded(QuadTree qt, repulsive_t *r, int nthreads){
+  /* split the top of the tree on this thread until there are enough pairs
+     of cells to go round, then each thread works through its share of the
+     pairs into its own force arrays. Thread 0 uses those of r. */
+  repulsive_job job;
+  cell_pairs next = {NULL, 0, 0}, tmp;
+  int i, t, dim = qt->dim;
+
+  job.pairs = next;
+  cell_pairs_append(&job.pairs, qt, qt);
+  while (job.pairs.n > 0 && job.pairs.n < PAIRS_PER_THREAD*nthreads){
+    next.n = 0;
+    r->pairs = &next;
+    for (i = 0; i < job.pairs.n; i++){
+      QuadTree_repulsive_force_interact(job.pairs.cells[2*i], job.pairs.cells[2*i+1], r, 1);
+    }
+    tmp = job.pairs;
+    job.pairs = next;
+    next = tmp;
+  }
+  r->pairs = NULL;
+  free(next.cells);
+
+  job.cells = MALLOC(sizeof(QuadTree)*count_cells(qt));
+  job.ncells = 0;
+  number_cells(qt, job.cells, &job.ncells);
+  job.nforce = qt->n*dim;
+
+  job.parts = MALLOC(sizeof(repulsive_t)*nthreads);
+  job.parts[0] = *r;
+  for (t = 1; t < nthreads; t++){
+    job.parts[t] = *r;
+    job.parts[t].force = CALLOC(job.nforce, sizeof(double));
+    job.parts[t].cellforce = CALLOC(job.ncells*dim, sizeof(double));
+    job.parts[t].counts[0] = job.parts[t].counts[1] = 0;
+  }
+
+  parallel_run(nthreads, repulsive_force_part, &job);
+  parallel_run(nthreads, repulsive_force_reduce, &job);
+
+  r->counts[0] = job.parts[0].counts[0];
+  r->counts[1] = job.parts[0].counts[1];
+  for (t = 1; t < nthreads; t++){
+    r->counts[0] += job.parts[t].counts[0];
+    r->counts[1] += job.parts[t].counts[1];
+    free(job.parts[t].force);
+    free(job.parts[t].cellforce);
+  }
+  free(job.parts);
+  free(job.cells);
+  free(job.pairs.cells);
+}
+
+void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts, int nthreads, int *flag){
   /* get repulsice force by a more efficient algortihm: we consider two cells, if they are well separated, we
      calculate the overall repulsive force on the cell level, if not well separated, we divide one of the cell.
      If both cells are at the leaf level, we calcuaulate repulsicve force among individual nodes. Finally
@@ -327,8 +567,12 @@ void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double
      .  counts[1]: number of cell-node interaction
      .  counts[2]: number of total cells in the quadtree
      . Al normalized by dividing by number of nodes
+     nthreads: number of threads for the cell interactions. With more than one, the forces are
+     summed in a different order, so they may differ from the single threaded ones in the last
+     bits, but they only depend on nthreads.
   */
   int n = qt->n, dim = qt->dim, i;
+  repulsive_t r = {x, bh, p, KP, force, NULL, {0, 0}, NULL};
 
   for (i = 0; i < 4; i++) counts[i] = 0;
 
@@ -336,12 +580,20 @@ void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double
 
   for (i = 0; i < dim*n; i++) force[i] = 0;
 
-  QuadTree_repulsive_force_interact(qt, qt, x, force, bh, p, KP, counts);
+  if (nthreads > 1){
+    QuadTree_repulsive_force_interact_threaded(qt, &r, nthreads);
+  } else {
+    QuadTree_repulsive_force_interact(qt, qt, &r, 0);
+  }
+  counts[0] = r.counts[0];
+  counts[1] = r.counts[1];
   QuadTree_repulsive_force_accumulate(qt, force, counts);
   for (i = 0; i < 4; i++) counts[i] /= n;
 
 }
-QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coord, double *weight){
+static QuadTree quadtree_new(QuadTree_arena arena, int dim, double *center, double width, int max_level);
+
+static QuadTree quadtree_new_from_point_list(QuadTree_arena arena, int dim, int n, int max_level, double *coord, double *weight){
   /* form a new QuadTree data structure from a list of coordinates of n points
      coord: of length n*dim, point i sits at [i*dim, i*dim+dim - 1]
      weight: node weight of lentgth n. If NULL, unit weight assumed.
@@ -377,7 +629,7 @@ QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coo
   }
   if (width == 0) width = 0.00001;/* if we only have one point, width = 0! */
   width *= 0.52;
-  qt = QuadTree_new(dim, center, width, max_level);
+  qt = quadtree_new(arena, dim, center, width, max_level);
 
   if (weight){
     for (i = 0; i < n; i++){
@@ -396,13 +648,22 @@ QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coo
   return qt;
 }
 
-QuadTree QuadTree_new(int dim, double *center, double width, int max_level){
+QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coord, double *weight){
+  return quadtree_new_from_point_list(NULL, dim, n, max_level, coord, weight);
+}
+
+QuadTree QuadTree_arena_new_from_point_list(QuadTree_arena arena, int dim, int n, int max_level, double *coord, double *weight){
+  arena_reset(arena);
+  return quadtree_new_from_point_list(arena, dim, n, max_level, coord, weight);
+}
+
+static QuadTree quadtree_new(QuadTree_arena arena, int dim, double *center, double width, int max_level){
   QuadTree q;
   int i;
-  q = MALLOC(sizeof(struct QuadTree_struct));
+  q = qt_alloc(arena, sizeof(struct QuadTree_struct));
   q->dim = dim;
   q->n = 0;
-  q->center = MALLOC(sizeof(double)*dim);
+  q->center = qt_alloc(arena, sizeof(double)*dim);
   for (i = 0; i < dim; i++) q->center[i] = center[i];
   assert(width > 0);
   q->width = width;
@@ -412,12 +673,18 @@ QuadTree QuadTree_new(int dim, double *center, double width, int max_level){
   q->l = NULL;
   q->max_level = max_level;
   q->data = NULL;
+  q->arena = arena;
+  q->index = 0;
   return q;
 }
 
+QuadTree QuadTree_new(int dim, double *center, double width, int max_level){
+  return quadtree_new(NULL, dim, center, width, max_level);
+}
+
 void QuadTree_delete(QuadTree q){
   int i, dim;
-  if (!q) return;
+  if (!q || q->arena) return;
   dim = q->dim;
   free(q->center);
   free(q->average);
@@ -449,14 +716,14 @@ static int QuadTree_get_quadrant(int dim, double *center, double *coord){
   return d;
 }
 
-QuadTree QuadTree_new_in_quadrant(int dim, double *center, double width, int max_level, int i){
+static QuadTree quadtree_new_in_quadrant(QuadTree_arena arena, int dim, double *center, double width, int max_level, int i){
   /* a new quadtree in quadrant i of the original cell. The original cell is centered at 'center".
      The new cell have width "width".
    */
   QuadTree qt;
   int k;
 
-  qt = QuadTree_new(dim, center, width, max_level);
+  qt = quadtree_new(arena, dim, center, width, max_level);
   center = qt->center;/* right now this has the center for the parent */
   for (k = 0; k < dim; k++){/* decompose child id into binary, if {1,0}, say, then
 				     add {width/2, -width/2} to the parents' center
@@ -471,6 +738,11 @@ QuadTree QuadTree_new_in_quadrant(int dim, double *center, double width, int max
   return qt;
 
 }
+
+QuadTree QuadTree_new_in_quadrant(int dim, double *center, double width, int max_level, int i){
+  return quadtree_new_in_quadrant(NULL, dim, center, width, max_level, i);
+}
+
 static QuadTree QuadTree_add_internal(QuadTree q, double *coord, double weight, int id, int level){
   int i, dim = q->dim, ii;
   node_data nd = NULL;
@@ -493,24 +765,24 @@ static QuadTree QuadTree_add_internal(QuadTree q, double *coord, double weight,
     /* if this node is empty right now */
     q->n = 1;
     q->total_weight = weight;
-    q->average = MALLOC(sizeof(double)*dim);
+    q->average = qt_alloc(q->arena, sizeof(double)*dim);
     for (i = 0; i < q->dim; i++) q->average[i] = coord[i];
-    nd = node_data_new(q->dim, weight, coord, id);
+    nd = node_data_new(q->arena, q->dim, weight, coord, id);
     assert(!(q->l));
-    q->l = SingleLinkedList_new(nd);
+    q->l = qt_list_prepend(q->arena, NULL, nd);
   } else if (level < max_level){
     /* otherwise open up into 2^dim quadtrees unless the level is too high */
     q->total_weight += weight;
     for (i = 0; i < q->dim; i++) q->average[i] = ((q->average[i])*q->n + coord[i])/(q->n + 1);
     if (!q->qts){
-      q->qts = MALLOC(sizeof(QuadTree)*(1<<dim));
+      q->qts = qt_alloc(q->arena, sizeof(QuadTree)*(1<<dim));
       for (i = 0; i < 1<<dim; i++) q->qts[i] = NULL;
     }/* done adding new quadtree, now add points to them */
     
     /* insert the old node (if exist) and the current node into the appropriate child quadtree */
     ii = QuadTree_get_quadrant(dim, q->center, coord);
     assert(ii < 1<<dim && ii >= 0);
-    if (q->qts[ii] == NULL) q->qts[ii] = QuadTree_new_in_quadrant(q->dim, q->center, (q->width)/2, max_level, ii);
+    if (q->qts[ii] == NULL) q->qts[ii] = quadtree_new_in_quadrant(q->arena, q->dim, q->center, (q->width)/2, max_level, ii);
     
     q->qts[ii] = QuadTree_add_internal(q->qts[ii], coord, weight, id, level + 1);
     assert(q->qts[ii]);
@@ -523,13 +795,13 @@ static QuadTree QuadTree_add_internal(QuadTree q, double *coord, double weight,
       ii = QuadTree_get_quadrant(dim, q->center, coord);
       assert(ii < 1<<dim && ii >= 0);
 
-      if (q->qts[ii] == NULL) q->qts[ii] = QuadTree_new_in_quadrant(q->dim, q->center, (q->width)/2, max_level, ii);
+      if (q->qts[ii] == NULL) q->qts[ii] = quadtree_new_in_quadrant(q->arena, q->dim, q->center, (q->width)/2, max_level, ii);
 
       q->qts[ii] = QuadTree_add_internal(q->qts[ii], coord, weight, idd, level + 1);
       assert(q->qts[ii]);
       
       /* delete the old node data on parent */
-      SingleLinkedList_delete(q->l, node_data_delete);
+      if (!q->arena) SingleLinkedList_delete(q->l, node_data_delete);
       q->l = NULL;
     }
     
@@ -540,9 +812,9 @@ static QuadTree QuadTree_add_internal(QuadTree q, double *coord, double weight,
     (q->n)++;
     q->total_weight += weight;
     for (i = 0; i < q->dim; i++) q->average[i] = ((q->average[i])*q->n + coord[i])/(q->n + 1);
-    nd = node_data_new(q->dim, weight, coord, id);
+    nd = node_data_new(q->arena, q->dim, weight, coord, id);
     assert(q->l);
-    q->l = SingleLinkedList_prepend(q->l, nd);
+    q->l = qt_list_prepend(q->arena, q->l, nd);
   }
   return q;
 }
@@ -15,6 +15,9 @@
 
 typedef struct QuadTree_struct *QuadTree;
 
+/* memory pool that can hold a whole quadtree, see QuadTree_arena_new_from_point_list */
+typedef struct QuadTree_arena_struct *QuadTree_arena;
+
 struct QuadTree_struct {
   /* a data structure containing coordinates of n items, their average is in "average".
      The current level is a square or cube of width "width", which is subdivided into 
@@ -31,6 +34,8 @@ struct QuadTree_struct {
   SingleLinkedList l;
   int max_level;
   void *data;
+  QuadTree_arena arena;/* if not NULL, the storage of this cell is owned by arena */
+  int index;/* position of this cell in a preorder numbering, set by a threaded QuadTree_get_repulsive_force */
 };
 
 
@@ -44,12 +49,22 @@ void QuadTree_print(FILE *fp, QuadTree q);
 
 QuadTree QuadTree_new_from_point_list(int dim, int n, int max_level, double *coord, double *weight);
 
+QuadTree_arena QuadTree_arena_new(void);
+
+void QuadTree_arena_delete(QuadTree_arena arena);
+
+/* as QuadTree_new_from_point_list, but all cells and point data are carved out of arena,
+   whose blocks are kept between calls. Each call reuses the arena, invalidating the tree
+   returned by the previous call. QuadTree_delete does nothing on such a tree; its storage
+   is released by QuadTree_arena_delete. */
+QuadTree QuadTree_arena_new_from_point_list(QuadTree_arena arena, int dim, int n, int max_level, double *coord, double *weight);
+
 double point_distance(double *p1, double *p2, int dim);
 
 void QuadTree_get_supernodes(QuadTree qt, double bh, double *point, int nodeid, int *nsuper, 
 			     int *nsupermax, double **center, double **supernode_wgts, double **distances, double *counts, int *flag);
 
-void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts, int *flag);
+void QuadTree_get_repulsive_force(QuadTree qt, double *force, double *x, double bh, double p, double KP, double *counts, int nthreads, int *flag);
 
 /* find the nearest point and put in ymin, index in imin and distance in min */
 void QuadTree_get_nearest(QuadTree qt, double *x, double *ymin, int *imin, double *min, int *flag);
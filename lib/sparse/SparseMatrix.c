@@ -1015,9 +1015,12 @@ static void SparseMatrix_multiply_dense1(SparseMatrix A, double *v, double **res
 
   if (!u) u = MALLOC(sizeof(double)*((size_t) m)*((size_t) dim));
   for (i = 0; i < m; i++){
-    for (k = 0; k < dim; k++) u[i*dim+k] = 0.;
+    double *ui = &u[(size_t)i * (size_t)dim];
+    for (k = 0; k < dim; k++) ui[k] = 0.;
     for (j = ia[i]; j < ia[i+1]; j++){
-      for (k = 0; k < dim; k++) u[i*dim+k] += a[j]*v[ja[j]*dim+k];
+      const double aj = a[j];
+      const double *vj = &v[(size_t)ja[j] * (size_t)dim];
+      for (k = 0; k < dim; k++) ui[k] += aj*vj[k];
     }
   }
 
@@ -1052,17 +1055,19 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res, int t
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(double)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
+	  double sum = 0.;
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += a[j]*v[ja[j]];
+	    sum += a[j]*v[ja[j]];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(double)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
 	for (i = 0; i < m; i++){
+	  const double vi = v[i];
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += a[j]*v[i];
+	    u[ja[j]] += a[j]*vi;
 	  }
 	}
       }
@@ -1071,10 +1076,11 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res, int t
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(double)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
+	  double sum = 0.;
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += a[j];
+	    sum += a[j];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(double)*((size_t)n));
@@ -1093,17 +1099,19 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res, int t
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(double)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
+	  double sum = 0.;
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += ai[j]*v[ja[j]];
+	    sum += ai[j]*v[ja[j]];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(double)*((size_t)n));
 	for (i = 0; i < n; i++) u[i] = 0.;
 	for (i = 0; i < m; i++){
+	  const double vi = v[i];
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[ja[j]] += ai[j]*v[i];
+	    u[ja[j]] += ai[j]*vi;
 	  }
 	}
       }
@@ -1112,10 +1120,11 @@ void SparseMatrix_multiply_vector(SparseMatrix A, double *v, double **res, int t
       if (!transposed){
 	if (!u) u = MALLOC(sizeof(double)*((size_t)m));
 	for (i = 0; i < m; i++){
-	  u[i] = 0.;
+	  double sum = 0.;
 	  for (j = ia[i]; j < ia[i+1]; j++){
-	    u[i] += ai[j];
+	    sum += ai[j];
 	  }
+	  u[i] = sum;
 	}
       } else {
 	if (!u) u = MALLOC(sizeof(double)*((size_t)n));
@@ -19,26 +19,69 @@
 #define DEF_RANKSEP 1.00
 #define UNSET 10.00
 
+/* the edges incident on each node of the graph being laid out, in the
+ * order agfstedge and agnxtedge visit them
+ */
+typedef struct {
+    Agcsr_t *csr;
+    int *start;			/* nnodes + 1 offsets into nbr and edge */
+    int *nbr;			/* index of the other end of each edge */
+    Agedge_t **edge;		/* each incident edge */
+} adjacency_t;
+
+static void mkAdjacency(Agraph_t * g, adjacency_t * adj)
+{
+    Agcsr_t *csr = agcsr(g, NULL, 0);
+    int k = 0;
+
+    adj->csr = csr;
+    adj->start = N_NEW(csr->nnodes + 1, int);
+    adj->nbr = N_NEW(2 * csr->nedges + 1, int);
+    adj->edge = N_NEW(2 * csr->nedges + 1, Agedge_t *);
+    for (int i = 0; i < csr->nnodes; i++) {
+	adj->start[i] = k;
+	for (int x = csr->out[i]; x < csr->out[i + 1]; x++) {
+	    adj->nbr[k] = csr->head[x];
+	    adj->edge[k++] = csr->edges[x];
+	}
+	for (int x = csr->in[i]; x < csr->in[i + 1]; x++) {
+	    int e = csr->in_edge[x];
+	    if (csr->tail[e] == i)
+		continue;	/* loops are only seen as out edges */
+	    adj->nbr[k] = csr->tail[e];
+	    adj->edge[k++] = csr->edges[e];
+	}
+    }
+    adj->start[csr->nnodes] = k;
+}
+
+static void freeAdjacency(adjacency_t * adj)
+{
+    agcsrfree(adj->csr);
+    free(adj->start);
+    free(adj->nbr);
+    free(adj->edge);
+}
+
 /* dfs to set distance from a particular leaf.
  * Note that termination is implicit in the test
  * for reduced number of steps. Proof?
  */
-static void setNStepsToLeaf(Agraph_t * g, Agnode_t * n, Agnode_t * prev)
+static void setNStepsToLeaf(const adjacency_t * adj, int n, int prev)
 {
-    Agnode_t *next;
+    Agnode_t **nodes = adj->csr->nodes;
 
-    uint64_t nsteps = SLEAF(n) + 1;
+    uint64_t nsteps = SLEAF(nodes[n]) + 1;
 
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
+    for (int k = adj->start[n]; k < adj->start[n + 1]; k++) {
+	int next = adj->nbr[k];
 
 	if (prev == next)
 	    continue;
 
-	if (nsteps < SLEAF(next)) {	/* handles loops and multiedges */
-	    SLEAF(next) = nsteps;
-	    setNStepsToLeaf(g, next, n);
+	if (nsteps < SLEAF(nodes[next])) {	/* handles loops and multiedges */
+	    SLEAF(nodes[next]) = nsteps;
+	    setNStepsToLeaf(adj, next, n);
 	}
     }
 }
@@ -46,17 +89,15 @@ static void setNStepsToLeaf(Agraph_t * g, Agnode_t * n, Agnode_t * prev)
 /* isLeaf:
  * Return true if n is a leaf node.
  */
-static bool isLeaf(Agraph_t * g, Agnode_t * n)
+static bool isLeaf(const adjacency_t * adj, int n)
 {
-    Agnode_t *neighp = 0;
-    Agnode_t *np;
+    int neighp = -1;
 
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((np = agtail(ep)) == n)
-	    np = aghead(ep);
+    for (int k = adj->start[n]; k < adj->start[n + 1]; k++) {
+	int np = adj->nbr[k];
 	if (n == np)
 	    continue;		/* loop */
-	if (neighp) {
+	if (neighp >= 0) {
 	    if (neighp != np)
 		return false;	/* two different neighbors */
 	} else
@@ -65,15 +106,16 @@ static bool isLeaf(Agraph_t * g, Agnode_t * n)
     return true;
 }
 
-static void initLayout(Agraph_t * g)
+static void initLayout(const adjacency_t * adj)
 {
-    int nnodes = agnnodes(g);
+    int nnodes = adj->csr->nnodes;
     int INF = nnodes * nnodes;
 
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
+    for (int i = 0; i < nnodes; i++) {
+	Agnode_t *n = adj->csr->nodes[i];
 	SCENTER(n) = INF;
 	THETA(n) = UNSET;	/* marks theta as unset, since 0 <= theta <= 2PI */
-	if (isLeaf(g, n))
+	if (isLeaf(adj, i))
 	    SLEAF(n) = 0;
 	else
 	    SLEAF(n) = INF;
@@ -86,25 +128,27 @@ static void initLayout(Agraph_t * g)
  * minimum value of nStepsToLeaf for each node.  Using
  * that information, assign some node to be the centerNode.
 */
-static Agnode_t *findCenterNode(Agraph_t * g)
+static Agnode_t *findCenterNode(const adjacency_t * adj)
 {
+    Agnode_t **nodes = adj->csr->nodes;
+    int nnodes = adj->csr->nnodes;
     Agnode_t *center = NULL;
     uint64_t maxNStepsToLeaf = 0;
 
     /* With just 1 or 2 nodes, return anything. */
-    if (agnnodes(g) <= 2)
-	return agfstnode(g);
+    if (nnodes <= 2)
+	return nodes[0];
 
     /* dfs from each leaf node */
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (SLEAF(n) == 0)
-	    setNStepsToLeaf(g, n, 0);
+    for (int i = 0; i < nnodes; i++) {
+	if (SLEAF(nodes[i]) == 0)
+	    setNStepsToLeaf(adj, i, -1);
     }
 
-    for (Agnode_t *n = agfstnode(g); n; n = agnxtnode(g, n)) {
-	if (SLEAF(n) > maxNStepsToLeaf) {
-	    maxNStepsToLeaf = SLEAF(n);
-	    center = n;
+    for (int i = 0; i < nnodes; i++) {
+	if (SLEAF(nodes[i]) > maxNStepsToLeaf) {
+	    maxNStepsToLeaf = SLEAF(nodes[i]);
+	    center = nodes[i];
 	}
     }
     return center;
@@ -145,7 +189,8 @@ static void* pull(queue* q)
 }
 
 /* bfs to create tree structure */
-static void setNStepsToCenter(Agraph_t * g, Agnode_t * n)
+static void setNStepsToCenter(Agraph_t * g, const adjacency_t * adj,
+			      Agnode_t * n)
 {
     Agnode_t *next;
     Agsym_t* wt = agfindedgeattr(g,"weight");
@@ -155,10 +200,10 @@ static void setNStepsToCenter(Agraph_t * g, Agnode_t * n)
     push(q,n);
     while ((n = pull(q))) {
 	uint64_t nsteps = SCENTER(n) + 1;
-	for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	    if (wt && streq(ag_xget(ep,wt),"0")) continue;
-	    if ((next = agtail(ep)) == n)
-		next = aghead(ep);
+	int i = agcsrindex(adj->csr, n);
+	for (int k = adj->start[i]; k < adj->start[i + 1]; k++) {
+	    if (wt && streq(ag_xget(adj->edge[k],wt),"0")) continue;
+	    next = adj->csr->nodes[adj->nbr[k]];
 	    if (nsteps < SCENTER(next)) {
 		SCENTER(next) = nsteps;
 		SPARENT(next) = n;
@@ -174,14 +219,15 @@ static void setNStepsToCenter(Agraph_t * g, Agnode_t * n)
  * nStepsToCenter and parent node for each node.
  * Return UINT64_MAX if some node was not reached.
  */
-static uint64_t setParentNodes(Agraph_t * sg, Agnode_t * center)
+static uint64_t setParentNodes(Agraph_t * sg, const adjacency_t * adj,
+			       Agnode_t * center)
 {
     uint64_t maxn = 0;
     uint64_t unset = SCENTER(center);
 
     SCENTER(center) = 0;
     SPARENT(center) = 0;
-    setNStepsToCenter(sg, center);
+    setNStepsToCenter(sg, adj, center);
 
     /* find the maximum number of steps from the center */
     for (Agnode_t *n = agfstnode(sg); n; n = agnxtnode(sg, n)) {
@@ -211,14 +257,14 @@ static void setSubtreeSize(Agraph_t * g)
     }
 }
 
-static void setChildSubtreeSpans(Agraph_t * g, Agnode_t * n)
+static void setChildSubtreeSpans(const adjacency_t * adj, Agnode_t * n)
 {
     Agnode_t *next;
+    int i = agcsrindex(adj->csr, n);
 
     double ratio = SPAN(n) / STSIZE(n);
-    for (Agedge_t *ep = agfstedge(g, n); ep; ep = agnxtedge(g, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
+    for (int k = adj->start[i]; k < adj->start[i + 1]; k++) {
+	next = adj->csr->nodes[adj->nbr[k]];
 	if (SPARENT(next) != n)
 	    continue;		/* handles loops */
 
@@ -227,31 +273,31 @@ static void setChildSubtreeSpans(Agraph_t * g, Agnode_t * n)
 	SPAN(next) = ratio * STSIZE(next);
 
 	if (NCHILD(next) > 0) {
-	    setChildSubtreeSpans(g, next);
+	    setChildSubtreeSpans(adj, next);
 	}
     }
 }
 
-static void setSubtreeSpans(Agraph_t * sg, Agnode_t * center)
+static void setSubtreeSpans(const adjacency_t * adj, Agnode_t * center)
 {
     SPAN(center) = 2 * M_PI;
-    setChildSubtreeSpans(sg, center);
+    setChildSubtreeSpans(adj, center);
 }
 
  /* Set the node positions for the 2nd and later rings. */
-static void setChildPositions(Agraph_t * sg, Agnode_t * n)
+static void setChildPositions(const adjacency_t * adj, Agnode_t * n)
 {
     Agnode_t *next;
     double theta;		/* theta is the lower boundary radius of the fan */
+    int i = agcsrindex(adj->csr, n);
 
     if (SPARENT(n) == 0)	/* center */
 	theta = 0;
     else
 	theta = THETA(n) - SPAN(n) / 2;
 
-    for (Agedge_t *ep = agfstedge(sg, n); ep; ep = agnxtedge(sg, ep, n)) {
-	if ((next = agtail(ep)) == n)
-	    next = aghead(ep);
+    for (int k = adj->start[i]; k < adj->start[i + 1]; k++) {
+	next = adj->csr->nodes[adj->nbr[k]];
 	if (SPARENT(next) != n)
 	    continue;		/* handles loops */
 	if (THETA(next) != UNSET)
@@ -261,14 +307,14 @@ static void setChildPositions(Agraph_t * sg, Agnode_t * n)
 	theta += SPAN(next);
 
 	if (NCHILD(next) > 0)
-	    setChildPositions(sg, next);
+	    setChildPositions(adj, next);
     }
 }
 
-static void setPositions(Agraph_t * sg, Agnode_t * center)
+static void setPositions(const adjacency_t * adj, Agnode_t * center)
 {
     THETA(center) = 0;
-    setChildPositions(sg, center);
+    setChildPositions(adj, center);
 }
 
 /* getRankseps:
@@ -343,25 +389,31 @@ Agnode_t* circleLayout(Agraph_t * sg, Agnode_t * center)
 	return center;
     }
 
-    initLayout(sg);
+    adjacency_t adj;
+    mkAdjacency(sg, &adj);
+
+    initLayout(&adj);
 
     if (!center)
-	center = findCenterNode(sg);
+	center = findCenterNode(&adj);
 
-    uint64_t maxNStepsToCenter = setParentNodes(sg,center);
+    uint64_t maxNStepsToCenter = setParentNodes(sg, &adj, center);
     if (Verbose)
 	fprintf(stderr, "root = %s max steps to root = %" PRIu64 "\n",
 	        agnameof(center), maxNStepsToCenter);
     if (maxNStepsToCenter == UINT64_MAX) {
 	agerr(AGERR, "twopi: use of weight=0 creates disconnected component.\n");
+	freeAdjacency(&adj);
 	return center;
     }
 
     setSubtreeSize(sg);
 
-    setSubtreeSpans(sg, center);
+    setSubtreeSpans(&adj, center);
+
+    setPositions(&adj, center);
 
-    setPositions(sg, center);
+    freeAdjacency(&adj);
 
     setAbsolutePos(sg, maxNStepsToCenter);
     return center;
@@ -67,6 +67,40 @@ static Agnode_t* findRootNode (Agraph_t* sg, Agsym_t* rootattr)
 
 }
 
+/* state shared by the components of a graph, for twopiComponent */
+typedef struct {
+    Agnode_t *ctr;		/* root given by the user or chosen first */
+    Agsym_t *rootattr;
+    int setRoot;
+    int setLocalRoot;
+} twopi_args;
+
+/* twopiComponent:
+ * Lay out one connected component of a disconnected graph. With
+ * setRoot, the center of the first component becomes the root of g.
+ */
+static int twopiComponent(Agraph_t * sg, int i, void *state)
+{
+    twopi_args *args = state;
+    Agnode_t *ctr = args->ctr;
+    Agnode_t *lctr;
+    Agnode_t *c;
+
+    (void)i;
+    if (ctr && agcontains(sg, ctr))
+	lctr = ctr;
+    else if (!args->rootattr || !(lctr = findRootNode(sg, args->rootattr)))
+	lctr = 0;
+    nodeInduce(sg);
+    c = circleLayout(sg, lctr);
+    if (args->setRoot && !ctr)
+	args->ctr = c;
+    if (args->setLocalRoot && (!lctr || (lctr == args->ctr)))
+	agxset (c, args->rootattr, "1");
+    adjustNodes(sg);
+    return 0;
+}
+
 /* twopi_layout:
  */
 void twopi_layout(Agraph_t * g)
@@ -107,7 +141,6 @@ void twopi_layout(Agraph_t * g)
 
     if (agnnodes(g)) {
 	Agraph_t **ccs;
-	Agraph_t *sg;
 	Agnode_t *c = NULL;
 	Agnode_t *n;
 	int ncc;
@@ -132,23 +165,12 @@ void twopi_layout(Agraph_t * g)
 	    spline_edges(g);
 	} else {
 	    pack_info pinfo;
+	    twopi_args args = {ctr, rootattr, setRoot, setLocalRoot};
 	    getPackInfo (g, l_node, CL_OFFSET, &pinfo);
 	    pinfo.doSplines = 0;
 
-	    for (i = 0; i < ncc; i++) {
-		sg = ccs[i];
-		if (ctr && agcontains(sg, ctr))
-		    lctr = ctr;
-		else if (!rootattr || !(lctr = findRootNode(sg, rootattr)))
-		    lctr = 0;
-		nodeInduce(sg);
-		c = circleLayout(sg, lctr);
-	        if (setRoot && !ctr)
-		    ctr = c;
-		if (setLocalRoot && (!lctr || (lctr == ctr)))
-		    agxset (c, rootattr, "1"); 
-		adjustNodes(sg);
-	    }
+	    layoutGraphs(ncc, ccs, twopiComponent, &args);
+	    ctr = args.ctr;
 	    n = agfstnode(g);
 	    free(ND_alg(n));
 	    ND_alg(n) = NULL;
@@ -328,8 +328,10 @@ static void lasi_textspan(GVJ_t * job, pointf p, textspan_t * span)
     if (job->obj->pencolor.u.HSVA[3] < .5)
 	return;  /* skip transparent text */
 
-    if (span->layout) {
-	pango_font = pango_layout_get_font_description((PangoLayout*)(span->layout));
+    textspan_t tmp = *span;
+    bool own = textspan_layout(job, &tmp);
+    if (tmp.layout) {
+	pango_font = pango_layout_get_font_description((PangoLayout*)(tmp.layout));
 	font = pango_font_description_get_family(pango_font);
 	switch (pango_font_description_get_stretch(pango_font)) {
 	    case PANGO_STRETCH_ULTRA_CONDENSED: stretch = ULTRACONDENSED; break;
@@ -381,6 +383,8 @@ static void lasi_textspan(GVJ_t * job, pointf p, textspan_t * span)
     ps_set_color(job, &(job->obj->pencolor));
     Context *ctxt = reinterpret_cast<Context*>(job->context);
     ctxt->doc.osBody() << setFont(font, style, weight, variant, stretch) << setFontSize(span->font->size) << "\n";
+    if (own)
+	tmp.free_layout(tmp.layout);
     switch (span->just) {
     case 'r':
         p.x -= span->size.x;
@@ -257,6 +257,8 @@ static void cairogen_textspan(GVJ_t * job, pointf p, textspan_t * span)
     obj_state_t *obj = job->obj;
     cairo_t *cr = job->context;
     pointf A[2];
+    textspan_t tmp = *span;
+    bool own = textspan_layout(job, &tmp);
 
     cairo_set_dash (cr, dashed, 0, 0.0);  /* clear any dashing */
     cairogen_set_color(cr, &obj->pencolor);
@@ -278,8 +280,11 @@ static void cairogen_textspan(GVJ_t * job, pointf p, textspan_t * span)
     cairo_move_to (cr, p.x, -p.y);
     cairo_save(cr);
     cairo_scale(cr, POINTS_PER_INCH / FONT_DPI, POINTS_PER_INCH / FONT_DPI);
-    pango_cairo_show_layout(cr, (PangoLayout*)span->layout);
+    if (tmp.layout)
+	pango_cairo_show_layout(cr, (PangoLayout*)tmp.layout);
     cairo_restore(cr);
+    if (own)
+	tmp.free_layout(tmp.layout);
 
     if (span->font && (span->font->flags & HTML_OL)) {
 	A[0].x = p.x;
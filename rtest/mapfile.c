@@ -0,0 +1,55 @@
+/* test case for agmapfile() on streams that are misused
+ * (see test_misc.py:test_mapped_stale())
+ */
+
+#include <assert.h>
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef NDEBUG
+  #error "this code is not intended to be compiled with assertions disabled"
+#endif
+
+static void write_file(const char *path, const char *content) {
+  FILE *f = fopen(path, "w");
+  assert(f);
+  fputs(content, f);
+  fclose(f);
+}
+
+int main(int argc, char **argv) {
+
+  assert(argc == 3);
+  write_file(argv[1], "digraph first { a -> b }\n");
+  write_file(argv[2], "digraph second { c -> d -> e }\n");
+
+  /* a mapped stream closed without agunmapfile, whose FILE* may be reused by
+   * the next fopen, should not leak its contents into that stream
+   */
+  FILE *f = fopen(argv[1], "r");
+  assert(f);
+  agmapfile(f);
+  fclose(f);
+
+  f = fopen(argv[2], "r");
+  assert(f);
+  Agraph_t *g = agread(f, NULL);
+  assert(g);
+  assert(strcmp(agnameof(g), "second") == 0);
+  assert(agnnodes(g) == 3);
+  agclose(g);
+  agunmapfile(f);
+  fclose(f);
+
+  /* a stream positioned past the end of its file has nothing to read */
+  f = fopen(argv[1], "r");
+  assert(f);
+  assert(fseek(f, 4096, SEEK_SET) == 0);
+  agmapfile(f);
+  assert(agread(f, NULL) == NULL);
+  agunmapfile(f);
+  fclose(f);
+
+  return 0;
+}
@@ -0,0 +1,43 @@
+/* reads a graph file over and over with agread() and prints the time each
+ * read took (see parse_benchmark.py)
+ */
+
+#include <graphviz/cgraph.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+int main(int argc, char **argv) {
+
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s file repeat\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int repeat = atoi(argv[2]);
+  for (int i = 0; i < repeat; ++i) {
+    FILE *f = fopen(argv[1], "r");
+    if (f == NULL) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+    }
+
+    clock_t start = clock();
+    Agraph_t *g;
+    int graphs = 0;
+    while ((g = agread(f, NULL)) != NULL) {
+      agclose(g);
+      ++graphs;
+    }
+    clock_t end = clock();
+    fclose(f);
+
+    if (graphs == 0) {
+      fprintf(stderr, "no graph read from %s\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+    printf("%f\n", (double)(end - start) / CLOCKS_PER_SEC);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+"""
+benchmark for the DOT reader
+
+Times agread() on a generated graph, or on a graph file of your own, so that
+changes to the scanner, grammar or attribute binding can be compared. Only
+reading is timed; the graph is closed again without being laid out.
+
+The reader is compiled against libcgraph, found through the CFLAGS and LDFLAGS
+environment variables in the same way as the C programs in the test suite. To
+compare two builds, run the script once with each of them on the same file,
+e.g. one written out with --output.
+"""
+
+import argparse
+import os
+from pathlib import Path
+import subprocess
+import sys
+import tempfile
+from typing import List
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import compile_c #pylint: disable=C0413
+
+def generate(out, nodes: int, attrs: int):
+  """
+  write a graph like the ones generated by other tools: each node and edge
+  statement carries the same attributes in the same order
+  """
+  out.write("digraph {\n")
+  for i in range(nodes):
+    a = "".join(f' a{j}="{i % 97}"' for j in range(attrs))
+    out.write(f'  n{i} [label="node {i}"{a}];\n')
+  for i in range(nodes):
+    for j in (i + 1, i * 7 + 3):
+      if j < nodes:
+        a = "".join(f' e{k}="{j % 89}"' for k in range(attrs))
+        out.write(f'  n{i} -> n{j} [weight={j % 5 + 1}{a}];\n')
+  out.write("}\n")
+
+def main(args: List[str]) -> int: # pylint: disable=missing-function-docstring
+
+  # parse command line arguments
+  parser = argparse.ArgumentParser(description="Graphviz DOT reader benchmark")
+  parser.add_argument("--attrs", type=int, default=4,
+                      help="attributes per generated node or edge statement")
+  parser.add_argument("--input", "-i", type=Path,
+                      help="graph file to read instead of a generated one")
+  parser.add_argument("--nodes", type=int, default=200000,
+                      help="nodes in the generated graph")
+  parser.add_argument("--output", "-o", type=argparse.FileType("wt"),
+                      help="also write the generated graph to this file")
+  parser.add_argument("--repeat", type=int, default=5,
+                      help="number of times to read the graph")
+  options = parser.parse_args(args[1:])
+
+  src = Path(__file__).parent.resolve() / "parse_benchmark.c"
+
+  with tempfile.TemporaryDirectory() as tmp:
+
+    # stage the input
+    if options.input is not None:
+      graph = options.input
+    else:
+      graph = Path(tmp) / "input.gv"
+      with open(graph, "wt") as f:
+        generate(f, options.nodes, options.attrs)
+      if options.output is not None:
+        generate(options.output, options.nodes, options.attrs)
+        options.output.close()
+
+    # build the reader and time it
+    exe = compile_c(src, ["-O2"], ["cgraph"], Path(tmp) / "parse_benchmark.exe")
+    output = subprocess.check_output([exe, graph, str(options.repeat)],
+                                     universal_newlines=True)
+    times = sorted(float(t) for t in output.split())
+    size = graph.stat().st_size / 1e6
+
+  print(f"read {size:.1f}MB {options.repeat} times: best {times[0]:.3f}s "
+        f"({size / times[0]:.1f}MB/s), median {times[len(times) // 2]:.3f}s")
+
+  return 0
+
+if __name__ == "__main__":
+  sys.exit(main(sys.argv))
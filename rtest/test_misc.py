@@ -4,6 +4,7 @@ Graphviz miscellaneous test cases
 
 import itertools
 import json
+import math
 import os
 from pathlib import Path
 import platform
@@ -13,7 +14,7 @@ import tempfile
 import pytest
 
 sys.path.append(os.path.dirname(__file__))
-from gvtest import compile_c, ROOT #pylint: disable=C0413
+from gvtest import compile_c, run_c, ROOT #pylint: disable=C0413
 
 def test_json_node_order():
   """
@@ -82,6 +83,332 @@ def test_json_edge_order():
             data["objects"][e["head"]]["name"]) for e in data["edges"]]
   assert edges == expected
 
+def test_arena_input():
+  """
+  graphs read with GV_ARENA set should lay out exactly as without it
+  """
+
+  # two graphs, so that the first is closed while the second is processed
+  input = 'digraph { a -> b -> c; subgraph cluster_x { a; d; } d -> b; }\n' \
+          'graph { a -- b -- c -- a; c [label="C"]; }\n'
+
+  expected = subprocess.check_output(["dot", "-Tdot"], input=input,
+    universal_newlines=True)
+
+  env = os.environ.copy()
+  env["GV_ARENA"] = "true"
+  output = subprocess.check_output(["dot", "-Tdot"], input=input, env=env,
+    universal_newlines=True)
+
+  assert output == expected, "arena allocation changed dot output"
+
+@pytest.mark.parametrize("tool", ["dot", "nop"])
+def test_mapped_input(tool: str):
+  """
+  reading graphs from a named file, which is memory-mapped where supported,
+  should give the same result as reading them from a pipe
+  """
+
+  # two graphs, the first larger than the scanner's buffer
+  nodes = "".join(f"n{i} -> n{i + 1} [label=\"e{i}\"];\n" for i in range(2000))
+  input = f"digraph {{\n{nodes}}}\ngraph {{ a -- b -- c -- a; }}\n"
+
+  args = [tool, "-Tdot"] if tool == "dot" else [tool]
+  expected = subprocess.check_output(args, input=input,
+    universal_newlines=True)
+
+  with tempfile.TemporaryDirectory() as tmp:
+    path = Path(tmp) / "input.gv"
+    path.write_text(input, encoding="utf-8")
+    output = subprocess.check_output(args + [str(path)],
+      universal_newlines=True)
+
+  assert output == expected, "reading from a file changed the output"
+
+def test_mapped_stale():
+  """
+  a mapping should not outlive its stream or read past the end of its file
+  """
+
+  # FIXME: Remove skip when
+  # https://gitlab.com/graphviz/graphviz/-/issues/1777 is fixed
+  if os.getenv("build_system") == "msbuild":
+    pytest.skip("Windows MSBuild release does not contain any header files (#1777)")
+
+  c_src = (Path(__file__).parent / "mapfile.c").resolve()
+  assert c_src.exists(), "missing test case"
+
+  with tempfile.TemporaryDirectory() as tmp:
+    ret, _, stderr = run_c(c_src, [Path(tmp) / "a.gv", Path(tmp) / "b.gv"],
+                           link=["cgraph"])
+  sys.stderr.write(stderr)
+  assert ret == 0
+
+def test_gvb_round_trip():
+  """
+  a laid out graph written with -Tgvb should read back as the graph -Tdot
+  writes, whether it comes from a pipe or a named file
+  """
+
+  input = (ROOT / "rtest/graphs/clust4.gv").read_text(encoding="utf-8")
+  expected = subprocess.check_output(["dot", "-Tdot"], input=input,
+    universal_newlines=True)
+
+  binary = subprocess.check_output(["dot", "-Tgvb"],
+    input=input.encode("utf-8"))
+
+  output = subprocess.check_output(["dot", "-Tcanon"], input=binary)
+  assert output.decode("utf-8") == expected, \
+    "binary round trip through a pipe changed the graph"
+
+  with tempfile.TemporaryDirectory() as tmp:
+    path = Path(tmp) / "input.gvb"
+    path.write_bytes(binary + binary)
+    output = subprocess.check_output(["dot", "-Tcanon", str(path)],
+      universal_newlines=True)
+
+  assert output[:len(expected)] == expected, \
+    "binary round trip through a file changed the graph"
+
+  # subgraphs are written in ID order, and named subgraphs take their IDs
+  # from string pool addresses, so the second graph read in one process may
+  # list its clusters in another order, as it does when reading text
+  second = output[len(expected):]
+  assert sorted(second.splitlines()) == sorted(expected.splitlines()), \
+    "binary round trip through a file changed the second graph"
+
+  # a record shorter than its header is an error, from a file or a pipe
+  for short in (binary[:3], b"\x89hello"):
+    with tempfile.TemporaryDirectory() as tmp:
+      path = Path(tmp) / "short.gvb"
+      path.write_bytes(short)
+      p = subprocess.run(["dot", "-Tcanon", str(path)],
+                         stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert p.returncode != 0 and b"truncated" in p.stderr, \
+      "a short binary file should be reported"
+
+    p = subprocess.run(["dot", "-Tcanon"], input=short,
+                       stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    assert p.returncode != 0 and b"truncated" in p.stderr, \
+      "a short binary pipe should be reported"
+
+@pytest.mark.parametrize("graph", ["clust4.gv", "clust5.gv", "b7.gv"])
+def test_xcoord_bk(graph: str):
+  """
+  Brandes-Köpf x coordinates should keep nodes on a rank apart and inside
+  their clusters
+  """
+
+  input = ROOT / "rtest/graphs" / graph
+  output = subprocess.check_output(["dot", "-Gxcoord=bk", "-Tjson", input],
+    universal_newlines=True)
+  objects = json.loads(output)["objects"]
+
+  def extent(node):
+    x = float(node["pos"].split(",")[0])
+    half = float(node["width"]) * 72 / 2
+    return x - half, x + half
+
+  nodes = [o for o in objects if "pos" in o]
+  ranks = {}
+  for n in nodes:
+    ranks.setdefault(n["pos"].split(",")[1], []).append(extent(n))
+  for rank in ranks.values():
+    rank.sort()
+    for left, right in zip(rank, rank[1:]):
+      assert left[1] <= right[0] + 0.01, "nodes on a rank overlap"
+
+  for cluster in objects:
+    if "nodes" not in cluster or not cluster["name"].startswith("cluster"):
+      continue
+    x0, _, x1, _ = (float(c) for c in cluster["bb"].split(","))
+    for i in cluster.get("nodes", []):
+      left, right = extent(objects[i])
+      assert x0 - 0.01 <= left and right <= x1 + 0.01, \
+        "node is outside its cluster"
+
+def test_circo_crossings():
+  """
+  circo should find a crossing free order for an outerplanar block given with
+  its nodes and edges out of order
+  """
+
+  # a 12-cycle with nested chords, relabeled and shuffled
+  edges = [(8, 9), (1, 7), (6, 4), (9, 3), (6, 11), (7, 10), (11, 4), (0, 6),
+           (10, 0), (1, 2), (10, 6), (1, 10), (6, 2), (2, 9), (3, 1), (4, 5),
+           (5, 2), (1, 6), (2, 8), (4, 2)]
+  input = "graph {" + "".join(f"{a} -- {b};" for a, b in edges) + "}"
+
+  output = subprocess.check_output(["dot", "-Kcirco", "-Tjson"], input=input,
+    universal_newlines=True)
+  nodes = json.loads(output)["objects"]
+
+  # order the nodes around the circle by angle from its center
+  pos = [[float(c) for c in n["pos"].split(",")] for n in nodes]
+  cx = sum(x for x, _ in pos) / len(pos)
+  cy = sum(y for _, y in pos) / len(pos)
+  angles = {n["name"]: math.atan2(y - cy, x - cx)
+            for n, (x, y) in zip(nodes, pos)}
+  order = {name: i for i, name in enumerate(sorted(angles, key=angles.get))}
+
+  chords = [sorted((order[str(a)], order[str(b)])) for a, b in edges]
+  for (a, b), (c, d) in itertools.product(chords, repeat=2):
+    assert not a < c < b < d, "edges cross"
+
+def test_nswarm():
+  """
+  with `nswarm`, dot should start from the node positions of an earlier layout
+  and keep an order it has no reason to change
+  """
+  src = 'digraph { r -> x; r -> y; r [pos="50,100"]; x [pos="100,0"]; ' \
+        'y [pos="0,0"] }'
+
+  xs = {}
+  for warm in ("false", "true"):
+    plain = subprocess.check_output(["dot", f"-Gnswarm={warm}", "-Tplain"],
+                                    input=src, universal_newlines=True)
+    for line in plain.splitlines():
+      fields = line.split()
+      if fields[0] == "node":
+        xs[(warm, fields[1])] = float(fields[2])
+
+  assert xs[("false", "x")] < xs[("false", "y")], \
+    "pos should be ignored without nswarm"
+  assert xs[("true", "y")] < xs[("true", "x")], \
+    "nswarm should keep the order of the earlier layout"
+
+def test_nswarm_flat_label():
+  """
+  `nswarm` should cope with the extra rank dot adds above rank 0 for the label
+  of a flat edge between non-adjacent nodes
+  """
+  src = "digraph { { rank=same; a; m; b } a -> m -> b; " \
+        "a -> b [label=flat]; a -> c; b -> c }"
+
+  for _ in range(2):
+    src = subprocess.check_output(["dot", "-Gnswarm=true", "-Tdot"],
+                                  input=src, universal_newlines=True)
+    assert "lp=" in src, "the flat edge label should be placed"
+
+def test_sparse_pinned():
+  """
+  neato with `mode=sparse` should keep pinned nodes where they were put
+  """
+  src = 'graph { mode=sparse; a [pos="0,0!"]; b [pos="5,0!"]; ' \
+        'c [pos="2,4", pin=true]; a -- d -- e -- b; d -- c; e -- f }'
+  plain = subprocess.check_output(["dot", "-Kneato", "-Tplain"], input=src,
+                                  universal_newlines=True)
+
+  pos = {}
+  for line in plain.splitlines():
+    fields = line.split()
+    if fields[0] == "node":
+      pos[fields[1]] = (float(fields[2]), float(fields[3]))
+
+  # the drawing may be translated, so compare to a
+  ax, ay = pos["a"]
+  assert pos["b"] == pytest.approx((ax + 5, ay))
+  assert pos["c"] == pytest.approx((ax + 2, ay + 4))
+
+def test_sparse_path():
+  """
+  neato with `mode=sparse` should keep nodes that are not adjacent at their
+  graph distance, so a path is laid out straight
+  """
+  src = "graph { mode=sparse; " + \
+        " -- ".join(f"n{i}" for i in range(10)) + " }"
+  plain = subprocess.check_output(["dot", "-Kneato", "-Tplain"], input=src,
+                                  universal_newlines=True)
+
+  pos = {}
+  for line in plain.splitlines():
+    fields = line.split()
+    if fields[0] == "node":
+      pos[fields[1]] = (float(fields[2]), float(fields[3]))
+
+  # the ends of a path of nine unit length edges should be nine apart
+  assert math.dist(pos["n0"], pos["n9"]) == pytest.approx(9, rel=0.05)
+
+@pytest.mark.parametrize("engine,attr", [("sfdp", "-Gquadtree=normal"),
+                                         ("sfdp", "-Gquadtree=fast"),
+                                         ("neato", "-Gmode=major"),
+                                         ("neato", "-Gmode=sgd")])
+def test_threads(engine: str, attr: str):
+  """
+  a layout should come out the same in every run with the same `threads`, and
+  `threads=1` should be the default
+  """
+  src = "graph {" + "".join(f"{i} -- {i + 1}; {i} -- {i + 10};"
+                            for i in range(100)) + "}"
+
+  def layout(*args: str) -> str:
+    return subprocess.check_output(["dot", f"-K{engine}", "-Tplain", attr,
+                                    *args],
+                                   input=src, universal_newlines=True)
+
+  assert layout("-Gthreads=1") == layout(), \
+    "threads=1 should not change the layout"
+  assert layout("-Gthreads=3") == layout("-Gthreads=3"), \
+    "a threaded layout should not depend on the timing of its threads"
+
+def test_serve():
+  """
+  `dot --serve` should answer each request with exactly one framed reply
+  """
+
+  requests = b"13\ndigraph{a->b}13\ndigraph{c->d}4\n{{{{stats\n"
+  p = subprocess.run(["dot", "-Tplain", "--serve"], input=requests,
+                     stdout=subprocess.PIPE, check=True)
+
+  replies = []
+  out = p.stdout
+  while out:
+    header, out = out.split(b"\n", 1)
+    status, length = header.split()
+    replies.append((status, out[:int(length)]))
+    out = out[int(length):]
+
+  assert [s for s, _ in replies] == [b"ok", b"ok", b"error", b"ok"]
+  assert b"node a " in replies[0][1] and b"node c " not in replies[0][1]
+  assert b"node c " in replies[1][1]
+  assert b"requests 3\nfailures 1\n" in replies[3][1]
+
+def test_serve_crlf():
+  """
+  `dot --serve` should accept CRLF line ends on every request line
+  """
+  requests = b"13\r\ndigraph{a->b}stats\r\n"
+  p = subprocess.run(["dot", "-Tplain", "--serve"], input=requests,
+                     stdout=subprocess.PIPE, check=True)
+
+  header, rest = p.stdout.split(b"\n", 1)
+  assert header.split()[0] == b"ok"
+  rest = rest[int(header.split()[1]):]
+  assert rest.startswith(b"ok "), "stats should be answered"
+  assert b"requests 1\n" in rest
+
+@pytest.mark.parametrize("header", [b"-1\n", b" -1\n",
+                                    b"99999999999999999999999\n",
+                                    b"4294967296000\n"])
+def test_serve_bad_header(header: bytes):
+  """
+  `dot --serve` should reject request lengths that are negative, overflow or
+  are too large, without trying to read them
+  """
+  p = subprocess.run(["dot", "--serve"], input=header + b"digraph{}",
+                     stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+  assert p.returncode == 1
+  assert p.stdout == b""
+
+def test_serve_output_file():
+  """
+  `dot --serve` replies on stdout, so it should refuse -o
+  """
+  with tempfile.TemporaryDirectory() as tmp:
+    p = subprocess.run(["dot", "--serve", "-o", os.path.join(tmp, "out")],
+                       input=b"", stderr=subprocess.PIPE)
+  assert p.returncode != 0
+
 @pytest.mark.skipif(platform.system() != "Linux",
                     reason="TODO: make this test case portable")
 def test_xml_escape():
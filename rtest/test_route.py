@@ -0,0 +1,28 @@
+"""test ../lib/pathplan/route.c"""
+
+import os
+from pathlib import Path
+import platform
+import sys
+
+sys.path.append(os.path.dirname(__file__))
+from gvtest import run_c #pylint: disable=C0413
+
+def test_route():
+  """run the Proutespline unit tests"""
+
+  # locate the Proutespline unit tests
+  src = Path(__file__).parent.resolve() / "../lib/pathplan/test_route.c"
+  assert src.exists()
+
+  # locate lib directory that needs to be in the include path
+  lib = Path(__file__).parent.resolve() / "../lib"
+
+  # extra C flags this compilation needs
+  cflags = ['-I', lib]
+  if platform.system() != "Windows":
+    cflags += ["-lm"]
+
+  ret, _, _ = run_c(src, cflags=cflags)
+
+  assert ret == 0
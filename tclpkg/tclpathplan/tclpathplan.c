@@ -682,10 +682,10 @@ vgpanecmd(ClientData clientData, Tcl_Interp * interp, int argc,
 	    make_barriers(vgp, pp, qp, &barriers, &n_barriers);
 	    slopes[0].x = slopes[0].y = 0.0;
 	    slopes[1].x = slopes[1].y = 0.0;
-	    Proutespline(barriers, n_barriers, line, slopes, &spline);
-
-	    for (i = 0; i < spline.pn; i++) {
-		appendpoint(interp, spline.ps[i]);
+	    if (Proutespline(barriers, n_barriers, line, slopes, &spline) == 0) {
+		for (i = 0; i < spline.pn; i++) {
+		    appendpoint(interp, spline.ps[i]);
+		}
 	    }
 	}
 	return TCL_OK;
@@ -0,0 +1,81 @@
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <cgraph++/AGraph.h>
+#include <gvc++/GVContext.h>
+#include <gvc++/GVLayoutBatch.h>
+#include <gvc++/GVRenderData.h>
+
+TEST_CASE("A batch of graphs can be laid out and rendered in one call") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  const std::vector<std::shared_ptr<CGraph::AGraph>> graphs = {
+      std::make_shared<CGraph::AGraph>("digraph {a -> b}"),
+      std::make_shared<CGraph::AGraph>("graph {c -- d}"),
+  };
+
+  const auto results = GVC::layout_batch(gvc, graphs, "dot", "svg");
+
+  REQUIRE(results.size() == graphs.size());
+  for (const auto &result : results) {
+    REQUIRE(result.data != nullptr);
+    REQUIRE(!result.error);
+    REQUIRE(result.data->string_view().find("<!DOCTYPE svg") !=
+            std::string_view::npos);
+  }
+}
+
+TEST_CASE("A failure in one graph of a batch is reported for that graph only") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  // the middle graph names a layout engine that does not exist, so only its
+  // layout fails
+  const std::vector<std::shared_ptr<CGraph::AGraph>> graphs = {
+      std::make_shared<CGraph::AGraph>("digraph {a -> b}"),
+      std::make_shared<CGraph::AGraph>("digraph {layout=NO_SUCH_ENGINE; c}"),
+      std::make_shared<CGraph::AGraph>("graph {d -- e}"),
+  };
+
+  const auto results = GVC::layout_batch(gvc, graphs, "dot", "svg");
+
+  REQUIRE(results.size() == graphs.size());
+
+  REQUIRE(results[1].data == nullptr);
+  REQUIRE_THROWS_AS(std::rethrow_exception(results[1].error),
+                    std::runtime_error);
+
+  for (const auto i : {0, 2}) {
+    REQUIRE(results[i].data != nullptr);
+    REQUIRE(!results[i].error);
+    REQUIRE(results[i].data->string_view().find("<!DOCTYPE svg") !=
+            std::string_view::npos);
+  }
+}
+
+TEST_CASE("A rendering failure is reported for every graph of a batch") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  const std::vector<std::shared_ptr<CGraph::AGraph>> graphs = {
+      std::make_shared<CGraph::AGraph>("digraph {a}"),
+      std::make_shared<CGraph::AGraph>("digraph {b}"),
+  };
+
+  const auto results = GVC::layout_batch(gvc, graphs, "dot", "UNKNOWN_FORMAT");
+
+  REQUIRE(results.size() == graphs.size());
+  for (const auto &result : results) {
+    REQUIRE(result.data == nullptr);
+    REQUIRE_THROWS_AS(std::rethrow_exception(result.error),
+                      std::runtime_error);
+  }
+}
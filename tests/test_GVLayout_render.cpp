@@ -1,4 +1,6 @@
 #include <cstring>
+#include <string>
+#include <string_view>
 
 #include <catch2/catch.hpp>
 
@@ -37,3 +39,38 @@ TEST_CASE("Rendering in an unknown format throws an exception") {
 
   REQUIRE_THROWS_AS(layout.render("UNKNOWN_FORMAT"), std::runtime_error);
 }
+
+TEST_CASE("Rendering to a sink produces the same output as rendering to "
+          "memory") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  auto dot = "digraph {a -> b; b -> c; a -> c}";
+  auto g = std::make_shared<CGraph::AGraph>(dot);
+
+  const auto layout = GVC::GVLayout(gvc, g, "dot");
+
+  std::string streamed;
+  layout.render("svg", [&](std::string_view chunk) { streamed += chunk; });
+
+  const auto result = layout.render("svg");
+  REQUIRE(streamed == result.string_view());
+}
+
+TEST_CASE("An exception thrown by a render sink is propagated") {
+  const auto demand_loading = false;
+  auto gvc =
+      std::make_shared<GVC::GVContext>(lt_preloaded_symbols, demand_loading);
+
+  auto dot = "digraph {a}";
+  auto g = std::make_shared<CGraph::AGraph>(dot);
+
+  const auto layout = GVC::GVLayout(gvc, g, "dot");
+
+  REQUIRE_THROWS_AS(layout.render("svg",
+                                  [](std::string_view) {
+                                    throw std::logic_error("sink failed");
+                                  }),
+                    std::logic_error);
+}